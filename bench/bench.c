@@ -0,0 +1,528 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>  /* getrusage() */
+#define BENCH_HAVE_RUSAGE
+#endif
+
+#ifdef CJSON_NDJSON
+#include <unistd.h>  /* sysconf() */
+#endif
+
+#include "cjson.h"
+
+//性能测试：生成几类有代表性的文档，测量解析、生成、复制、比较的吞吐量、每个文档的分配次数和进程的峰值内存
+//用法：cjson-bench [--json] [--scale N] [--time 秒] [--threads N] [名字过滤]
+//--json 每个结果输出一行json，便于脚本比较；名字过滤只运行文档名或操作名包含该字符串的测试
+//--threads NDJSON测试的最大线程数，默认为CPU核数，线程数从1开始每次翻倍
+//比较性能时用 -DCMAKE_BUILD_TYPE=Release 构建，峰值内存是整个进程的，只会增加
+
+//计数分配器：只统计次数，直接转发给malloc/realloc/free；NDJSON测试会在多个线程中同时分配，计数用原子操作
+typedef struct
+{
+  atomic_size_t malloc_count, realloc_count, free_count;
+}bench_alloc_stats;
+
+static bench_alloc_stats alloc_stats;
+
+static void *bench_malloc(void *ud, size_t size)
+{
+  atomic_fetch_add_explicit(&((bench_alloc_stats *)ud)->malloc_count, 1, memory_order_relaxed);
+  return malloc(size);
+}
+
+static void *bench_realloc(void *ud, void *ptr, size_t size)
+{
+  atomic_fetch_add_explicit(&((bench_alloc_stats *)ud)->realloc_count, 1, memory_order_relaxed);
+  return realloc(ptr, size);
+}
+
+static void bench_free(void *ud, void *ptr)
+{
+  atomic_fetch_add_explicit(&((bench_alloc_stats *)ud)->free_count, 1, memory_order_relaxed);
+  free(ptr);
+}
+
+static size_t bench_alloc_count(void)
+{
+  return atomic_load(&alloc_stats.malloc_count) + atomic_load(&alloc_stats.realloc_count);
+}
+
+static double bench_now(void)
+{
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long bench_peak_rss_kb(void)  //整个进程到目前为止的峰值，不支持时返回0
+{
+#ifdef BENCH_HAVE_RUSAGE
+  struct rusage ru;
+  if(getrusage(RUSAGE_SELF, &ru) != 0)
+    return 0;
+#ifdef __APPLE__
+  return ru.ru_maxrss / 1024;   //macOS的单位是字节
+#else
+  return ru.ru_maxrss;
+#endif
+#else
+  return 0;
+#endif
+}
+
+//确定的伪随机数，每次运行生成相同的文档
+static unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+static unsigned rng(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (unsigned)(rng_state >> 16);
+}
+
+static double rng_double(double lo, double hi)
+{
+  return lo + (hi - lo) * (rng() / 4294967296.0);
+}
+
+//生成文档用的缓冲区
+typedef struct
+{
+  char *buf;
+  size_t len, cap;
+}bench_buffer;
+
+static void buffer_reserve(bench_buffer *b, size_t n)
+{
+  if(b->len + n + 1 > b->cap)
+  {
+    while(b->len + n + 1 > b->cap)
+      b->cap = b->cap ? b->cap * 2 : 4096;
+    b->buf = (char *)realloc(b->buf, b->cap);
+  }
+}
+
+static void buffer_puts(bench_buffer *b, const char *s)
+{
+  size_t n = strlen(s);
+  buffer_reserve(b, n);
+  memcpy(b->buf + b->len, s, n + 1);
+  b->len += n;
+}
+
+static void buffer_printf(bench_buffer *b, const char *fmt, ...)
+{
+  va_list ap;
+  int n;
+  va_start(ap, fmt);
+  n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  buffer_reserve(b, (size_t)n);
+  va_start(ap, fmt);
+  vsnprintf(b->buf + b->len, (size_t)n + 1, fmt, ap);
+  va_end(ap);
+  b->len += (size_t)n;
+}
+
+static void buffer_words(bench_buffer *b, int count)  //随机单词组成的句子，偶尔带转义和非ASCII字符
+{
+  static const char *words[] = {
+    "the", "json", "parser", "stream", "value", "cache", "latency", "throughput", "@user", "#tag",
+    "http://t.co/xYz", "caf\\u00e9", "\\u65e5\\u672c", "\\\"quoted\\\"", "line\\nbreak", "\xe2\x9c\x93"
+  };
+  for(int i = 0; i < count; i++)
+  {
+    if(i)
+      buffer_puts(b, " ");
+    buffer_puts(b, words[rng() % (sizeof(words) / sizeof(words[0]))]);
+  }
+}
+
+//类似twitter API的结果：对象中混合字符串、大整数、布尔和null，有嵌套的user和entities
+static void gen_twitter(bench_buffer *b, int scale)
+{
+  buffer_puts(b, "{\"statuses\":[");
+  for(int i = 0; i < 400 * scale; i++)
+  {
+    unsigned long long id = 505874924095815681ULL + rng();
+    buffer_printf(b, "%s{\"created_at\":\"Sun Aug 31 00:29:%02u +0000 2014\",\"id\":%llu,\"id_str\":\"%llu\",\"text\":\"",
+                  i ? "," : "", rng() % 60, id, id);
+    buffer_words(b, 5 + rng() % 20);
+    buffer_printf(b, "\",\"truncated\":false,\"in_reply_to_status_id\":null,\"user\":{\"id\":%u,\"name\":\"user %u\","
+                  "\"screen_name\":\"u%u\",\"location\":\"\",\"description\":\"", rng(), rng() % 1000, rng());
+    buffer_words(b, rng() % 12);
+    buffer_printf(b, "\",\"followers_count\":%u,\"friends_count\":%u,\"verified\":%s,\"lang\":\"ja\"},"
+                  "\"entities\":{\"hashtags\":[", rng() % 100000, rng() % 5000, rng() % 2 ? "true" : "false");
+    for(unsigned k = 0, n = rng() % 3; k < n; k++)
+      buffer_printf(b, "%s{\"text\":\"tag%u\",\"indices\":[%u,%u]}", k ? "," : "", rng() % 100, k * 10, k * 10 + 5);
+    buffer_printf(b, "],\"urls\":[],\"user_mentions\":[]},\"retweet_count\":%u,\"favorite_count\":%u,\"favorited\":false,"
+                  "\"retweeted\":false,\"geo\":null,\"coordinates\":null,\"lang\":\"en\"}", rng() % 1000, rng() % 1000);
+  }
+  buffer_puts(b, "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"count\":100}}");
+}
+
+//类似canada.json的GeoJSON：几乎全部是坐标浮点数
+static void gen_canada(bench_buffer *b, int scale)
+{
+  buffer_puts(b, "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},"
+                 "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[");
+  for(int i = 0; i < 40 * scale; i++)
+  {
+    double lon = rng_double(-141.0, -52.0), lat = rng_double(41.0, 83.0);
+    buffer_puts(b, i ? ",[" : "[");
+    for(int k = 0; k < 500; k++)
+    {
+      lon += rng_double(-0.01, 0.01);
+      lat += rng_double(-0.01, 0.01);
+      buffer_printf(b, "%s[%.15g,%.15g]", k ? "," : "", lon, lat);
+    }
+    buffer_puts(b, "]");
+  }
+  buffer_puts(b, "]}}]}");
+}
+
+//类似citm_catalog.json：key很多的对象，key是数字字符串，值是小对象和整数数组
+static void gen_citm(bench_buffer *b, int scale)
+{
+  int n = 2000 * scale;
+  buffer_puts(b, "{\"areaNames\":{");
+  for(int i = 0; i < 200; i++)
+    buffer_printf(b, "%s\"%d\":\"area %d\"", i ? "," : "", 205705993 + i, i);
+  buffer_puts(b, "},\"events\":{");
+  for(int i = 0; i < n; i++)
+  {
+    int id = 138586341 + i;
+    buffer_printf(b, "%s\"%d\":{\"description\":null,\"id\":%d,\"logo\":\"/images/UE0AAAAACEKo6QAAAAVDSVRN\",\"name\":\"event %d\","
+                  "\"subTopicIds\":[337184269,337184283],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[324846099,107888604]}",
+                  i ? "," : "", id, id, i);
+  }
+  buffer_puts(b, "},\"performances\":[");
+  for(int i = 0; i < n; i++)
+  {
+    buffer_printf(b, "%s{\"eventId\":%d,\"id\":%d,\"logo\":null,\"name\":null,\"prices\":[{\"amount\":%u,\"audienceSubCategoryId\":337100890,"
+                  "\"seatCategoryId\":338937295}],\"seatCategories\":[{\"areas\":[{\"areaId\":205705999,\"blockIds\":[]},"
+                  "{\"areaId\":205706007,\"blockIds\":[]}],\"seatCategoryId\":338937295}],\"seatMapImage\":null,"
+                  "\"start\":1372616400000,\"venueCode\":\"PLEYEL_PLEYEL\"}", i ? "," : "", 138586341 + i, 339887544 + i, 9000 + rng() % 90000);
+  }
+  buffer_puts(b, "]}");
+}
+
+//很深的嵌套：数组和对象交替，每层还有一个兄弟元素
+static void gen_nested(bench_buffer *b, int scale)
+{
+  buffer_puts(b, "[");
+  for(int r = 0; r < 20 * scale; r++)
+  {
+    int depth = 500 + rng() % 400;
+    if(r)
+      buffer_puts(b, ",");
+    for(int i = 0; i < depth; i++)
+      buffer_puts(b, i % 2 ? "{\"k\":1,\"v\":" : "[true,");
+    buffer_puts(b, "\"leaf\"");
+    for(int i = depth - 1; i >= 0; i--)
+      buffer_puts(b, i % 2 ? "}" : "]");
+  }
+  buffer_puts(b, "]");
+}
+
+//少量很长的字符串，大部分是普通字符，夹杂转义
+static void gen_huge_string(bench_buffer *b, int scale)
+{
+  buffer_puts(b, "[");
+  for(int s = 0; s < 4 * scale; s++)
+  {
+    buffer_puts(b, s ? ",\"" : "\"");
+    for(int i = 0; i < 256 * 1024; i++)
+    {
+      unsigned r = rng() % 256;
+      if(r == 0)
+        buffer_puts(b, "\\n");
+      else if(r == 1)
+        buffer_puts(b, "\\u00e9");
+      else if(r == 2)
+        buffer_puts(b, "\\\"");
+      else
+      {
+        buffer_reserve(b, 1);
+        b->buf[b->len++] = (char)('a' + r % 26);
+        b->buf[b->len] = '\0';
+      }
+    }
+    buffer_puts(b, "\"");
+  }
+  buffer_puts(b, "]");
+}
+
+#ifdef CJSON_NDJSON
+//日志一类的NDJSON：每行一个不大的对象
+static void gen_logs(bench_buffer *b, int scale)
+{
+  static const char *levels[] = { "debug", "info", "info", "info", "warn", "error" };
+  for(int i = 0; i < 20000 * scale; i++)
+  {
+    buffer_printf(b, "{\"ts\":%u,\"level\":\"%s\",\"host\":\"web-%02u\",\"path\":\"/api/v1/items/%u\",\"status\":%u,"
+                  "\"latency_ms\":%.3f,\"msg\":\"", 1700000000u + i, levels[rng() % 6], rng() % 32, rng() % 100000,
+                  rng() % 8 ? 200 : 500, rng_double(0.1, 250.0));
+    buffer_words(b, 3 + rng() % 10);
+    buffer_printf(b, "\",\"tags\":[\"t%u\",\"t%u\"],\"user\":{\"id\":%u,\"admin\":%s},\"trace\":null}\n",
+                  rng() % 50, rng() % 50, rng(), rng() % 10 ? "false" : "true");
+  }
+}
+#endif
+
+typedef struct
+{
+  const char *name;
+  void (*generate)(bench_buffer *b, int scale);
+}bench_corpus;
+
+static const bench_corpus corpora[] = {
+  { "twitter", gen_twitter },
+  { "canada", gen_canada },
+  { "citm", gen_citm },
+  { "nested", gen_nested },
+  { "huge_string", gen_huge_string },
+};
+
+//每个操作运行一次，计时只包括操作本身，准备和清理放在计时之外
+typedef enum
+{
+  OP_PARSE,
+  OP_PARSE_INDEXED,
+  OP_TAPE_PARSE,
+  OP_STRINGIFY,
+  OP_COPY,
+  OP_EQUAL,
+  OP_PARSE_LINES,   //NDJSON：逐行调用cjson_parse_n()，作为多线程解析的基准
+  OP_NDJSON
+}bench_op;
+
+static const char *op_names[] = { "parse", "parse_indexed", "tape_parse", "stringify", "copy", "equal", "parse_lines", "ndjson" };
+
+typedef struct
+{
+  const char *json;
+  size_t len;
+  cjson_value doc, doc2;   //解析好的文档和它的副本，用于生成、复制、比较
+  size_t threads;          //NDJSON的线程数
+  int ordered;
+}bench_input;
+
+static int parse_lines(const char *p, const char *end)
+{
+  while(p < end)
+  {
+    const char *eol = (const char *)memchr(p, '\n', end - p);
+    cjson_value v;
+    if(eol == NULL)
+      eol = end;
+    cjson_value_init(&v);
+    if(cjson_parse_n(&v, p, eol - p) != CJSON_OK)
+      return 0;
+    cjson_value_free(&v);
+    p = eol + 1;
+  }
+  return 1;
+}
+
+#ifdef CJSON_NDJSON
+static int ndjson_check(void *ud, cjson_ndjson_record *record)  //无序时在多个线程中同时调用，只检查解析结果
+{
+  (void)ud;
+  return record->status == CJSON_OK;
+}
+#endif
+
+static double run_once(bench_op op, bench_input *in)
+{
+  cjson_value v;
+  cjson_tape *tape = NULL;
+  char *s = NULL;
+  double t;
+  int ok = 1;
+
+  cjson_value_init(&v);
+  t = bench_now();
+  switch(op)
+  {
+    case OP_PARSE:         ok = cjson_parse_n(&v, in->json, in->len) == CJSON_OK; break;
+    case OP_PARSE_INDEXED: ok = cjson_parse_indexed(&v, in->json, in->len) == CJSON_OK; break;
+    case OP_TAPE_PARSE:    ok = cjson_tape_parse(&tape, in->json, in->len) == CJSON_OK; break;
+    case OP_STRINGIFY:     s = cjson_stringify(in->doc, NULL); break;
+    case OP_COPY:          cjson_copy(&v, &in->doc); break;
+    case OP_EQUAL:         ok = cjson_is_equal(&in->doc, &in->doc2); break;
+    case OP_PARSE_LINES:   ok = parse_lines(in->json, in->json + in->len); break;
+    case OP_NDJSON:
+#ifdef CJSON_NDJSON
+    {
+      cjson_ndjson_options opt = { in->threads, 0, in->ordered };
+      ok = cjson_ndjson_parse(in->json, in->len, &opt, ndjson_check, NULL) == CJSON_OK;
+    }
+#endif
+      break;
+  }
+  t = bench_now() - t;
+  if(!ok)
+  {
+    fprintf(stderr, "%s failed\n", op_names[op]);
+    exit(1);
+  }
+  cjson_value_free(&v);
+  cjson_tape_free(tape);
+  cjson_free(s);
+  return t;
+}
+
+static int json_output = 0;
+
+static void bench_run(const char *corpus, const char *name, bench_op op, bench_input *in, double min_time)
+{
+  double total = 0, best = 1e30;
+  size_t iterations = 0, allocs;
+  long rss;
+
+  run_once(op, in);   //预热
+  allocs = bench_alloc_count();
+  run_once(op, in);
+  allocs = bench_alloc_count() - allocs;
+  while(iterations < 3 || total < min_time)
+  {
+    double t = run_once(op, in);
+    total += t;
+    if(t < best)
+      best = t;
+    iterations++;
+  }
+  rss = bench_peak_rss_kb();
+
+  if(json_output)
+    printf("{\"corpus\":\"%s\",\"op\":\"%s\",\"bytes\":%zu,\"iterations\":%zu,\"mean_ms\":%.4f,\"best_ms\":%.4f,"
+           "\"mb_per_s\":%.2f,\"docs_per_s\":%.2f,\"allocs_per_doc\":%zu,\"peak_rss_kb\":%ld}\n",
+           corpus, name, in->len, iterations, total / iterations * 1e3, best * 1e3,
+           in->len / (total / iterations) / 1e6, iterations / total, allocs, rss);
+  else
+    printf("%-12s %-14s %10.1f %12.1f %10.2f %14zu %12ld\n",
+           corpus, name, in->len / (total / iterations) / 1e6, iterations / total, total / iterations * 1e3, allocs, rss);
+  fflush(stdout);
+}
+
+#ifdef CJSON_NDJSON
+static void bench_logs(bench_buffer *b, bench_input *in, const char *filter, const char *name, bench_op op, int scale, double min_time)
+{
+  if(filter != NULL && strstr("logs", filter) == NULL && strstr(name, filter) == NULL)
+    return;
+  if(b->buf == NULL)   //第一次用到时才生成
+  {
+    gen_logs(b, scale);
+    in->json = b->buf;
+    in->len = b->len;
+  }
+  bench_run("logs", name, op, in, min_time);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+  const cjson_allocator counting = { bench_malloc, bench_realloc, bench_free, &alloc_stats };
+  const char *filter = NULL;
+  double min_time = 0.5;
+  int scale = 1;
+  size_t max_threads = 0;
+
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "--json") == 0)
+      json_output = 1;
+    else if(strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+      scale = atoi(argv[++i]);
+    else if(strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+      min_time = atof(argv[++i]);
+    else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      max_threads = (size_t)atoi(argv[++i]);
+    else if(argv[i][0] != '-')
+      filter = argv[i];
+    else
+    {
+      fprintf(stderr, "usage: %s [--json] [--scale N] [--time seconds] [--threads N] [filter]\n", argv[0]);
+      return 2;
+    }
+  }
+  if(scale < 1)
+    scale = 1;
+
+  cjson_set_allocator(&counting);
+  if(!json_output)
+    printf("%-12s %-14s %10s %12s %10s %14s %12s\n", "corpus", "op", "MB/s", "docs/s", "ms/doc", "allocs/doc", "peak_rss_kb");
+
+  for(size_t c = 0; c < sizeof(corpora) / sizeof(corpora[0]); c++)
+  {
+    bench_buffer b = { NULL, 0, 0 };
+    bench_input in;
+    int any = 0;
+
+    for(int op = OP_PARSE; op <= OP_EQUAL; op++)
+      any |= filter == NULL || strstr(corpora[c].name, filter) != NULL || strstr(op_names[op], filter) != NULL;
+    if(!any)
+      continue;
+
+    corpora[c].generate(&b, scale);
+    in.json = b.buf;
+    in.len = b.len;
+    cjson_value_init(&in.doc);
+    cjson_value_init(&in.doc2);
+    if(cjson_parse_n(&in.doc, in.json, in.len) != CJSON_OK)
+    {
+      fprintf(stderr, "%s: generated document does not parse\n", corpora[c].name);
+      return 1;
+    }
+    cjson_copy(&in.doc2, &in.doc);
+
+    for(int op = OP_PARSE; op <= OP_EQUAL; op++)
+      if(filter == NULL || strstr(corpora[c].name, filter) != NULL || strstr(op_names[op], filter) != NULL)
+        bench_run(corpora[c].name, op_names[op], (bench_op)op, &in, min_time);
+
+    cjson_value_free(&in.doc);
+    cjson_value_free(&in.doc2);
+    free(b.buf);
+  }
+
+#ifdef CJSON_NDJSON
+  //NDJSON：逐行串行解析和1、2、4...个线程并行解析的吞吐量，最后是最多线程时的有序回调
+  {
+    bench_buffer b = { NULL, 0, 0 };
+    bench_input in;
+    char name[48];   //前缀加上最长20位的size_t
+
+    if(max_threads == 0)
+    {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      max_threads = n > 0 ? (size_t)n : 1;
+    }
+    memset(&in, 0, sizeof(in));
+    bench_logs(&b, &in, filter, "parse_lines", OP_PARSE_LINES, scale, min_time);
+    for(size_t t = 1; ; t = t * 2 < max_threads ? t * 2 : max_threads)
+    {
+      in.threads = t;
+      snprintf(name, sizeof(name), "ndjson_t%zu", t);
+      bench_logs(&b, &in, filter, name, OP_NDJSON, scale, min_time);
+      if(t == max_threads)
+        break;
+    }
+    in.ordered = 1;
+    snprintf(name, sizeof(name), "ndjson_ord_t%zu", max_threads);
+    bench_logs(&b, &in, filter, name, OP_NDJSON, scale, min_time);
+    free(b.buf);
+  }
+#else
+  (void)max_threads;
+#endif
+  cjson_set_allocator(NULL);
+  return 0;
+}
@@ -19,11 +19,21 @@ typedef enum{
   CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET,   //数组缺少 ',' 或者 ']'
   CJSON_ERR_OBJECT_NEED_KEY,                      //对象缺少key
   CJSON_ERR_OBJECT_NEED_COLON,                    //对象缺少冒号
-  CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET   //对象缺少 ',' 或者 '}'
+  CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET,  //对象缺少 ',' 或者 '}'
+  CJSON_ERR_SAX_ABORT,                            //SAX或NDJSON回调返回0，解析中止
+  CJSON_ERR_SINK,                                 //写出函数返回失败
+  CJSON_ERR_DEPTH,                                //数组和对象的嵌套层数超过限制
+  CJSON_ERR_IO                                    //文件打开或映射失败
 }CJSON_STATUS;
 
 #define CJSON_KEY_NOT_EXIST  ((size_t)-1)
 
+#define CJSON_FLAG_ARENA  (0x01)   //值(以及它的所有子节点)的内存属于arena，由arena统一释放
+#define CJSON_FLAG_INSITU (0x02)   //字符串(对象的key)指向原地解析的输入缓冲区，不归该值所有
+#define CJSON_FLAG_INT64  (0x04)   //数字以u.i64精确保存
+#define CJSON_FLAG_UINT64 (0x08)   //数字以u.u64精确保存，只用于大于INT64_MAX的数
+#define CJSON_FLAG_LAZY   (0x10)   //数组或对象还没有解析，u.lazy记录它在输入中的片段，第一次访问时解析
+
 typedef enum{
   CJSON_NULL,
   CJSON_TRUE,
@@ -35,12 +45,17 @@ typedef enum{
 }cjson_type;
 
 typedef struct cjson_member__ cjson_member;
+typedef struct cjson_object_index__ cjson_object_index;
+typedef struct cjson_lazy__ cjson_lazy;
 typedef struct cjson_value__
 {
   cjson_type type;
+  unsigned int flags;   //CJSON_FLAG_*
   union
   {
     double num;
+    int64_t i64;  //整数，见 CJSON_FLAG_INT64/CJSON_FLAG_UINT64
+    uint64_t u64;
 
     struct
     {
@@ -60,7 +75,10 @@ typedef struct cjson_value__
       cjson_member *members;
       size_t size;  //成员个数
       size_t capacity;  //动态数组容量
+      cjson_object_index *index;   //成员较多时建立的哈希索引，没有时为NULL
     }obj;
+
+    cjson_lazy *lazy;   //见 CJSON_FLAG_LAZY
   }u;
 }cjson_value;
 
@@ -73,26 +91,106 @@ struct cjson_member__
 };
 
 
+//内存分配器，库中所有的节点、字符串和临时栈都通过它分配
+typedef struct
+{
+  void *(*malloc_fn)(void *ud, size_t size);
+  void *(*realloc_fn)(void *ud, void *ptr, size_t size);
+  void (*free_fn)(void *ud, void *ptr);
+  void *ud;   //用户数据，原样传给上面三个函数
+}cjson_allocator;
+
+void cjson_set_allocator(const cjson_allocator *allocator);   //设置全局分配器(复制一份)，NULL恢复为malloc/realloc/free，需在使用其他接口之前调用
+const cjson_allocator *cjson_get_allocator(void);
+void cjson_free(void *ptr);   //用全局分配器释放cjson_stringify()返回的字符串
 
+//解析、生成、复制、比较和释放都不递归，任意深的树都不会耗尽线程栈
+//解析时数组和对象最多嵌套CJSON_MAX_DEPTH层(默认1024，可以在编译时定义)，超过时返回CJSON_ERR_DEPTH
 CJSON_STATUS cjson_parse(cjson_value *v, const char *json);
+CJSON_STATUS cjson_parse_n(cjson_value *v, const char *json, size_t len);  //按长度解析，json不需要以'\0'结尾
+//出错的位置，行列从1开始，列按字节计算
+typedef struct
+{
+  CJSON_STATUS status;
+  size_t offset;        //出错处在输入中的字节偏移
+  size_t line, column;
+  char context[41];     //出错处前后最多各20字节的片段，以'\0'结尾，控制字符替换为空格
+  size_t context_offset;  //出错处在context中的位置
+}cjson_parse_error;
+
+//和cjson_parse_n()相同，出错时把位置写入error(可以为NULL)，行列和片段只在出错时才计算
+CJSON_STATUS cjson_parse_ex(cjson_value *v, const char *json, size_t len, cjson_parse_error *error);
+//原地解析，字符串和key直接解码到json缓冲区中并指向它，缓冲区必须可写且比解析出的值活得久，解析之后内容被改写
+CJSON_STATUS cjson_parse_insitu(cjson_value *v, char *json, size_t len);
+//两阶段解析：先用SIMD一次找出整个输入中所有结构字符、字符串和值的位置，再按这些位置建立树，跳过空白和字符串时不再逐字节扫描
+//结果和错误码都和cjson_parse_n()相同；只对空白多的缩进格式化文档更快，紧凑的文档和带很多转义的长字符串比cjson_parse_n()慢
+//需要每个位置4字节的临时内存
+CJSON_STATUS cjson_parse_indexed(cjson_value *v, const char *json, size_t len);
+//延迟解析，只找出最外层数组或对象的结尾，内容在第一次通过接口访问时才解析，每次只解析一层，里面的数组和对象同样延迟
+//json缓冲区必须比解析出的值活得久；一开始只检查括号匹配和字符串结束，其他语法错误在访问时才发现，出错的一层按空容器处理
+//只读的接口(取值、比较、哈希、生成)也会在第一次访问时解析并写入缓存，没有加锁，延迟解析的树不能同时在多个线程中访问
+//需要在多个线程中共享时先在一个线程中对要访问的每一层调用cjson_lazy_load()，或者用cjson_copy()复制成普通的树
+CJSON_STATUS cjson_parse_lazy(cjson_value *v, const char *json, size_t len);
+int cjson_is_lazy(cjson_value value);   //是否还没有解析
+CJSON_STATUS cjson_lazy_load(cjson_value *v);   //立即解析v这一层，返回解析的结果，不是延迟解析的值直接返回CJSON_OK
 char *cjson_stringify(cjson_value v, size_t *length);
 
+#ifdef CJSON_STATS
+//解析统计，只在编译时定义了CJSON_STATS(CMake选项CJSON_STATS)才有，否则解析过程中完全没有统计的代码
+//每次解析开始时清零；出错时只统计到出错的位置；延迟解析的片段不统计
+typedef struct
+{
+  size_t nodes[7];      //按cjson_type统计的值的个数(对象的key不算)
+  size_t max_depth;     //数组和对象的最大嵌套层数
+  size_t string_bytes;  //字符串和key解码后的总字节数
+  size_t escapes;       //解码的转义序列个数，代理对算一个
+  size_t stack_size;    //临时栈的最大字节数
+  size_t stack_reallocs;  //临时栈扩容的次数
+  size_t heap_bytes;    //为结果申请的字节数：数组、对象成员、key、字符串和对象索引
+}cjson_parse_stats;
+
+CJSON_STATUS cjson_parse_with_stats(cjson_parse_stats *stats, cjson_value *v, const char *json, size_t len);
+#endif
+
+//指定分配器的版本，得到的值只能用同一个分配器复制和释放，不能再用其他接口增删元素(它们使用全局分配器)
+CJSON_STATUS cjson_parse_with_allocator(const cjson_allocator *allocator, cjson_value *v, const char *json, size_t len);
+char *cjson_stringify_with_allocator(const cjson_allocator *allocator, cjson_value v, size_t *length);
+void cjson_copy_with_allocator(const cjson_allocator *allocator, cjson_value *dest, const cjson_value *src);
+void cjson_value_free_with_allocator(const cjson_allocator *allocator, cjson_value *value);
+
+//生成选项，全部为0时和cjson_stringify()的紧凑输出相同
+typedef struct
+{
+  unsigned int indent;  //每层缩进的空格数，大于0时每个元素单独一行，冒号后加一个空格
+  int crlf;             //换行使用"\r\n"，否则使用"\n"
+  int sort_keys;        //对象的key按字节序排序输出，相同的key保持原来的顺序
+  int ascii_only;       //非ASCII字符输出为\uXXXX(必要时为代理对)，无效的UTF-8字节输出为\uFFFD
+}cjson_stringify_options;
+
+char *cjson_stringify_ex(cjson_value v, const cjson_stringify_options *options, size_t *length);  //options为NULL时使用默认选项
+
 void cjson_value_free(cjson_value *value);
-#define cjson_value_init(v) do { (v)->type = CJSON_NULL; } while(0)
-int cjson_is_equal(const cjson_value* lhs, const cjson_value* rhs);
+#define cjson_value_init(v) do { (v)->type = CJSON_NULL; (v)->flags = 0; } while(0)
+int cjson_is_equal(const cjson_value* lhs, const cjson_value* rhs);  //对象中有重复key时按第一个比较
+size_t cjson_hash(const cjson_value *v);  //结构哈希，相等的值(对象没有重复key时)哈希一定相同，哈希不同可以直接判断不相等
 void cjson_copy(cjson_value *dest, const cjson_value *src);
 void cjson_move(cjson_value *dest, cjson_value *src);
 void cjson_swap(cjson_value *dest, cjson_value *src);
 
 cjson_type cjson_get_type(cjson_value value);
 
-#define cjson_set_null(v) cjson_value_init(v)
+#define cjson_set_null(v) cjson_value_free(v)   //释放之后就是null
 
 int cjson_get_boolean(cjson_value value);
 void cjson_set_boolean(cjson_value *value, int bool);
 
 double cjson_get_number(cjson_value value);
 void cjson_set_number(cjson_value *value, double num);
+int cjson_is_integer(cjson_value value);  //数字是否以int64/uint64精确保存
+int64_t cjson_get_int64(cjson_value value);
+void cjson_set_int64(cjson_value *value, int64_t num);
+uint64_t cjson_get_uint64(cjson_value value);
+void cjson_set_uint64(cjson_value *value, uint64_t num);
 
 size_t cjson_get_string_length(cjson_value value);
 char* cjson_get_string(cjson_value value);
@@ -116,12 +214,162 @@ const char *cjson_get_object_key(cjson_value value, size_t index);
 size_t cjson_get_object_key_length(cjson_value value, size_t index);
 cjson_value *cjson_get_object_value(cjson_value value, size_t index);
 void cjson_init_object(cjson_value *value, size_t cap);
-cjson_value *cjson_set_object_value(cjson_value *value, const char* key, size_t klen);
+cjson_value *cjson_set_object_value(cjson_value *value, const char* key, size_t klen);  //key已经存在时返回原来的值
 size_t cjson_find_object_index(cjson_value value, const char* key, size_t klen);
 cjson_value *cjson_find_object_value(cjson_value value, const char* key, size_t klen);
 void cjson_remove_object_value(cjson_value *value, size_t index);
 void cjson_clear_object(cjson_value *value);
 void cjson_shrink_object(cjson_value *value);
 
+//JSON Pointer(RFC 6901)，路径编译一次之后可以反复使用，查找时不再解析路径，对象有索引时每层是O(1)
+//编译使用当时的全局分配器，路径格式错误时返回NULL；空路径""表示整个文档
+typedef struct cjson_pointer__ cjson_pointer;
+cjson_pointer *cjson_pointer_compile(const char *path, size_t len);
+void cjson_pointer_free(cjson_pointer *pointer);
+cjson_value *cjson_pointer_get(const cjson_pointer *pointer, const cjson_value *root);  //不存在时返回NULL
+//返回路径指向的位置，由调用者赋值：已经存在时返回原来的值，否则在对象中添加key，或者在数组末尾添加元素(下标等于数组大小或者为"-")
+//中间的节点不存在时返回NULL
+cjson_value *cjson_pointer_set(const cjson_pointer *pointer, cjson_value *root);
+int cjson_pointer_remove(const cjson_pointer *pointer, cjson_value *root);   //删除成功返回1，不存在返回0，不能删除整个文档
+
+//tape：只读的扁平表示，整个文档是一段连续的64位字加上一块字符串区，整体一次释放
+//访问接口和cjson_get_*对应，值用cjson_tape_value(所在的tape和位置)表示，按值传递，tape释放之后失效
+//数组和对象按下标访问都是O(1)，对象按key查找是线性的
+typedef struct cjson_tape__ cjson_tape;
+typedef struct
+{
+  const cjson_tape *tape;
+  size_t pos;
+}cjson_tape_value;
+
+CJSON_STATUS cjson_tape_parse(cjson_tape **tape, const char *json, size_t len);  //直接解析为tape，不构造cjson_value树，出错时*tape为NULL
+cjson_tape *cjson_tape_from_value(const cjson_value *v);
+void cjson_tape_to_value(cjson_tape_value value, cjson_value *dest);  //把value这棵子树转换为cjson_value，dest原来的值被释放
+void cjson_tape_free(cjson_tape *tape);
+cjson_tape_value cjson_tape_root(const cjson_tape *tape);
+
+cjson_type cjson_tape_get_type(cjson_tape_value value);
+int cjson_tape_get_boolean(cjson_tape_value value);
+double cjson_tape_get_number(cjson_tape_value value);
+int cjson_tape_is_integer(cjson_tape_value value);
+int64_t cjson_tape_get_int64(cjson_tape_value value);
+uint64_t cjson_tape_get_uint64(cjson_tape_value value);
+size_t cjson_tape_get_string_length(cjson_tape_value value);
+const char *cjson_tape_get_string(cjson_tape_value value);   //以'\0'结尾
+size_t cjson_tape_get_array_size(cjson_tape_value value);
+cjson_tape_value cjson_tape_get_array_element(cjson_tape_value value, size_t index);
+size_t cjson_tape_get_object_size(cjson_tape_value value);
+const char *cjson_tape_get_object_key(cjson_tape_value value, size_t index);
+size_t cjson_tape_get_object_key_length(cjson_tape_value value, size_t index);
+cjson_tape_value cjson_tape_get_object_value(cjson_tape_value value, size_t index);
+size_t cjson_tape_find_object_index(cjson_tape_value value, const char *key, size_t klen);  //不存在时返回CJSON_KEY_NOT_EXIST
+
+//可重用的解析器，临时栈在多次调用之间保留，避免每次解析都申请、扩容、释放
+//节点和字符串使用创建时的全局分配器(或设置的arena)分配，不能同时在多个线程中使用
+typedef struct cjson_parser__ cjson_parser;
+typedef struct cjson_arena__ cjson_arena;
+cjson_parser *cjson_parser_create(size_t stack_size);  //stack_size为初始栈大小，0使用默认大小
+void cjson_parser_destroy(cjson_parser *parser);
+void cjson_parser_reset(cjson_parser *parser);   //把栈恢复到初始大小
+void cjson_parser_set_trim(cjson_parser *parser, size_t trim_size);  //栈超过trim_size字节时收缩回初始大小，0表示从不收缩
+void cjson_parser_set_arena(cjson_parser *parser, cjson_arena *arena); //之后解析出的值从arena中分配，NULL取消
+void cjson_parser_set_max_depth(cjson_parser *parser, size_t max_depth);  //解析时的最大嵌套层数，0恢复默认值CJSON_MAX_DEPTH
+void cjson_parser_set_indexed(cjson_parser *parser, int indexed);  //不为0时parse和parse_insitu使用两阶段解析，结构索引的内存在多次调用之间保留
+#ifdef CJSON_STATS
+void cjson_parser_set_stats(cjson_parser *parser, cjson_parse_stats *stats);  //之后每次parse和parse_insitu把统计写入stats，NULL取消
+#endif
+size_t cjson_parser_get_stack_size(const cjson_parser *parser);
+CJSON_STATUS cjson_parser_parse(cjson_parser *parser, cjson_value *v, const char *json, size_t len);
+CJSON_STATUS cjson_parser_parse_insitu(cjson_parser *parser, cjson_value *v, char *json, size_t len);
+const char *cjson_parser_stringify(cjson_parser *parser, const cjson_value *v, size_t *length);  //返回的字符串在parser的栈中，下一次使用parser之前有效，不需要释放
+
+//arena：所有节点和字符串从大块内存中顺序分配，整棵树一次性释放
+//arena中的值调用cjson_value_free()不会释放内存，数组和对象不能再增删元素
+cjson_arena *cjson_arena_create(size_t block_size);   //block_size为0时使用默认块大小
+void cjson_arena_reset(cjson_arena *arena);           //释放arena中所有的值，保留一个内存块供下次使用
+void cjson_arena_destroy(cjson_arena *arena);
+CJSON_STATUS cjson_arena_parse(cjson_arena *arena, cjson_value *v, const char *json, size_t len);
+void cjson_arena_copy(cjson_arena *arena, cjson_value *dest, const cjson_value *src);
+void cjson_arena_set_string(cjson_arena *arena, cjson_value *value, const char *buf, size_t len);
+
+//SAX接口：解析时依次调用回调，不构造cjson_value树，也不为节点申请内存
+//回调返回0时中止解析并返回CJSON_ERR_SAX_ABORT，为NULL的回调直接跳过
+//字符串和key指向解析器的临时栈，不以'\0'结尾，只在回调中有效；数字以cjson_value传入，可以用cjson_get_int64()等读取
+//出错时之前的回调已经发生，调用者需要自己丢弃已经收到的数据
+typedef struct
+{
+  int (*null_fn)(void *ud);
+  int (*boolean_fn)(void *ud, int b);
+  int (*number_fn)(void *ud, const cjson_value *num);
+  int (*string_fn)(void *ud, const char *str, size_t len);
+  int (*key_fn)(void *ud, const char *key, size_t len);
+  int (*start_object_fn)(void *ud);
+  int (*end_object_fn)(void *ud, size_t size);  //size为成员个数
+  int (*start_array_fn)(void *ud);
+  int (*end_array_fn)(void *ud, size_t size);   //size为元素个数
+  void *ud;   //用户数据，原样传给所有回调
+}cjson_handler;
+
+CJSON_STATUS cjson_sax_parse(const cjson_handler *handler, const char *json, size_t len);
+CJSON_STATUS cjson_parser_sax(cjson_parser *parser, const cjson_handler *handler, const char *json, size_t len);  //使用parser的栈，多次调用不再申请内存
+
+//写出：生成的json先放在固定大小的缓冲区中，满了就交给sink，不在内存中保存整个文档
+//sink写出len字节，成功返回非0，失败之后所有写出接口都返回CJSON_ERR_SINK
+typedef int (*cjson_sink_fn)(void *ud, const char *data, size_t len);
+CJSON_STATUS cjson_stringify_to_sink(const cjson_value *v, cjson_sink_fn sink, void *ud);
+
+//事件写出器，不需要先构造cjson_value树；逗号和冒号自动添加，对象中key和值必须交替写出
+//根层可以写多个值，以'\n'分隔；写完之后调用flush把缓冲区中剩下的内容写出
+typedef struct cjson_writer__ cjson_writer;
+cjson_writer *cjson_writer_create(cjson_sink_fn sink, void *ud, size_t buffer_size);  //使用创建时的全局分配器，buffer_size为0时使用默认大小
+void cjson_writer_destroy(cjson_writer *writer);   //不会写出缓冲区中剩下的内容
+CJSON_STATUS cjson_writer_flush(cjson_writer *writer);
+CJSON_STATUS cjson_writer_start_object(cjson_writer *writer);
+CJSON_STATUS cjson_writer_end_object(cjson_writer *writer);
+CJSON_STATUS cjson_writer_start_array(cjson_writer *writer);
+CJSON_STATUS cjson_writer_end_array(cjson_writer *writer);
+CJSON_STATUS cjson_writer_key(cjson_writer *writer, const char *key, size_t len);
+CJSON_STATUS cjson_writer_null(cjson_writer *writer);
+CJSON_STATUS cjson_writer_boolean(cjson_writer *writer, int b);
+CJSON_STATUS cjson_writer_number(cjson_writer *writer, double num);
+CJSON_STATUS cjson_writer_int64(cjson_writer *writer, int64_t num);
+CJSON_STATUS cjson_writer_uint64(cjson_writer *writer, uint64_t num);
+CJSON_STATUS cjson_writer_string(cjson_writer *writer, const char *str, size_t len);
+CJSON_STATUS cjson_writer_value(cjson_writer *writer, const cjson_value *v);  //写出整棵树
+
+//流式解析，输入可以分成任意多块依次传入，不需要整个文档在一块连续的内存中，结果和cjson_parse()相同
+//使用创建时的全局分配器，出错之后feed和finish都返回同一个错误，已经解析的部分会被释放
+typedef struct cjson_stream__ cjson_stream;
+cjson_stream *cjson_stream_create(void);
+void cjson_stream_destroy(cjson_stream *stream);
+void cjson_stream_reset(cjson_stream *stream);  //丢弃当前文档，重新开始
+CJSON_STATUS cjson_stream_feed(cjson_stream *stream, const char *chunk, size_t len);   //返回CJSON_OK表示到目前为止没有错误
+CJSON_STATUS cjson_stream_finish(cjson_stream *stream, cjson_value *v);   //输入结束，成功时结果放到v中，之后可以解析下一个文档
+
+#ifdef CJSON_NDJSON
+//NDJSON：每行一个json文本，跳过空行；输入按换行符切成块，由多个线程并行解析，每个线程有自己的parser和arena
+//解析线程会同时使用全局分配器，自定义的分配器必须是线程安全的
+typedef struct
+{
+  size_t offset;        //记录在输入中的字节偏移
+  size_t length;        //记录的长度，不含换行符
+  CJSON_STATUS status;  //出错时value为CJSON_NULL
+  cjson_value value;    //从arena中分配，只在回调期间有效，需要保留时用cjson_copy()复制
+}cjson_ndjson_record;
+
+typedef int (*cjson_ndjson_callback)(void *user_data, cjson_ndjson_record *record);  //返回0中止解析
+
+typedef struct
+{
+  size_t threads;     //解析线程数，0使用CPU核数
+  size_t chunk_size;  //分块的大约字节数，0使用CJSON_NDJSON_CHUNK_SIZE
+  int ordered;        //非0时在调用线程中按记录的顺序回调；为0时在各个解析线程中并发回调，回调需要自己处理同步
+}cjson_ndjson_options;
+
+//options为NULL时使用默认值；所有记录都回调完才返回，单条记录出错不会中止，回调中止时返回CJSON_ERR_SAX_ABORT
+CJSON_STATUS cjson_ndjson_parse(const char *data, size_t len, const cjson_ndjson_options *options, cjson_ndjson_callback callback, void *user_data);
+CJSON_STATUS cjson_ndjson_parse_file(const char *path, const cjson_ndjson_options *options, cjson_ndjson_callback callback, void *user_data);  //mmap整个文件，只支持普通文件，失败返回CJSON_ERR_IO
+#endif
+
 
 #endif
\ No newline at end of file
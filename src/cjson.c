@@ -1,34 +1,154 @@
 #include "cjson.h"
 #include <assert.h>  /* assert() */
-#include <errno.h>   /* errno, ERANGE */
-#include <math.h>    /* HUGE_VAL */
-#include <stdio.h>   /* sprintf() */
-#include <stdlib.h>  /* NULL, malloc(), realloc(), free(), strtod() */
+#include <stdlib.h>  /* NULL, malloc(), realloc(), free() */
 #include <string.h>  /* memcpy() */
 
+#ifdef CJSON_NDJSON
+#include <fcntl.h>      /* open() */
+#include <pthread.h>    /* pthread_create() */
+#include <stdatomic.h>  /* atomic_int */
+#include <sys/mman.h>   /* mmap() */
+#include <sys/stat.h>   /* fstat() */
+#include <unistd.h>     /* close(), sysconf() */
+#endif
+
+#if !defined(CJSON_NO_SIMD) && defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>  /* SSE2 */
+#define CJSON_SSE2
+#if defined(__x86_64__) || defined(__i386__)   //gcc和clang可以单独为某个函数开启AVX2，运行时再决定是否使用
+#include <immintrin.h>
+#define CJSON_AVX2
+#endif
+#endif
+
 #ifndef CJSON_STACK_SIZE
 #define CJSON_STACK_SIZE (256)
 #endif
 
+#ifndef CJSON_MAX_DEPTH
+#define CJSON_MAX_DEPTH (1024)  //解析时数组和对象的最大嵌套层数
+#endif
+
+#ifndef CJSON_WALK_LOCAL_SIZE
+#define CJSON_WALK_LOCAL_SIZE (1024)  //遍历栈先使用这么多字节的局部空间，更深的树才申请内存
+#endif
+
+#ifndef CJSON_WRITER_BUFFER_SIZE
+#define CJSON_WRITER_BUFFER_SIZE (4096)
+#endif
+
+#ifndef CJSON_ARENA_BLOCK_SIZE
+#define CJSON_ARENA_BLOCK_SIZE (4096)
+#endif
+
+#ifndef CJSON_NDJSON_CHUNK_SIZE
+#define CJSON_NDJSON_CHUNK_SIZE (64 * 1024)   //NDJSON按这么多字节左右分块，块是线程之间分配任务的单位
+#endif
+
+#ifndef CJSON_OBJECT_INDEX_THRESHOLD
+#define CJSON_OBJECT_INDEX_THRESHOLD (16)   //对象成员数达到这么多时建立哈希索引
+#endif
+
+#define CJSON_FLAG_INTEGER (CJSON_FLAG_INT64 | CJSON_FLAG_UINT64)
+
+#define CJSON_ARENA_ALIGN(size) (((size) + 7) & ~(size_t)7)   //arena按8字节对齐分配
+
+typedef struct cjson_arena_block__
+{
+  struct cjson_arena_block__ *next;
+  size_t size, used;  //块的可用字节数，已分配字节数，数据紧跟在块头之后
+}cjson_arena_block;
+
+struct cjson_arena__
+{
+  cjson_arena_block *head;  //当前分配的块，链表中越靠前越新
+  size_t block_size;
+  cjson_allocator allocator;  //创建arena时的全局分配器，内存块都从这里分配
+};
+
+static void *cjson_default_malloc(void *ud, size_t size)  { (void)ud; return malloc(size); }
+static void *cjson_default_realloc(void *ud, void *ptr, size_t size)  { (void)ud; return realloc(ptr, size); }
+static void cjson_default_free(void *ud, void *ptr)  { (void)ud; free(ptr); }
+
+static const cjson_allocator cjson_default_allocator = { cjson_default_malloc, cjson_default_realloc, cjson_default_free, NULL };
+static cjson_allocator cjson_global_allocator = { cjson_default_malloc, cjson_default_realloc, cjson_default_free, NULL };
+
+#define CJSON_MALLOC(a, size)       ((a)->malloc_fn((a)->ud, (size)))
+#define CJSON_REALLOC(a, ptr, size) ((a)->realloc_fn((a)->ud, (ptr), (size)))
+#define CJSON_FREE(a, ptr)          ((a)->free_fn((a)->ud, (ptr)))
+
 typedef struct
 {
   const char *json;
+  const char *end;  //json结束位置，解析时所有扫描都不能越过这个位置
 
   char *stack;  //这个栈用于解析json时临时存放json值，当成功解析的时候再出栈，保存到cjson_value结构体中
   size_t top, size;
+
+  const cjson_allocator *allocator;  //栈和节点的内存分配器
+  cjson_arena *arena; //不为NULL时解析出的节点和字符串都从arena中分配
+  int insitu;         //原地解析，字符串解码到输入缓冲区中，值直接指向缓冲区
+
+  cjson_sink_fn sink; //不为NULL时栈满了先写出已有内容，栈的大小保持不变
+  void *sink_ud;
+  CJSON_STATUS sink_status;
+
+  const cjson_stringify_options *options;  //生成选项，NULL为紧凑输出
+  size_t max_depth;   //解析时的最大嵌套层数，0使用CJSON_MAX_DEPTH
+  int lazy;           //不为0时，已经有lazy - 1层打开之后遇到的数组和对象不解析，只记录片段
+  size_t lazy_depth;  //延迟解析时最外层在整个文档中的深度
+
+  const char *begin;      //两阶段解析时输入的开始位置
+  const uint32_t *token;  //不为NULL时是结构索引中下一个还没有到达的位置(相对begin)，跳过空白时直接跳过去
+
+#ifdef CJSON_STATS
+  cjson_parse_stats *stats;   //不为NULL时解析过程中记录统计
+#endif
 }cjson_context;
 
+struct cjson_parser__
+{
+  cjson_context c;    //栈在多次调用之间保留，不再每次申请和释放
+  size_t stack_size;  //初始栈大小，重置和收缩时恢复到这个大小
+  size_t trim_size;   //每次调用结束后栈超过这个大小就收缩，0表示不收缩
+  cjson_allocator allocator;  //创建时的全局分配器
+  int indexed;        //使用两阶段解析
+  uint32_t *tokens;   //结构索引，在多次调用之间保留
+  size_t token_capacity;
+#ifdef CJSON_STATS
+  cjson_parse_stats *stats;
+#endif
+};
+
 #define IS0TO9(ch) ((ch) >= '0' && (ch) <= '9')
 #define IS1TO9(ch) ((ch) >= '1' && (ch) <= '9')
+#define IS_SPACE(ch) ((ch) == ' ' || (ch) == '\t' || (ch) == '\n' || (ch) == '\r')
+
+#define PEEK(c) ((c)->json < (c)->end ? *(c)->json : '\0')   //读取当前字符，到达结尾时返回 '\0'
 
 #define PUSH_CHAR_TO_STACK(c, ch) do{ *(char *)cjson_push(c, sizeof(char)) = ch; }while(0)
 
+#ifdef CJSON_STATS
+#define CJSON_STAT(c, stmt) do{ if((c)->stats != NULL) { cjson_parse_stats *st_ = (c)->stats; stmt; } }while(0)   //stmt中用st_访问统计
+#else
+#define CJSON_STAT(c, stmt) ((void)0)   //不统计时整个语句不编译
+#endif
+
+static void cjson_sink_flush(cjson_context *c)  //把栈中的内容写出，失败之后只丢弃不再写出
+{
+  if(c->top > 0 && c->sink_status == CJSON_OK && !c->sink(c->sink_ud, c->stack, c->top))
+    c->sink_status = CJSON_ERR_SINK;
+  c->top = 0;
+}
+
 //栈内存放的都是相同类型的数据，给定存入的字节数，返回一个指向该内存块的指针，用于赋值
 static void* cjson_push(cjson_context *c, size_t len)
 {
   void *ret;
   assert(len > 0);
 
+  if(c->top + len > c->size && c->sink != NULL)
+    cjson_sink_flush(c);
   if(c->top + len > c->size)  //调整栈空间
   {
     if(c->size == 0)
@@ -37,7 +157,8 @@ static void* cjson_push(cjson_context *c, size_t len)
     while(c->top + len > c->size)   //循环保证扩容一次空间还不够的情况
       c->size += c->size >> 1;
 
-    c->stack = realloc(c->stack, c->size);
+    c->stack = CJSON_REALLOC(c->allocator, c->stack, c->size);
+    CJSON_STAT(c, st_->stack_reallocs++; if(c->size > st_->stack_size) st_->stack_size = c->size);
   }
 
   ret = c->stack + c->top;
@@ -57,960 +178,5245 @@ static void* cjson_pop(cjson_context *c, size_t len)
   return ret;
 }
 
-static void cjson_parse_skip_space(cjson_context *c)
+//遍历树时代替递归的显式栈，每个还没有处理完的数组或对象一帧，帧的类型由使用者决定
+typedef struct
 {
-  const char *p = c->json;
+  char *stack;
+  size_t top, size;
+  const cjson_allocator *allocator;
+  uint64_t local[CJSON_WALK_LOCAL_SIZE / sizeof(uint64_t)];   //较浅的树不申请内存
+}cjson_walk;
 
-  while(*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
-    p++;
-  c->json = p;
-}
+#define CJSON_WALK_TOP(w, type) ((type *)((w)->stack + (w)->top - sizeof(type)))   //最内层的帧
+#define CJSON_WALK_POP(w, type) ((w)->top -= sizeof(type))
 
-static CJSON_STATUS cjson_parse_literal(cjson_context *c, cjson_value *v, const char* expect, cjson_type type)   //解析文字null，true，false
+static void cjson_walk_init(cjson_walk *w, const cjson_allocator *a)
 {
-  char i = 0;
-  const char *p = c->json;
+  w->stack = (char *)w->local;
+  w->top = 0;
+  w->size = sizeof(w->local);
+  w->allocator = a;
+}
 
-  // for(i = 0; expect[i+1]; i++)   //这里for这么写的话，最后一个字符不比较，有bug
-  // {
-  //   if(*p++ != expect[i])
-  //     return CJSON_ERR_LITERAL;
-  // }
+static void *cjson_walk_push(cjson_walk *w, size_t len)
+{
+  void *ret;
 
-  do
+  if(w->top + len > w->size)
   {
-    if(*p++ != expect[i])
-      return CJSON_ERR_LITERAL;
-  }while(expect[++i]);
-
-  v->type = type;
-
-  c->json = p;
+    while(w->top + len > w->size)
+      w->size += w->size >> 1;
+    if(w->stack == (char *)w->local)
+      w->stack = (char *)memcpy(CJSON_MALLOC(w->allocator, w->size), w->local, w->top);
+    else
+      w->stack = (char *)CJSON_REALLOC(w->allocator, w->stack, w->size);
+  }
+  ret = w->stack + w->top;
+  w->top += len;
+  return ret;
+}
 
-  return CJSON_OK;
+static void cjson_walk_free(cjson_walk *w)
+{
+  if(w->stack != (char *)w->local)
+    CJSON_FREE(w->allocator, w->stack);
 }
 
-static CJSON_STATUS cjson_parse_number(cjson_context *c, cjson_value *v)
+static void *cjson_arena_alloc(cjson_arena *arena, size_t size)
 {
-  const char *p = c->json;
-  // char ch = *p;
+  cjson_arena_block *b;
+  void *ret;
 
-  if(*p == '-')
-    p++;
-    // ch = *(++p);  //指针运算，*运算优先级低于 p++，因此先自增，再解指针，*p++先取p值，解指针，p再自增
-                    //https://blog.csdn.net/weixin_41413441/article/details/80849827
+  assert(arena != NULL);
+  size = CJSON_ARENA_ALIGN(size);
 
-  if(*p == '0')
-    p++;
-  else
+  b = arena->head;
+  if(b == NULL || b->used + size > b->size)
   {
-    if(!IS0TO9(*p))
-      return CJSON_ERR_LITERAL;   //文字错误，switch的default分支默认解析数字
-    // while(IS0TO9(*p++));       //bug //这里IS0TO9()宏中如果有自增的话会自增两次，宏定义的原因
-    for(p++; IS0TO9(*p); p++);  //第一个表达式的作用是跳过当前字符，因为在上面if语句中已经判断一次了
-  }
+    if(size > arena->block_size)  //大块单独分配，挂在当前块后面，当前块剩余的空间还可以继续用
+    {
+      b = (cjson_arena_block *)CJSON_MALLOC(&arena->allocator, sizeof(cjson_arena_block) + size);
+      b->size = b->used = size;
+      if(arena->head)
+      {
+        b->next = arena->head->next;
+        arena->head->next = b;
+      }
+      else
+      {
+        b->next = NULL;
+        arena->head = b;
+      }
+      return b + 1;
+    }
 
-  if(*p == '.')
-  {
-    p++;
-    if(!IS0TO9(*p))
-      return CJSON_ERR_LITERAL;
-    for(p++; IS0TO9(*p); p++);
+    b = (cjson_arena_block *)CJSON_MALLOC(&arena->allocator, sizeof(cjson_arena_block) + arena->block_size);
+    b->size = arena->block_size;
+    b->used = 0;
+    b->next = arena->head;
+    arena->head = b;
   }
 
-  if(*p == 'e' || *p == 'E')
-  {
-    p++;
-    if (*p == '+' || *p == '-')
-      p++;
-    if(!IS0TO9(*p))
-      return CJSON_ERR_LITERAL;
-    for(p++; IS0TO9(*p); p++);
-  }
-  
-  errno = 0;  // http://c.biancheng.net/c/errno/  https://blog.csdn.net/jediael_lu/article/details/8589194
-  v->u.num = strtod(c->json, NULL);
-  if (errno == ERANGE && (v->u.num == HUGE_VAL || v->u.num == -HUGE_VAL))
-    return CJSON_ERR_NUMBER_TOO_BIG;
+  ret = (char *)(b + 1) + b->used;
+  b->used += size;
+  return ret;
+}
 
-  v->type = CJSON_NUMBER;
+static void *cjson_malloc(const cjson_allocator *a, cjson_arena *arena, size_t size)   //arena为NULL时从分配器a上分配
+{
+  return arena ? cjson_arena_alloc(arena, size) : CJSON_MALLOC(a, size);
+}
 
-  c->json = p;
+//---------------------------对象索引---------------------------//
+//开放寻址的哈希表，槽数是2的幂且不小于成员数的2倍，线性探测
+//只记录成员下标，成员数组扩容不影响索引；有重复key时和线性查找一样找到第一个
 
-  return CJSON_OK;
-}
+typedef struct
+{
+  size_t hash;
+  size_t pos;   //成员下标+1，0表示空槽
+}cjson_index_slot;
 
+struct cjson_object_index__
+{
+  size_t mask;  //槽数-1
+  cjson_index_slot slots[];
+};
 
-static CJSON_STATUS cjson_parse_4hex(const char *p, uint16_t *hex)
+static size_t cjson_hash_key(const char *key, size_t len)  //FNV-1a，每次处理8字节，最后把高位混合到低位
 {
-  assert(p != NULL);
-  assert(hex != NULL);
+  uint64_t h = 14695981039346656037ULL ^ len, w;
 
-  *hex = 0;
-  for(char i = 0; i < 4; i++)
+  for(; len >= 8; key += 8, len -= 8)
   {
-    *hex <<= 4;   //这个必须放在前面，如果放在if后边，最后一次填满16位，又移位，会丢数据
-    if(IS0TO9(*p))
-      *hex |= *p - '0';
-    else if(*p >= 'a' && *p <= 'f')
-      *hex |= *p - 'a' + 10;
-    else if(*p >= 'A' && *p <= 'F')
-      *hex |= *p - 'A' + 10;
-    else
-      return CJSON_ERR_UNICODE_HEX;
-    p++;
+    memcpy(&w, key, 8);
+    h = (h ^ w) * 1099511628211ULL;
   }
-
-  return CJSON_OK;
+  for(; len > 0; key++, len--)
+    h = (h ^ (unsigned char)*key) * 1099511628211ULL;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (size_t)h;
 }
 
-static void cjson_parse_utf8(cjson_context *c, uint32_t codepoint)
+static size_t cjson_index_find(const cjson_object_index *index, const cjson_member *members, const char *key, size_t klen, size_t hash)
 {
-  if(codepoint <= 0x7f)
-    PUSH_CHAR_TO_STACK(c, codepoint & 0xff);
-  else if(codepoint <= 0x7ff)
+  for(size_t i = hash & index->mask; index->slots[i].pos != 0; i = (i + 1) & index->mask)
   {
-    PUSH_CHAR_TO_STACK(c, 0xc0 | ((codepoint >> 6) & 0x1f));    // 110x xxxx
-    PUSH_CHAR_TO_STACK(c, 0x80 | ( codepoint       & 0x3f));    // 10xx xxxx
+    const cjson_member *m = members + index->slots[i].pos - 1;
+    if(index->slots[i].hash == hash && m->key_len == klen && !memcmp(m->key, key, klen))
+      return index->slots[i].pos - 1;
   }
-  else if(codepoint <= 0xffff)
+  return CJSON_KEY_NOT_EXIST;
+}
+
+static void cjson_index_insert(cjson_object_index *index, const cjson_member *members, size_t pos, size_t hash)  //key已经存在时保留原来的下标
+{
+  const cjson_member *n = members + pos;
+  size_t i;
+
+  for(i = hash & index->mask; index->slots[i].pos != 0; i = (i + 1) & index->mask)
   {
-    PUSH_CHAR_TO_STACK(c, 0xe0 | ((codepoint >> 12) & 0x1f));    // 1110 xxxx
-    PUSH_CHAR_TO_STACK(c, 0x80 | ((codepoint >> 6)  & 0x3f));    // 10xx xxxx
-    PUSH_CHAR_TO_STACK(c, 0x80 | ( codepoint        & 0x3f));    // 10xx xxxx
+    const cjson_member *m = members + index->slots[i].pos - 1;
+    if(index->slots[i].hash == hash && m->key_len == n->key_len && !memcmp(m->key, n->key, n->key_len))
+      return;
   }
-  else
-  {
-    assert(codepoint <= 0x10ffff);
-    PUSH_CHAR_TO_STACK(c, 0xf0 | ((codepoint >> 18) & 0x07));    // 1111 0xxx
-    PUSH_CHAR_TO_STACK(c, 0x80 | ((codepoint >> 12) & 0x3f));    // 10xx xxxx
-    PUSH_CHAR_TO_STACK(c, 0x80 | ((codepoint >> 6)  & 0x3f));    // 10xx xxxx
-    PUSH_CHAR_TO_STACK(c, 0x80 | ( codepoint        & 0x3f));    // 10xx xxxx
+  index->slots[i].hash = hash;
+  index->slots[i].pos = pos + 1;
+}
+
+static void cjson_index_rehash(cjson_object_index *index, const cjson_member *members, size_t size)  //清空后重新插入所有成员
+{
+  memset(index->slots, 0, (index->mask + 1) * sizeof(cjson_index_slot));
+  for(size_t i = 0; i < size; i++)
+    cjson_index_insert(index, members, i, cjson_hash_key(members[i].key, members[i].key_len));
+}
 
+static size_t cjson_object_find_hash(const cjson_value *v, const char *key, size_t klen, size_t hash)  //hash是cjson_hash_key()的结果，只在有索引时使用
+{
+  if(v->u.obj.index)
+    return cjson_index_find(v->u.obj.index, v->u.obj.members, key, klen, hash);
+  for(size_t i = 0; i < v->u.obj.size; i++)
+  {
+    if(v->u.obj.members[i].key_len == klen && !memcmp(v->u.obj.members[i].key, key, klen))
+      return i;
   }
+  return CJSON_KEY_NOT_EXIST;
 }
 
+static size_t cjson_object_find(const cjson_value *v, const char *key, size_t klen)  //有索引时用索引，否则线性查找，key可以为空串
+{
+  return cjson_object_find_hash(v, key, klen, v->u.obj.index ? cjson_hash_key(key, klen) : 0);
+}
 
-static CJSON_STATUS cjson_parse_string_raw(cjson_context *c, const char **s, size_t *l) //解析出来的字符串长度不包括c语言规定的结尾字节 '\0'
+static cjson_object_index *cjson_index_build(const cjson_allocator *a, cjson_arena *arena, const cjson_member *members, size_t size)
 {
-  #define RETURN_STRING_ERR(err_code) do{c->top = head; return err_code;}while(0)
+  size_t n = 1;
+  cjson_object_index *index;
+
+  while(n < size * 2)
+    n <<= 1;
+  index = (cjson_object_index *)cjson_malloc(a, arena, sizeof(cjson_object_index) + n * sizeof(cjson_index_slot));
+  index->mask = n - 1;
+  cjson_index_rehash(index, members, size);
+  return index;
+}
 
-  size_t len, head = c->top;
-  const char *p = c->json;
-  unsigned char ch = 0;
-  uint16_t hex = 0;   //utf8高代理项、BMP平面内码点
-  uint32_t codepoint = 0; //utf8码点
+//字符串中需要特殊处理的字符：引号、反斜杠和小于0x20的控制字符
+#define IS_STRING_SPECIAL(ch) ((ch) == '\"' || (ch) == '\\' || (unsigned char)(ch) < 0x20)
 
-  if(*p == '\"')
-    p++;
-  else
-    RETURN_STRING_ERR(CJSON_ERR_STRING_MISS_QUOTATION_MARK);
+static size_t cjson_scan_string_scalar(const char *p, const char *end)  //返回从p开始不需要特殊处理的字节数
+{
+  const char *q = p;
+  while(q < end && !IS_STRING_SPECIAL(*q))
+    q++;
+  return q - p;
+}
 
-  while(1)
+#ifdef CJSON_SSE2
+static size_t cjson_scan_string_sse2(const char *p, const char *end)   //一次检查16字节，不足16字节的尾部逐字节检查
+{
+  const __m128i quote = _mm_set1_epi8('\"'), slash = _mm_set1_epi8('\\'), ctrl = _mm_set1_epi8(0x1f);
+  const char *q = p;
+
+  for(; end - q >= 16; q += 16)
   {
-    ch = *p++;
-    switch (ch) //规则检查
-    {
-      case '\\':  //转义字符
-        // p++;
-        switch (*p++)
-        {
-          case 'b':  PUSH_CHAR_TO_STACK(c, '\b'); break;
-          case 'f':  PUSH_CHAR_TO_STACK(c, '\f'); break;
-          case 'r':  PUSH_CHAR_TO_STACK(c, '\r'); break;
-          case 'n':  PUSH_CHAR_TO_STACK(c, '\n'); break;
-          case 't':  PUSH_CHAR_TO_STACK(c, '\t'); break;
-          case '\\': PUSH_CHAR_TO_STACK(c, '\\'); break;
-          case '\"': PUSH_CHAR_TO_STACK(c, '\"'); break;
-          case '/':  PUSH_CHAR_TO_STACK(c, '/');  break;
-          case 'u':
-            if(cjson_parse_4hex(p, &hex) != CJSON_OK)
-              RETURN_STRING_ERR(CJSON_ERR_UNICODE_HEX);
-            p += 4;
-            codepoint = hex;
+    __m128i v = _mm_loadu_si128((const __m128i *)q);
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));   //max(v, 0x1f) == 0x1f 即 v <= 0x1f
+    int mask = _mm_movemask_epi8(m);
+    if(mask)
+      return q - p + __builtin_ctz(mask);
+  }
+  return q - p + cjson_scan_string_scalar(q, end);
+}
+#endif
 
-            if(hex >= 0xd800 && hex <= 0xdbff)  //hex为高代理项
-            {
-              uint16_t hex2 = 0;
-              if(*p++ != '\\')
-                RETURN_STRING_ERR(CJSON_ERR_UNICODE_SURROGATE);
-              if(*p++ != 'u')
-                RETURN_STRING_ERR(CJSON_ERR_UNICODE_SURROGATE);
+#ifdef CJSON_AVX2
+__attribute__((target("avx2")))
+static size_t cjson_scan_string_avx2(const char *p, const char *end)   //一次检查32字节
+{
+  const __m256i quote = _mm256_set1_epi8('\"'), slash = _mm256_set1_epi8('\\'), ctrl = _mm256_set1_epi8(0x1f);
+  const char *q = p;
 
-              if(cjson_parse_4hex(p, &hex2) != CJSON_OK)  //hex2 为低代理项
-                RETURN_STRING_ERR(CJSON_ERR_UNICODE_HEX);
-              if (hex2 < 0xDC00 || hex2 > 0xDFFF)
-                RETURN_STRING_ERR(CJSON_ERR_UNICODE_SURROGATE);
-              p += 4;
+  for(; end - q >= 32; q += 32)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i *)q);
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, slash));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl));
+    unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+    if(mask)
+      return q - p + __builtin_ctz(mask);
+  }
+  return q - p + cjson_scan_string_sse2(q, end);
+}
 
-              codepoint = 0x10000 + (hex - 0xd800) * 0x400 + (hex2 - 0xdc00);
-            }
-            cjson_parse_utf8(c, codepoint);
-            break;    //utf-8
-          default:
-            RETURN_STRING_ERR(CJSON_ERR_STRING_INVALID_ESCAPE);
-        }
-        break;
+static size_t cjson_scan_string_resolve(const char *p, const char *end);
+static size_t (*cjson_scan_string_fn)(const char *p, const char *end) = cjson_scan_string_resolve;
 
-      case '\0':  //字符串中不能有结束符
-        RETURN_STRING_ERR(CJSON_ERR_STRING_MISS_QUOTATION_MARK);
+//指针用原子操作读写，多个线程可以同时解析；relaxed就够了，任何线程读到哪一个实现都能正确使用
+#define cjson_scan_string(p, end) (__atomic_load_n(&cjson_scan_string_fn, __ATOMIC_RELAXED)((p), (end)))
 
-      default:    //普通合法字符
-        if(ch < 0x20)
-          RETURN_STRING_ERR(CJSON_ERR_STRING_INVALID_CAHR);
-        else
-          PUSH_CHAR_TO_STACK(c, ch);
-        break;
+static size_t cjson_scan_string_resolve(const char *p, const char *end)  //第一次调用时根据cpu选择实现
+{
+  size_t (*fn)(const char *, const char *);
 
-      case '\"':  //字符串结束引号
-        len = c->top - head;
-        // cjson_set_string(v, (const char *)cjson_pop(c, len), len);
-        *s = (const char *)cjson_pop(c, len);
-        *l = len;
-        // c->json = ++p;
-        c->json = p++;
-        return CJSON_OK;
-        break;
-    }
-  }
+  __builtin_cpu_init();
+  fn = __builtin_cpu_supports("avx2") ? cjson_scan_string_avx2 : cjson_scan_string_sse2;
+  __atomic_store_n(&cjson_scan_string_fn, fn, __ATOMIC_RELAXED);
+  return fn(p, end);
 }
+#elif defined(CJSON_SSE2)
+#define cjson_scan_string cjson_scan_string_sse2
+#else
+#define cjson_scan_string cjson_scan_string_scalar
+#endif
 
-static CJSON_STATUS cjson_parse_string(cjson_context *c, cjson_value *v)
+//---------------------------结构索引---------------------------//
+//两阶段解析的第一阶段：每次处理64字节，用位运算找出字符串之外的结构字符、字符串的开始和结束引号、其他值的第一个字符，
+//以及字符串中的反斜杠和控制字符
+//第二阶段仍然是cjson_parse_value()，跳过空白时直接跳到下一个记录的位置；开始引号的下一个记录就是结束引号时，
+//字符串中没有要处理的字符，直接取这一段；有转义时按记录找下一个特殊字符，都不再逐字节扫描，结果和错误码都和普通解析相同
+
+typedef struct
 {
-  const char *s;
-  size_t len;
-  CJSON_STATUS ret;
+  uint64_t quote, backslash, op, space, ctrl;   //每一位对应块中的一个字节，op是 {}[]:,，ctrl是小于0x20的字节
+}cjson_block_mask;
 
-  if((ret = cjson_parse_string_raw(c, &s, &len)) == CJSON_OK)
-    cjson_set_string(v, s, len);
-  return ret;
+#ifndef CJSON_SSE2   //x86-64上总有SSE2，只在其他平台上使用
+static void cjson_classify_scalar(const char *p, cjson_block_mask *m)
+{
+  memset(m, 0, sizeof(cjson_block_mask));
+  for(int i = 0; i < 64; i++)
+  {
+    uint64_t bit = (uint64_t)1 << i;
+    switch(p[i])
+    {
+      case '\"': m->quote |= bit; break;
+      case '\\': m->backslash |= bit; break;
+      case '{': case '}': case '[': case ']': case ':': case ',': m->op |= bit; break;
+      case ' ': case '\t': case '\n': case '\r': m->space |= bit; break;
+    }
+    if((unsigned char)p[i] < 0x20)
+      m->ctrl |= bit;
+  }
 }
+#endif
 
-static CJSON_STATUS cjson_parse_value(cjson_context *c, cjson_value *v);
-static CJSON_STATUS cjson_parse_array(cjson_context *c, cjson_value *v)
+#ifdef CJSON_SSE2
+static void cjson_classify_sse2(const char *p, cjson_block_mask *m)
 {
-  cjson_value value = {0};
-  CJSON_STATUS ret;
-  ssize_t size = 0;
-
-  c->json++;  //跳过 '['
+  const __m128i quote = _mm_set1_epi8('\"'), slash = _mm_set1_epi8('\\'), lower = _mm_set1_epi8(0x20);
+  const __m128i open = _mm_set1_epi8('{'), close = _mm_set1_epi8('}'), colon = _mm_set1_epi8(':'), comma = _mm_set1_epi8(',');
+  const __m128i sp = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t'), lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r'), ctrl = _mm_set1_epi8(0x1f);
 
-  cjson_parse_skip_space(c);
-  if(*c->json == ']')
+  memset(m, 0, sizeof(cjson_block_mask));
+  for(int i = 0; i < 64; i += 16)
   {
-    c->json++;
-    v->type = CJSON_ARRAY;
-    v->u.arr.elements = NULL;
-    v->u.arr.size = 0;
-    return CJSON_OK;
+    __m128i v = _mm_loadu_si128((const __m128i *)(p + i)), l = _mm_or_si128(v, lower);   //'['和']'或上0x20之后是'{'和'}'
+    __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(l, open), _mm_cmpeq_epi8(l, close)), _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+    __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)), _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+    m->quote |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << i;
+    m->backslash |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, slash)) << i;
+    m->op |= (uint64_t)_mm_movemask_epi8(op) << i;
+    m->space |= (uint64_t)_mm_movemask_epi8(space) << i;
+    m->ctrl |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl)) << i;
   }
+}
+#endif
 
-  while(1)
+#ifdef CJSON_AVX2
+__attribute__((target("avx2")))
+static void cjson_classify_avx2(const char *p, cjson_block_mask *m)
+{
+  const __m256i quote = _mm256_set1_epi8('\"'), slash = _mm256_set1_epi8('\\'), lower = _mm256_set1_epi8(0x20);
+  const __m256i open = _mm256_set1_epi8('{'), close = _mm256_set1_epi8('}'), colon = _mm256_set1_epi8(':'), comma = _mm256_set1_epi8(',');
+  const __m256i sp = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t'), lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r'), ctrl = _mm256_set1_epi8(0x1f);
+
+  memset(m, 0, sizeof(cjson_block_mask));
+  for(int i = 0; i < 64; i += 32)
   {
-    if((ret = cjson_parse_value(c, &value)) != CJSON_OK)  // = 的优先级低于 !=
-      break;
+    __m256i v = _mm256_loadu_si256((const __m256i *)(p + i)), l = _mm256_or_si256(v, lower);
+    __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(l, open), _mm256_cmpeq_epi8(l, close)), _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+    __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab)), _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+    m->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)) << i;
+    m->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, slash)) << i;
+    m->op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+    m->space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << i;
+    m->ctrl |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl)) << i;
+  }
+}
 
-    memcpy(cjson_push(c, sizeof(cjson_value)), &value, sizeof(cjson_value));  //压栈
-    size++;   //元素个数，并非字节数
+static void cjson_classify_resolve(const char *p, cjson_block_mask *m);
+static void (*cjson_classify_fn)(const char *p, cjson_block_mask *m) = cjson_classify_resolve;
 
-    cjson_parse_skip_space(c);
+#define cjson_classify(p, m) (__atomic_load_n(&cjson_classify_fn, __ATOMIC_RELAXED)((p), (m)))  //同cjson_scan_string
 
-    if(*c->json == ',')   //如果逗号之后没有字符了会在下一次循环cjson_parse_value()中报错
-      c->json++;
-    else if(*c->json == ']')
-    {
-      c->json++;
-      v->type = CJSON_ARRAY;
-      v->u.arr.size = size;
+static void cjson_classify_resolve(const char *p, cjson_block_mask *m)
+{
+  void (*fn)(const char *, cjson_block_mask *);
 
-      size *= sizeof(cjson_value);
-      memcpy(v->u.arr.elements = (cjson_value *)malloc(size), cjson_pop(c, size), size);  //压栈，出栈的长度单位都是字节
-      return CJSON_OK;
-    }
-    else
-    {
-      ret = CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET;
-      break;
-    }
-  }
+  __builtin_cpu_init();
+  fn = __builtin_cpu_supports("avx2") ? cjson_classify_avx2 : cjson_classify_sse2;
+  __atomic_store_n(&cjson_classify_fn, fn, __ATOMIC_RELAXED);
+  fn(p, m);
+}
+#elif defined(CJSON_SSE2)
+#define cjson_classify cjson_classify_sse2
+#else
+#define cjson_classify cjson_classify_scalar
+#endif
 
-  for(size_t i = 0; i < size; i++)  //数组中某元素解析出错之后释放之前申请的空间
+static int cjson_ctz64(uint64_t x)   //x不能为0
+{
+#ifdef __GNUC__
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while(!(x & 1))
   {
-    cjson_value_free((cjson_value *)cjson_pop(c, sizeof(cjson_value)));
+    x >>= 1;
+    n++;
   }
-
-  return ret;
+  return n;
+#endif
 }
 
-static CJSON_STATUS cjson_parse_object(cjson_context *c, cjson_value *v)
+static uint64_t cjson_prefix_xor(uint64_t x)   //每一位变成它和它之前所有位的异或，引号之间(包括开始引号，不包括结束引号)为1
 {
-  CJSON_STATUS ret = 0;
-  size_t size = 0;
-  cjson_member member = {0};
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
 
-  c->json++;  //跳过 '{'
+static uint64_t cjson_escaped_mask(uint64_t backslash, uint64_t *carry)   //被反斜杠转义的字节，*carry为1表示上一块最后是一个起转义作用的反斜杠
+{
+  //一串连续的反斜杠中第1、3、5...个起转义作用，用减法按每串起点的奇偶一次算出，不用逐个处理
+  const uint64_t odd = 0xAAAAAAAAAAAAAAAAULL;
+  uint64_t start = backslash & ~*carry;   //被转义的反斜杠不再转义下一个字节
+  uint64_t code = ((start << 1 | odd) - start) ^ odd;
+  uint64_t escaped = code ^ (backslash | *carry);
+
+  *carry = (code & backslash) >> 63;
+  return escaped;
+}
 
-  cjson_parse_skip_space(c);
-  if(*c->json == '}')
-  {
-    c->json++;
-    v->type = CJSON_OBJECT;
-    v->u.obj.members = NULL;
-    v->u.obj.size = 0;
-    return CJSON_OK;
-  }
+//找出json中所有记录的位置，按顺序写入tokens，最后加上len作为结尾，tokens不够时扩容，返回新的tokens
+static uint32_t *cjson_index_structurals(const cjson_allocator *a, uint32_t *tokens, size_t *capacity, const char *json, size_t len)
+{
+  uint64_t in_string = 0, escape_carry = 0, scalar_carry = 0;   //上一块结束时是否在字符串中(全1或0)，最后一个字节是否属于数字或文字
+  size_t n = 0;
+  char tail[64];
 
-  while(1)
+  for(size_t off = 0; off < len; off += 64)
   {
-    //key
-    if(*c->json != '\"')
-    {
-      ret = CJSON_ERR_OBJECT_NEED_KEY;
-      break;
-    }
-    const char *str;
-    if((ret = cjson_parse_string_raw(c, &(str), &(member.key_len))) != CJSON_OK)    //这里先解析字符串，成功之后再申请内存放到member变量中
-      break;
-    memcpy(member.key = (char *)malloc(member.key_len + 1), str, member.key_len);
-    member.key[member.key_len] = '\0';
+    cjson_block_mask m;
+    uint64_t quote, scalar, mask;
 
-    //:
-    cjson_parse_skip_space(c);
-    if(*c->json == ':')
-      c->json++;
-    else
+    if(len - off >= 64)
+      cjson_classify(json + off, &m);
+    else  //最后不足64字节的部分用空格补齐
     {
-      ret = CJSON_ERR_OBJECT_NEED_COLON;
-      break;
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, json + off, len - off);
+      cjson_classify(tail, &m);
     }
-
-    if((ret = cjson_parse_value(c, &member.value) != CJSON_OK))
-      return ret;
-
-    memcpy((cjson_member *)cjson_push(c, sizeof(cjson_member)), &member, sizeof(cjson_member));
-    member.key = NULL;  //memcpy是浅复制，只是把member.key指针复制到stack中了，但是它指向的内存没有重新申请，所有权转移了
-    size++;
-
-    cjson_parse_skip_space(c);
-
-    if(*c->json == ',')
+    if(*capacity < n + 64 + 1)
     {
-      c->json++;
-      cjson_parse_skip_space(c);
+      *capacity = *capacity > 0 ? *capacity + (*capacity >> 1) : (len >> 3) + 64;
+      if(*capacity < n + 64 + 1)
+        *capacity = n + 64 + 1;
+      tokens = (uint32_t *)CJSON_REALLOC(a, tokens, *capacity * sizeof(uint32_t));
     }
-    else if(*c->json == '}')
-    {
-      c->json++;
-      v->type = CJSON_OBJECT;
-      v->u.obj.size = size;
 
-      size *= sizeof(cjson_member);
+    quote = m.quote & ~cjson_escaped_mask(m.backslash, &escape_carry);
+    in_string = cjson_prefix_xor(quote) ^ in_string;
+    scalar = ~(m.op | m.space | quote | in_string);   //字符串之外的其他字节，即数字和文字(以及非法字符)
+    mask = (m.op & ~in_string) | quote | ((m.backslash | m.ctrl) & in_string) | (scalar & ~(scalar << 1 | scalar_carry));
+    in_string = (uint64_t)0 - (in_string >> 63);
+    scalar_carry = scalar >> 63;
 
-      memcpy(v->u.obj.members = (cjson_member *)malloc(size), cjson_pop(c, size), size);
-      return CJSON_OK;
-    }
-    else
+    while(mask)
     {
-      ret = CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET;
-      break;
+      tokens[n++] = (uint32_t)(off + cjson_ctz64(mask));
+      mask &= mask - 1;
     }
   }
-
-  free(member.key);   //上一循环中如果在member入队之后break的，那么此时member.key为NULL
-  for(size_t i = 0; i < size; i++)
+  if(*capacity < n + 1)
   {
-    cjson_member *m;
-    m = (cjson_member *)cjson_pop(c, sizeof(cjson_member));
-    free(m->key);
-    cjson_value_free(&m->value);
+    *capacity = n + 1;
+    tokens = (uint32_t *)CJSON_REALLOC(a, tokens, *capacity * sizeof(uint32_t));
   }
-
-  return ret;
+  tokens[n] = (uint32_t)len;
+  return tokens;
 }
 
-static CJSON_STATUS cjson_parse_value(cjson_context *c, cjson_value *v)
+static void cjson_parse_skip_space(cjson_context *c)
 {
-  CJSON_STATUS ret;
+  const char *p = c->json;
 
-  cjson_parse_skip_space(c);
-  switch (*(c->json))
+  if(c->token != NULL)  //p是空白时，p后面的第一个记录就是下一个非空白字符
   {
-    case 'n':  ret = cjson_parse_literal(c, v, "null", CJSON_NULL);   break;
-    case 't':  ret = cjson_parse_literal(c, v, "true", CJSON_TRUE);   break;
-    case 'f':  ret = cjson_parse_literal(c, v, "false", CJSON_FALSE); break;
-    case '\"': ret = cjson_parse_string(c, v); break;
-    case '[':  ret = cjson_parse_array(c, v);  break;
-    case '{':  ret = cjson_parse_object(c, v); break;
-    case '\0': ret = CJSON_ERR_MISS_VALUE;     break;
-    default:   ret = cjson_parse_number(c, v); break;
+    if(p < c->end && IS_SPACE(*p))
+    {
+      while(c->begin + *c->token <= p)
+        c->token++;
+      c->json = c->begin + *c->token;
+    }
+    return;
   }
-
-  return ret;
+  while(p < c->end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+    p++;
+  c->json = p;
 }
 
-static void cjson_stringify_string(cjson_context *c, const char *str, size_t len)
+static CJSON_STATUS cjson_parse_literal(cjson_context *c, cjson_value *v, const char* expect, cjson_type type)   //解析文字null，true，false
 {
-  static const char hex[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-  char *p, *head;
-
-  p = head = cjson_push(c, len * 6 + 2);    //按最坏的情况计算，全部转化乘 \uxxxx 形式，再加两个引号
+  char i = 0;
+  const char *p = c->json;
 
-  *p++ = '\"';
+  // for(i = 0; expect[i+1]; i++)   //这里for这么写的话，最后一个字符不比较，有bug
+  // {
+  //   if(*p++ != expect[i])
+  //     return CJSON_ERR_LITERAL;
+  // }
 
-  for(size_t i = 0; i < len; i++)
+  do
   {
-    switch(str[i])
-    {
-      case '\b': *p++ = '\\'; *p++ = 'b'; break;
-      case '\f': *p++ = '\\'; *p++ = 'f'; break;
-      case '\r': *p++ = '\\'; *p++ = 'r'; break;
-      case '\n': *p++ = '\\'; *p++ = 'n'; break;
-      case '\t': *p++ = '\\'; *p++ = 't'; break;
-      case '\\': *p++ = '\\'; *p++ = '\\'; break;
-      case '\"': *p++ = '\\'; *p++ = '\"'; break;
-      default :
-        if((uint8_t)str[i] < 0x20)
-        {
-          *p++ = '\\';  *p++ = 'u';  *p++ = '0';  *p++ = '0';
-          *p++ = hex[(str[i] >> 4) & 0x0f];
-          *p++ = hex[(str[i]) & 0x0f];
-        }
-        else
-        {
-          *p++ = str[i];
-        }
-        break;
-    }
-  }
-  *p++ = '\"';
-  c->top -=  len * 6 + 2 - (p - head);
+    if(p == c->end || *p++ != expect[i])
+      return CJSON_ERR_LITERAL;
+  }while(expect[++i]);
+
+  v->type = type;
+
+  c->json = p;
+
+  return CJSON_OK;
+}
+
+//---------------------------数字转换---------------------------//
+//快速路径：有效数字不超过19位且能放进53位尾数时，和10的幂做一次乘除就是正确舍入的结果(Clinger)
+//其余情况用十进制大数移位的方法精确转换，不依赖strtod和locale，也不申请内存
+
+#define CJSON_DECIMAL_DIGITS (800)  //超过这么多位的有效数字只记录是否非零，不影响正确舍入
+#define CJSON_DECIMAL_SHIFT  (27)   //每次最多移27位，5^27和10*2^27都不会溢出uint64
+
+typedef struct
+{
+  char d[CJSON_DECIMAL_DIGITS];   //有效数字，'0'~'9'，值为 0.d[0]d[1]...d[nd-1] * 10^dp
+  int nd, dp;
+  int trunc;  //是否丢弃了超出d的非零数字
+}cjson_decimal;
+
+static const double cjson_pow10[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static void cjson_decimal_trim(cjson_decimal *a)  //去掉末尾的0
+{
+  while(a->nd > 0 && a->d[a->nd - 1] == '0')
+    a->nd--;
+  if(a->nd == 0)
+    a->dp = 0;
 }
 
-static void cjson_stringify_value(cjson_context *c, const cjson_value *v) //生成json字符串
+static void cjson_decimal_right_shift(cjson_decimal *a, unsigned int k)  //除以2^k
 {
-  char *s;
-  size_t len;
+  int r = 0, w = 0;
+  uint64_t n = 0, mask = ((uint64_t)1 << k) - 1;
 
-  switch(v->type)
+  for(; (n >> k) == 0; r++)   //取够第一次移位需要的数字
   {
-    case CJSON_NULL: memcpy(cjson_push(c, 4), "null", 4); break;
-    case CJSON_TRUE: memcpy(cjson_push(c, 4), "true", 4); break;
-    case CJSON_FALSE: memcpy(cjson_push(c, 5), "false", 5); break;
-    case CJSON_NUMBER: c->top -= 32 - sprintf(cjson_push(c, 32), "%.17g", v->u.num); break; //数字的最长长度为32
-    case CJSON_STRING: cjson_stringify_string(c, v->u.str.buf, v->u.str.l); break;
-    case CJSON_ARRAY:
-      PUSH_CHAR_TO_STACK(c, '[');
-      for(size_t i = 0; i < v->u.arr.size; i++)
+    if(r >= a->nd)
+    {
+      if(n == 0)
       {
-        if(i != 0)
-          PUSH_CHAR_TO_STACK(c, ',');
-        cjson_stringify_value(c, (const cjson_value *)v->u.arr.elements + i);   //数组中的第i个元素
+        a->nd = 0;
+        return;
       }
-      PUSH_CHAR_TO_STACK(c, ']');
-      break;
-    case CJSON_OBJECT:
-      PUSH_CHAR_TO_STACK(c, '{');
-      for(size_t i = 0; i < v->u.obj.size; i++)
+      while((n >> k) == 0)
       {
-        if(i != 0)
-          PUSH_CHAR_TO_STACK(c, ',');
-        cjson_stringify_string(c, v->u.obj.members[i].key, v->u.obj.members[i].key_len);
-        PUSH_CHAR_TO_STACK(c, ':');
-        cjson_stringify_value(c, &v->u.obj.members[i].value);   //对象中的第i个key-value的 value
+        n *= 10;
+        r++;
       }
-      PUSH_CHAR_TO_STACK(c, '}');
       break;
+    }
+    n = n * 10 + (a->d[r] - '0');
   }
-}
+  a->dp -= r - 1;
 
-//--------------------------API--------------------------//
+  for(; r < a->nd; r++)   //取一位，放一位
+  {
+    uint64_t dig = n >> k;
+    n &= mask;
+    a->d[w++] = (char)(dig + '0');
+    n = n * 10 + (a->d[r] - '0');
+  }
 
-char *cjson_stringify(cjson_value v, size_t *length)
+  while(n > 0)  //剩下的数字
+  {
+    uint64_t dig = n >> k;
+    n &= mask;
+    if(w < CJSON_DECIMAL_DIGITS)
+      a->d[w++] = (char)(dig + '0');
+    else if(dig > 0)
+      a->trunc = 1;
+    n *= 10;
+  }
+
+  a->nd = w;
+  cjson_decimal_trim(a);
+}
+
+static void cjson_decimal_left_shift(cjson_decimal *a, unsigned int k)   //乘以2^k
 {
-  cjson_context c = {0};
+  char cutoff[24];
+  int delta = 0, len = 0, r, w;
+  uint64_t n, pow5 = 1;
+
+  //乘以2^k之后多出的位数是2^k的位数，当d的前缀小于5^k时少一位
+  for(n = (uint64_t)1 << k; n > 0; n /= 10)
+    delta++;
+  for(r = 0; r < (int)k; r++)
+    pow5 *= 5;
+  for(n = pow5; n > 0; n /= 10)
+    cutoff[len++] = '0' + n % 10;
+  for(r = 0; r < len; r++)  //cutoff倒过来才是5^k的十进制串
+  {
+    char ch = cutoff[len - 1 - r];
+    if(r >= a->nd || a->d[r] != ch)
+    {
+      if(r >= a->nd || a->d[r] < ch)
+        delta--;
+      break;
+    }
+  }
 
-  cjson_stringify_value(&c, &v);
+  r = a->nd;
+  w = a->nd + delta;
+  n = 0;
+  for(r--; r >= 0; r--)
+  {
+    uint64_t quo, rem;
+    n += (uint64_t)(a->d[r] - '0') << k;
+    quo = n / 10;
+    rem = n - 10 * quo;
+    w--;
+    if(w < CJSON_DECIMAL_DIGITS)
+      a->d[w] = (char)(rem + '0');
+    else if(rem != 0)
+      a->trunc = 1;
+    n = quo;
+  }
 
-  if(length)
-    *length = c.top;
+  while(n > 0)
+  {
+    uint64_t quo = n / 10, rem = n - 10 * quo;
+    w--;
+    if(w < CJSON_DECIMAL_DIGITS)
+      a->d[w] = (char)(rem + '0');
+    else if(rem != 0)
+      a->trunc = 1;
+    n = quo;
+  }
 
-  *(char*)cjson_push(&c, sizeof(char)) = '\0';
+  a->nd += delta;
+  if(a->nd >= CJSON_DECIMAL_DIGITS)
+    a->nd = CJSON_DECIMAL_DIGITS;
+  a->dp += delta;
+  cjson_decimal_trim(a);
+}
 
-  return c.stack;
+static void cjson_decimal_shift(cjson_decimal *a, int k)
+{
+  if(a->nd == 0)
+    return;
+  for(; k > CJSON_DECIMAL_SHIFT; k -= CJSON_DECIMAL_SHIFT)
+    cjson_decimal_left_shift(a, CJSON_DECIMAL_SHIFT);
+  for(; k < -CJSON_DECIMAL_SHIFT; k += CJSON_DECIMAL_SHIFT)
+    cjson_decimal_right_shift(a, CJSON_DECIMAL_SHIFT);
+  if(k > 0)
+    cjson_decimal_left_shift(a, k);
+  else if(k < 0)
+    cjson_decimal_right_shift(a, -k);
 }
 
-CJSON_STATUS cjson_parse(cjson_value* v, const char *json)
+static uint64_t cjson_decimal_rounded_integer(const cjson_decimal *a)   //整数部分，小数部分四舍六入五成双
 {
-  CJSON_STATUS ret;
-  cjson_context c = {0};
-  c.json = json;
-  c.stack = NULL;
-  c.size = c.top = 0;
+  uint64_t n = 0;
+  int i, up;
+
+  if(a->dp > 20)
+    return UINT64_MAX;
+  for(i = 0; i < a->dp && i < a->nd; i++)
+    n = n * 10 + (a->d[i] - '0');
+  for(; i < a->dp; i++)
+    n *= 10;
+
+  if(a->dp < 0 || a->dp >= a->nd)
+    up = 0;
+  else if(a->d[a->dp] == '5' && a->dp + 1 == a->nd)   //正好一半，有截断说明比一半大，否则取偶数
+    up = a->trunc || (a->dp > 0 && (a->d[a->dp - 1] - '0') % 2 != 0);
+  else
+    up = a->d[a->dp] >= '5';
+  return n + up;
+}
 
-  cjson_value_init(v);
+static int cjson_decimal_to_double(cjson_decimal *a, double *out)  //返回0表示溢出
+{
+  static const int powtab[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };   //10^i 大约需要的二进制位数
+  uint64_t mant, bits;
+  int exp = 0, n;
 
-  if((ret = cjson_parse_value(&c, v)) == CJSON_OK)
+  if(a->nd == 0 || a->dp < -330)  //0或者下溢
   {
-    cjson_parse_skip_space(&c);
-    if(*c.json != '\0')
+    *out = 0.0;
+    return 1;
+  }
+  if(a->dp > 310)
+    return 0;
+
+  while(a->dp > 0)  //移位到 [0.5, 1) 区间
+  {
+    n = a->dp >= 9 ? 27 : powtab[a->dp];
+    cjson_decimal_shift(a, -n);
+    exp += n;
+  }
+  while(a->dp < 0 || (a->dp == 0 && a->d[0] < '5'))
+  {
+    n = -a->dp >= 9 ? 27 : powtab[-a->dp];
+    cjson_decimal_shift(a, n);
+    exp -= n;
+  }
+  exp--;    //double的尾数在 [1, 2) 区间
+
+  if(exp < -1022)   //非规格化数
+  {
+    n = -1022 - exp;
+    cjson_decimal_shift(a, -n);
+    exp += n;
+  }
+  if(exp + 1023 >= 0x7ff)
+    return 0;
+
+  cjson_decimal_shift(a, 53);   //取出53位尾数
+  mant = cjson_decimal_rounded_integer(a);
+  if(mant == ((uint64_t)2 << 52))  //舍入进位
+  {
+    mant >>= 1;
+    exp++;
+    if(exp + 1023 >= 0x7ff)
+      return 0;
+  }
+  if((mant & ((uint64_t)1 << 52)) == 0)  //非规格化数的指数
+    exp = -1023;
+
+  bits = (mant & (((uint64_t)1 << 52) - 1)) | ((uint64_t)(exp + 1023) << 52);
+  memcpy(out, &bits, sizeof(double));
+  return 1;
+}
+
+static int cjson_decimal_from_string(cjson_decimal *a, const char *p, const char *end) //p已经通过语法检查，不含符号
+{
+  int64_t n = 0;    //有效数字的位数，包括超出d被丢弃的数字
+  int64_t dp = 0;
+  int64_t e = 0;
+  int saw_dot = 0;
+  int esign = 1;
+
+  a->nd = a->trunc = 0;
+  for(; p < end; p++)
+  {
+    if(*p == '.')
     {
-      v->type = CJSON_NULL;
-      ret = CJSON_ERR_ROOT_NOT_SINGULAR;
+      saw_dot = 1;
+      dp = n;
+    }
+    else if(IS0TO9(*p))
+    {
+      if(*p == '0' && n == 0)   //前导0
+        dp--;
+      else
+      {
+        if(a->nd < CJSON_DECIMAL_DIGITS)
+          a->d[a->nd++] = *p;
+        else if(*p != '0')
+          a->trunc = 1;
+        n++;    //丢弃的整数部分数字也要计入小数点的位置
+      }
     }
+    else
+      break;
   }
-  assert(c.top == 0);
-  free(c.stack);
-  return ret;
+  if(!saw_dot)
+    dp = n;
+
+  if(p < end && (*p == 'e' || *p == 'E'))
+  {
+    p++;
+    if(*p == '+' || *p == '-')
+      esign = *p++ == '-' ? -1 : 1;
+    for(; p < end && IS0TO9(*p); p++)
+      if(e < ((int64_t)1 << 40))
+        e = e * 10 + (*p - '0');
+    dp += e * esign;
+  }
+  //超出这个范围的结果一定是0或者无穷大，限制之后dp不会溢出int
+  a->dp = dp < -100000 ? -100000 : dp > 100000 ? 100000 : (int)dp;
+  return 0;
 }
 
-void cjson_value_free(cjson_value *value)   //释放value申请的内存，主要针对str，arr，obj类型
+static int cjson_number_to_integer(cjson_value *v, uint64_t mant, int64_t exp10, int neg, char last)  //整数字面量能放进int64/uint64时精确保存，返回0表示放不下
 {
-  assert(value != NULL);
+  if(exp10 == 0 && !neg)
+  {
+    v->u.u64 = mant;
+    v->flags |= mant <= (uint64_t)INT64_MAX ? CJSON_FLAG_INT64 : CJSON_FLAG_UINT64;
+    return 1;
+  }
+  if(exp10 == 0 && mant <= (uint64_t)1 << 63)
+  {
+    v->u.i64 = -(int64_t)(mant - 1) - 1;  //mant为2^63时直接取负会溢出
+    v->flags |= CJSON_FLAG_INT64;
+    return 1;
+  }
+  if(exp10 == 1 && !neg &&
+     (mant < UINT64_MAX / 10 || (mant == UINT64_MAX / 10 && (uint64_t)(last - '0') <= UINT64_MAX % 10)))  //20位的数，最后一位last没有放进mant
+  {
+    v->u.u64 = mant * 10 + (uint64_t)(last - '0');
+    v->flags |= CJSON_FLAG_UINT64;
+    return 1;
+  }
+  return 0;
+}
+
+static CJSON_STATUS cjson_parse_number(cjson_context *c, cjson_value *v)
+{
+  const char *p = c->json, *end = c->end, *digits, *int_end;
+  uint64_t mant = 0;    //前19位有效数字
+  int nd = 0, trunc = 0, neg = 0;   //有效数字位数，是否有没放进mant的非零数字
+  int64_t exp10 = 0, e = 0;
+  double d;
+  // char ch = *p;
 
-  switch(value->type)
+  if(p < end && *p == '-')
   {
-    case CJSON_STRING:
-      value->u.str.l = 0;
-      free(value->u.str.buf);
-      break;
-    case CJSON_ARRAY:
-      for(size_t i = 0; i < value->u.arr.size; i++)
+    p++;
+    neg = 1;
+  }
+    // ch = *(++p);  //指针运算，*运算优先级低于 p++，因此先自增，再解指针，*p++先取p值，解指针，p再自增
+                    //https://blog.csdn.net/weixin_41413441/article/details/80849827
+  digits = p;
+
+  if(p < end && *p == '0')
+    p++;
+  else
+  {
+    if(p == end || !IS0TO9(*p))
+      return CJSON_ERR_LITERAL;   //文字错误，switch的default分支默认解析数字
+    // while(IS0TO9(*p++));       //bug //这里IS0TO9()宏中如果有自增的话会自增两次，宏定义的原因
+    for(; p < end && IS0TO9(*p); p++)   //验证语法的同时累加尾数
+    {
+      if(nd < 19)
       {
-        cjson_value_free(&(value->u.arr.elements[i]));
+        mant = mant * 10 + (*p - '0');
+        nd++;
       }
-      value->u.arr.size = 0;
-      free(value->u.arr.elements);
-      break;
-    case CJSON_OBJECT:
-      for(size_t i = 0; i < value->u.obj.size; i++)
+      else
+      {
+        exp10++;    //整数部分放不下的数字
+        trunc |= *p != '0';
+      }
+    }
+  }
+  int_end = p;
+
+  if(p < end && *p == '.')
+  {
+    p++;
+    if(p == end || !IS0TO9(*p))
+      return CJSON_ERR_LITERAL;
+    for(; p < end && IS0TO9(*p); p++)
+    {
+      if(nd < 19)
       {
-        free(value->u.obj.members[i].key);
-        value->u.obj.members[i].key_len = 0;
-        cjson_value_free(&value->u.obj.members[i].value);
+        mant = mant * 10 + (*p - '0');
+        exp10--;
+        if(mant != 0)   //小数部分的前导0不算有效数字
+          nd++;
       }
+      else
+        trunc |= *p != '0';
+    }
+  }
 
-      value->u.obj.size = 0;
-      break;
+  if(p < end && (*p == 'e' || *p == 'E'))
+  {
+    int esign = 1;
+    p++;
+    if (p < end && (*p == '+' || *p == '-'))
+      esign = *p++ == '-' ? -1 : 1;
+    if(p == end || !IS0TO9(*p))
+      return CJSON_ERR_LITERAL;
+    for(; p < end && IS0TO9(*p); p++)
+      if(e < 100000)  //再大的指数结果也只是溢出或者下溢
+        e = e * 10 + (*p - '0');
+    exp10 += esign * e;
+  }
+
+  if(p != int_end || (neg && mant == 0) || !cjson_number_to_integer(v, mant, exp10, neg, p[-1]))  //有小数或指数、-0或者放不下时按double保存
+  {
+    if(mant == 0 && !trunc)
+      d = 0.0;
+    else if(!trunc && (mant >> 53) == 0 && exp10 >= -22 && exp10 <= 22 + 15 &&
+            (exp10 <= 22 || (double)mant * cjson_pow10[exp10 - 22] <= 1e15))  //快速路径，尾数和10的幂都是精确的
+    {
+      d = (double)mant;
+      if(exp10 < 0)
+        d /= cjson_pow10[-exp10];
+      else if(exp10 > 22)
+        d = d * cjson_pow10[exp10 - 22] * 1e22;
+      else
+        d *= cjson_pow10[exp10];
+    }
+    else
+    {
+      cjson_decimal dec;
+      cjson_decimal_from_string(&dec, digits, p);
+      if(!cjson_decimal_to_double(&dec, &d))
+        return CJSON_ERR_NUMBER_TOO_BIG;
+    }
+    v->u.num = neg ? -d : d;
   }
 
-  value->type = CJSON_NULL;
+  v->type = CJSON_NUMBER;
+  c->json = p;
+
+  return CJSON_OK;
 }
 
-int cjson_is_equal(const cjson_value* lhs, const cjson_value* rhs)
+
+static CJSON_STATUS cjson_parse_4hex(const char *p, const char *end, uint16_t *hex)
 {
-  assert(lhs != NULL && rhs != NULL);
-  int ret = 0;
+  assert(p != NULL);
+  assert(hex != NULL);
 
-  if(lhs->type != rhs->type)
-    return 0;
+  if(end - p < 4)
+    return CJSON_ERR_UNICODE_HEX;
 
-  switch(lhs->type)
+  *hex = 0;
+  for(char i = 0; i < 4; i++)
   {
-    case CJSON_NULL:
-    case CJSON_TRUE:
-    case CJSON_FALSE:
-      ret = lhs->type == rhs->type;
-      break;
-    case CJSON_NUMBER:
-      ret = lhs->u.num == rhs->u.num;
-      break;
-    case CJSON_STRING:
-      ret = lhs->u.str.l == rhs->u.str.l && !memcmp(lhs->u.str.buf, rhs->u.str.buf, lhs->u.str.l);
-      break;
-    case CJSON_ARRAY:   //arr相同，内部元素顺序必须相同
-      if(!(ret = lhs->u.arr.size == rhs->u.arr.size))
-        break;
-      for(size_t i = 0; i < lhs->u.arr.size; i++)
-        if(!(ret = cjson_is_equal(&lhs->u.arr.elements[i], &rhs->u.arr.elements[i])))
-          break;
-      break;
-    case CJSON_OBJECT:  //obj相同，内部键值对可能顺序不同
-      if(!(ret = (lhs->u.obj.size == rhs->u.obj.size)))
-        break;
-      // for(size_t i = 0; i < lhs->u.obj.size; i++)  //这个不能保证无序键值对相同
-      // {
-      //   if(!(ret = lhs->u.obj.members[i].key_len == rhs->u.obj.members[i].key_len\
-      //         && !memcmp(lhs->u.obj.members[i].key, \
-      //                    rhs->u.obj.members[i].key, \
-      //                    lhs->u.obj.members[i].key_len)))
-      //     break;
-      //   if(!(ret = cjson_is_equal(&lhs->u.obj.members[i].value, &rhs->u.obj.members[i].value)))
-      //     break;
-      // }
-
-      ret = 1;
-      for(size_t i = 0; i < lhs->u.obj.size; i++)
-      {
-        char flag = 0;
-
-        for(size_t j = 0; j < rhs->u.obj.size; j++)
-          if(cjson_is_equal(&lhs->u.obj.members[i].value, &rhs->u.obj.members[j].value))
-            flag = 1;
-        if(flag == 0) //lhs当前元素在r中有没相同的
-        {
-          ret = 0;
-          break;
-        }
-      }
-      break;
+    *hex <<= 4;   //这个必须放在前面，如果放在if后边，最后一次填满16位，又移位，会丢数据
+    if(IS0TO9(*p))
+      *hex |= *p - '0';
+    else if(*p >= 'a' && *p <= 'f')
+      *hex |= *p - 'a' + 10;
+    else if(*p >= 'A' && *p <= 'F')
+      *hex |= *p - 'A' + 10;
+    else
+      return CJSON_ERR_UNICODE_HEX;
+    p++;
   }
-  return ret;
+
+  return CJSON_OK;
 }
 
-void cjson_copy(cjson_value *dest, const cjson_value *src)
+static size_t cjson_encode_utf8(char *buf, uint32_t codepoint)   //码点编码为utf8写入buf，返回字节数
 {
-  assert(dest != NULL && src != NULL);
-  dest->type = src->type;
-  switch(src->type)
+  if(codepoint <= 0x7f)
   {
-    case CJSON_NULL:
-    case CJSON_TRUE:
-    case CJSON_FALSE:
-      break;
-    case CJSON_NUMBER:
-      cjson_set_number(dest, cjson_get_number(*src));
-      break;
-    case CJSON_STRING:
-      cjson_set_string(dest, cjson_get_string(*src), cjson_get_string_length(*src));
-      break;
-    case CJSON_ARRAY:
-      for(size_t i = 0; i < src->u.arr.size; i++)
-      {//这里需要遍历每个元素，递归添加，要保证深度复制就要看数组、字符串、对象元素中的指针指向新的内存
-        cjson_copy(cjson_pushback_array_element(dest), src->u.arr.elements + i);    
-      }
-
-      // size = sizeof(cjson_value) * cjson_get_array_size(*src);
-      // dest->u.arr.elements = (cjson_value *)malloc(size);
-      // memcpy(dest->u.arr.elements, src->u.arr.elements, size);   //这个不能保证是深度复制，数组的元素需要全新的内存，这里可能内存被共享
+    buf[0] = codepoint & 0xff;
+    return 1;
+  }
+  else if(codepoint <= 0x7ff)
+  {
+    buf[0] = 0xc0 | ((codepoint >> 6) & 0x1f);    // 110x xxxx
+    buf[1] = 0x80 | ( codepoint       & 0x3f);    // 10xx xxxx
+    return 2;
+  }
+  else if(codepoint <= 0xffff)
+  {
+    buf[0] = 0xe0 | ((codepoint >> 12) & 0x1f);    // 1110 xxxx
+    buf[1] = 0x80 | ((codepoint >> 6)  & 0x3f);    // 10xx xxxx
+    buf[2] = 0x80 | ( codepoint        & 0x3f);    // 10xx xxxx
+    return 3;
+  }
+  else
+  {
+    assert(codepoint <= 0x10ffff);
+    buf[0] = 0xf0 | ((codepoint >> 18) & 0x07);    // 1111 0xxx
+    buf[1] = 0x80 | ((codepoint >> 12) & 0x3f);    // 10xx xxxx
+    buf[2] = 0x80 | ((codepoint >> 6)  & 0x3f);    // 10xx xxxx
+    buf[3] = 0x80 | ( codepoint        & 0x3f);    // 10xx xxxx
+    return 4;
+  }
+}
+
+//解析出来的字符串长度不包括c语言规定的结尾字节 '\0'
+//原地解析时字符串直接解码到输入缓冲区中(解码后不会比原文长)，*s指向缓冲区，否则*s指向栈，调用者需要立即复制
+static CJSON_STATUS cjson_parse_string_raw(cjson_context *c, const char **s, size_t *l)
+{
+  #define RETURN_STRING_ERR(err_code) do{c->top = head; c->json = p; return err_code;}while(0)   //c->json指向出错的位置
+  #define STRING_PUT(ch) do{ if(w) *w++ = (ch); else PUSH_CHAR_TO_STACK(c, ch); }while(0)
+
+  size_t len, head = c->top;
+  const char *p = c->json;
+  char *w = NULL, *start = NULL;  //原地解析时的写指针，总是落后于读指针p
+  const char *escape = NULL;  //当前转义序列的反斜杠，转义出错时c->json指向这里
+  unsigned char ch = 0;
+  uint16_t hex = 0;   //utf8高代理项、BMP平面内码点
+  uint32_t codepoint = 0; //utf8码点
+  char utf8[4];
+
+  if(p < c->end && *p == '\"')
+    p++;
+  else
+    RETURN_STRING_ERR(CJSON_ERR_STRING_MISS_QUOTATION_MARK);
+
+  if(c->token != NULL)  //两阶段解析，开始引号后的第一个记录是结束引号时中间没有要处理的字符，直接取这一段
+  {
+    const char *q;
+    while(c->begin + *c->token < p)
+      c->token++;
+    q = c->begin + *c->token;
+    if(q < c->end && *q == '\"')
+    {
+      if(c->insitu)
+        *(char *)q = '\0';
+      *s = p;
+      *l = q - p;
+      c->token++;
+      c->json = q + 1;
+      CJSON_STAT(c, st_->string_bytes += *l);
+      return CJSON_OK;
+    }
+  }
+
+  if(c->insitu)
+    w = start = (char *)p;
+
+  while(1)
+  {
+    if(c->token != NULL)  //两阶段解析时下一个记录就是下一个引号、反斜杠或控制字符，不用再扫描
+    {
+      while(c->begin + *c->token < p)
+        c->token++;
+      len = c->begin + *c->token - p;
+    }
+    else
+      len = cjson_scan_string(p, c->end);   //成块复制不需要转义的字符，只有遇到特殊字符才进入下面的switch
+    if(len > 0)
+    {
+      if(w == NULL)
+        memcpy(cjson_push(c, len), p, len);
+      else if(w != p)
+        memmove(w, p, len);
+      if(w)
+        w += len;
+      p += len;
+    }
+
+    if(p == c->end)   //到达结尾还没有遇到结束引号
+      RETURN_STRING_ERR(CJSON_ERR_STRING_MISS_QUOTATION_MARK);
+
+    ch = *p++;
+    switch (ch) //规则检查
+    {
+      case '\\':  //转义字符
+        // p++;
+        escape = p - 1;
+        CJSON_STAT(c, st_->escapes++);
+        if(p == c->end)
+          RETURN_STRING_ERR(CJSON_ERR_STRING_MISS_QUOTATION_MARK);
+        switch (*p++)
+        {
+          case 'b':  STRING_PUT('\b'); break;
+          case 'f':  STRING_PUT('\f'); break;
+          case 'r':  STRING_PUT('\r'); break;
+          case 'n':  STRING_PUT('\n'); break;
+          case 't':  STRING_PUT('\t'); break;
+          case '\\': STRING_PUT('\\'); break;
+          case '\"': STRING_PUT('\"'); break;
+          case '/':  STRING_PUT('/');  break;
+          case 'u':
+            if(cjson_parse_4hex(p, c->end, &hex) != CJSON_OK)
+              { p = escape; RETURN_STRING_ERR(CJSON_ERR_UNICODE_HEX); }
+            p += 4;
+            codepoint = hex;
+
+            if(hex >= 0xd800 && hex <= 0xdbff)  //hex为高代理项
+            {
+              uint16_t hex2 = 0;
+              if(c->end - p < 2 || p[0] != '\\' || p[1] != 'u')   //代理项出错时指向高代理项的转义
+                { p = escape; RETURN_STRING_ERR(CJSON_ERR_UNICODE_SURROGATE); }
+              p += 2;
+
+              if(cjson_parse_4hex(p, c->end, &hex2) != CJSON_OK)  //hex2 为低代理项
+                { p -= 2; RETURN_STRING_ERR(CJSON_ERR_UNICODE_HEX); }
+              if (hex2 < 0xDC00 || hex2 > 0xDFFF)
+                { p = escape; RETURN_STRING_ERR(CJSON_ERR_UNICODE_SURROGATE); }
+              p += 4;
+
+              codepoint = 0x10000 + (hex - 0xd800) * 0x400 + (hex2 - 0xdc00);
+            }
+            len = cjson_encode_utf8(utf8, codepoint);   //utf-8
+            if(w)
+              w = (char *)memcpy(w, utf8, len) + len;
+            else
+              memcpy(cjson_push(c, len), utf8, len);
+            break;
+          default:
+            p = escape;
+            RETURN_STRING_ERR(CJSON_ERR_STRING_INVALID_ESCAPE);
+        }
+        break;
+
+      default:    //普通合法字符
+        if(ch < 0x20)
+        {
+          p--;
+          RETURN_STRING_ERR(CJSON_ERR_STRING_INVALID_CAHR);
+        }
+        else
+          STRING_PUT(ch);
+        break;
+
+      case '\"':  //字符串结束引号
+        if(w)
+        {
+          *w = '\0';    //写指针最多到结束引号的位置
+          *s = start;
+          *l = w - start;
+        }
+        else
+        {
+          len = c->top - head;
+          // cjson_set_string(v, (const char *)cjson_pop(c, len), len);
+          *s = (const char *)cjson_pop(c, len);
+          *l = len;
+        }
+        CJSON_STAT(c, st_->string_bytes += *l);
+        // c->json = ++p;
+        c->json = p++;
+        return CJSON_OK;
+        break;
+    }
+  }
+  #undef STRING_PUT
+  #undef RETURN_STRING_ERR
+}
+
+static void cjson_set_string_raw(const cjson_allocator *a, cjson_arena *arena, cjson_value *value, const char *buf, size_t len)
+{
+  value->type = CJSON_STRING;
+  value->flags = arena ? CJSON_FLAG_ARENA : 0;
+  value->u.str.buf = cjson_malloc(a, arena, len + 1);
+
+  if(len > 0)
+    memcpy(value->u.str.buf, buf, len);
+  value->u.str.buf[len] = '\0';
+  value->u.str.l = len;
+}
+
+static CJSON_STATUS cjson_parse_string(cjson_context *c, cjson_value *v)
+{
+  const char *s;
+  size_t len;
+  CJSON_STATUS ret;
+
+  if((ret = cjson_parse_string_raw(c, &s, &len)) != CJSON_OK)
+    return ret;
+
+  if(c->insitu)   //直接指向输入缓冲区，不复制
+  {
+    v->type = CJSON_STRING;
+    v->flags |= CJSON_FLAG_INSITU;
+    v->u.str.buf = (char *)s;
+    v->u.str.l = len;
+  }
+  else
+  {
+    cjson_set_string_raw(c->allocator, c->arena, v, s, len);
+    CJSON_STAT(c, st_->heap_bytes += len + 1);
+  }
+  return ret;
+}
+
+//---------------------------延迟解析---------------------------//
+//数组和对象先只用括号匹配找到结尾，记录为片段，第一次访问时只解析一层，里面的数组和对象继续延迟
+//按值传入的接口(cjson_get_array_element()等)把解析结果缓存在片段中，修改数组和对象的接口把结果放回值本身
+
+struct cjson_lazy__
+{
+  const char *json;   //片段在输入中的开始('['或'{')和长度
+  size_t len;
+  size_t depth;       //片段之外还有几层
+  int parsed;
+  CJSON_STATUS status;  //解析这一层的结果
+  cjson_value value;    //parsed为1时是解析出的这一层，出错时为空容器
+};
+
+static CJSON_STATUS cjson_skip_container(cjson_context *c, size_t max_depth)  //c->json指向'['或'{'，跳到匹配的结尾之后，只检查括号、层数和字符串
+{
+  uint64_t objects[(CJSON_MAX_DEPTH + 63) / 64];   //每一层是不是对象
+  const char *p = c->json, *end = c->end;
+  size_t depth = 0;
+  int object;
+
+  assert(max_depth <= CJSON_MAX_DEPTH);
+  for(; p < end; p++)
+  {
+    switch(*p)
+    {
+      case '[':
+      case '{':
+        if(depth == max_depth)
+          return CJSON_ERR_DEPTH;
+        if(*p == '{')
+          objects[depth / 64] |= (uint64_t)1 << (depth % 64);
+        else
+          objects[depth / 64] &= ~((uint64_t)1 << (depth % 64));
+        depth++;
+        break;
+      case ']':
+      case '}':
+        object = (objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+        if(object != (*p == '}'))
+          return object ? CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET : CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET;
+        if(--depth == 0)
+        {
+          c->json = p + 1;
+          return CJSON_OK;
+        }
+        break;
+      case '\"':  //字符串中的括号不算，成块跳过不需要处理的字符
+        for(p++; ; p++)
+        {
+          p += cjson_scan_string(p, end);
+          if(p == end)
+            return CJSON_ERR_STRING_MISS_QUOTATION_MARK;
+          if(*p == '\"')
+            break;
+          if(*p != '\\')
+            return CJSON_ERR_STRING_INVALID_CAHR;
+          if(++p == end)
+            return CJSON_ERR_STRING_MISS_QUOTATION_MARK;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  object = (objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+  return object ? CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET : CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET;
+}
+
+static CJSON_STATUS cjson_parse_lazy_value(cjson_context *c, cjson_value *v, size_t max_depth, size_t depth)  //把数组或对象记录为片段，depth是外面已经打开的层数
+{
+  const char *start = c->json;
+  cjson_lazy *lazy;
+  CJSON_STATUS ret;
+
+  if((ret = cjson_skip_container(c, max_depth)) != CJSON_OK)
+    return ret;
+
+  lazy = (cjson_lazy *)CJSON_MALLOC(c->allocator, sizeof(cjson_lazy));
+  lazy->json = start;
+  lazy->len = c->json - start;
+  lazy->depth = c->lazy_depth + depth;
+  lazy->parsed = 0;
+  lazy->status = CJSON_OK;
+  v->type = *start == '[' ? CJSON_ARRAY : CJSON_OBJECT;
+  v->flags |= CJSON_FLAG_LAZY;
+  v->u.lazy = lazy;
+  return CJSON_OK;
+}
+
+static CJSON_STATUS cjson_parse_value(cjson_context *c, cjson_value *v);
+static void cjson_lazy_parse(cjson_lazy *lazy)  //解析片段的这一层，只解析一次
+{
+  cjson_context c = {0};
+  cjson_value *v = &lazy->value;
+
+  if(lazy->parsed)
+    return;
+  c.allocator = &cjson_global_allocator;
+  c.json = lazy->json;
+  c.end = lazy->json + lazy->len;
+  c.max_depth = CJSON_MAX_DEPTH - lazy->depth;
+  c.lazy = 2;   //片段本身这一层解析，里面的继续延迟
+  c.lazy_depth = lazy->depth;
+
+  if((lazy->status = cjson_parse_value(&c, v)) == CJSON_OK)
+  {
+    cjson_parse_skip_space(&c);
+    if(c.json != c.end)   //括号匹配过，不会出现
+    {
+      cjson_value_free(v);
+      lazy->status = CJSON_ERR_ROOT_NOT_SINGULAR;
+    }
+  }
+  if(lazy->status != CJSON_OK)  //出错时为空容器
+  {
+    v->flags = 0;
+    v->type = lazy->json[0] == '[' ? CJSON_ARRAY : CJSON_OBJECT;
+    memset(&v->u, 0, sizeof(v->u));
+  }
+  if(c.stack)
+    CJSON_FREE(c.allocator, c.stack);
+  lazy->parsed = 1;
+}
+
+static const cjson_value *cjson_lazy_get(const cjson_value *v)  //延迟解析的值返回缓存的这一层，其他值返回v本身
+{
+  if(!(v->flags & CJSON_FLAG_LAZY))
+    return v;
+  cjson_lazy_parse(v->u.lazy);
+  return &v->u.lazy->value;
+}
+
+static void cjson_lazy_resolve(cjson_value *v)  //解析这一层并放回v中，之后v是普通的数组或对象，之前取得的元素指针仍然有效
+{
+  cjson_lazy *lazy;
+
+  if(!(v->flags & CJSON_FLAG_LAZY))
+    return;
+  lazy = v->u.lazy;
+  cjson_lazy_parse(lazy);
+  *v = lazy->value;
+  CJSON_FREE(&cjson_global_allocator, lazy);
+}
+
+//解析不递归：打开数组或对象时在栈上压入一帧，之后完成的元素(成员)压在帧的上面，容器结束时和帧一起出栈
+//帧通过parent连起来，栈中的值、成员和帧的大小都是8的倍数，可以直接按指针访问
+
+#define CJSON_NO_FRAME ((size_t)-1)
+
+typedef struct
+{
+  size_t parent;    //外层帧在栈中的位置，CJSON_NO_FRAME表示这是最外层
+  size_t size;      //已经完成的元素(成员)个数，都在帧的上面
+  char *key;        //对象中正在解析的成员的key
+  size_t key_len;
+  cjson_type type;  //CJSON_ARRAY或CJSON_OBJECT
+}cjson_parse_frame;
+
+#define CJSON_FRAME(c, pos) ((cjson_parse_frame *)((c)->stack + (pos)))   //压栈可能让栈重新分配，之后要重新取帧
+
+static CJSON_STATUS cjson_parse_key(cjson_context *c, size_t frame)  //解析对象成员的key和冒号，key放到帧中
+{
+  cjson_parse_frame *f;
+  const char *str;
+  size_t len;
+  CJSON_STATUS ret;
+
+  if(PEEK(c) != '\"')
+    return CJSON_ERR_OBJECT_NEED_KEY;
+  if((ret = cjson_parse_string_raw(c, &str, &len)) != CJSON_OK)   //这里先解析字符串，成功之后再申请内存放到帧中
+    return ret;
+
+  f = CJSON_FRAME(c, frame);
+  f->key_len = len;
+  if(c->insitu)   //key已经在输入缓冲区中以'\0'结尾
+    f->key = (char *)str;
+  else
+  {
+    f->key = (char *)cjson_malloc(c->allocator, c->arena, len + 1);
+    if(len > 0)  //空key时str可能为NULL
+      memcpy(f->key, str, len);
+    f->key[len] = '\0';
+    CJSON_STAT(c, st_->heap_bytes += len + 1);
+  }
+
+  cjson_parse_skip_space(c);
+  if(PEEK(c) != ':')
+    return CJSON_ERR_OBJECT_NEED_COLON;
+  c->json++;
+  return CJSON_OK;
+}
+
+static void cjson_parse_emit(cjson_context *c, size_t frame, const cjson_value *v)  //一个值完成，压到外层容器的帧上
+{
+  cjson_parse_frame *f;
+  cjson_member *m;
+
+  if(CJSON_FRAME(c, frame)->type == CJSON_ARRAY)
+    memcpy(cjson_push(c, sizeof(cjson_value)), v, sizeof(cjson_value));
+  else
+  {
+    m = (cjson_member *)cjson_push(c, sizeof(cjson_member));
+    f = CJSON_FRAME(c, frame);
+    m->key = f->key;
+    m->key_len = f->key_len;
+    m->value = *v;
+    f->key = NULL;  //所有权转移到栈上的成员
+  }
+  CJSON_FRAME(c, frame)->size++;
+}
+
+static void cjson_parse_close(cjson_context *c, size_t *frame, cjson_value *v)  //最内层容器结束，元素和帧出栈，结果放到v中
+{
+  cjson_parse_frame *f = CJSON_FRAME(c, *frame);
+  size_t size = f->size, parent = f->parent;
+
+  v->type = f->type;
+  if(f->type == CJSON_ARRAY)
+  {
+    v->u.arr.size = v->u.arr.capacity = size;
+    size *= sizeof(cjson_value);
+    v->u.arr.elements = size > 0 ? (cjson_value *)memcpy(cjson_malloc(c->allocator, c->arena, size), cjson_pop(c, size), size) : NULL;  //压栈，出栈的长度单位都是字节
+    CJSON_STAT(c, st_->heap_bytes += size);
+  }
+  else
+  {
+    if(c->insitu && size > 0)
+      v->flags |= CJSON_FLAG_INSITU;
+    v->u.obj.size = v->u.obj.capacity = size;
+    size *= sizeof(cjson_member);
+    v->u.obj.members = size > 0 ? (cjson_member *)memcpy(cjson_malloc(c->allocator, c->arena, size), cjson_pop(c, size), size) : NULL;
+    v->u.obj.index = v->u.obj.size >= CJSON_OBJECT_INDEX_THRESHOLD ? cjson_index_build(c->allocator, c->arena, v->u.obj.members, v->u.obj.size) : NULL;
+    CJSON_STAT(c, st_->heap_bytes += size + (v->u.obj.index ? sizeof(cjson_object_index) + (v->u.obj.index->mask + 1) * sizeof(cjson_index_slot) : 0));
+  }
+  c->top = *frame;
+  *frame = parent;
+}
+
+static void cjson_parse_unwind(cjson_context *c, size_t frame)  //出错时从内向外释放所有还没有结束的容器
+{
+  int owned = c->arena == NULL && !c->insitu;   //arena中的内存不能单独释放，原地解析的key在输入缓冲区中
+
+  while(frame != CJSON_NO_FRAME)
+  {
+    cjson_parse_frame *f = CJSON_FRAME(c, frame);
+
+    for(size_t i = 0; i < f->size; i++)
+    {
+      if(f->type == CJSON_ARRAY)
+        cjson_value_free_with_allocator(c->allocator, (cjson_value *)cjson_pop(c, sizeof(cjson_value)));
+      else
+      {
+        cjson_member *m = (cjson_member *)cjson_pop(c, sizeof(cjson_member));
+        if(owned)
+          CJSON_FREE(c->allocator, m->key);
+        cjson_value_free_with_allocator(c->allocator, &m->value);
+      }
+    }
+    if(owned && f->key != NULL)
+      CJSON_FREE(c->allocator, f->key);
+    c->top = frame;
+    frame = f->parent;
+  }
+}
+
+static CJSON_STATUS cjson_parse_value(cjson_context *c, cjson_value *v)
+{
+  size_t frame = CJSON_NO_FRAME, depth = 0, max_depth = c->max_depth > 0 ? c->max_depth : CJSON_MAX_DEPTH;
+  cjson_parse_frame *f;
+  cjson_value value;
+  CJSON_STATUS ret;
+  int open;
+  char ch;
+
+  while(1)
+  {
+    //解析一个值，数组和对象只处理到第一个元素之前
+    value.flags = c->arena ? CJSON_FLAG_ARENA : 0;
+    open = 0;
+
+    cjson_parse_skip_space(c);
+    if(c->json == c->end)
+      ret = CJSON_ERR_MISS_VALUE;
+    else
+    {
+      switch (*(c->json))
+      {
+        case 'n':  ret = cjson_parse_literal(c, &value, "null", CJSON_NULL);   break;
+        case 't':  ret = cjson_parse_literal(c, &value, "true", CJSON_TRUE);   break;
+        case 'f':  ret = cjson_parse_literal(c, &value, "false", CJSON_FALSE); break;
+        case '\"': ret = cjson_parse_string(c, &value); break;
+        case '[':
+        case '{':
+          if(depth == max_depth)
+          {
+            ret = CJSON_ERR_DEPTH;
+            break;
+          }
+          if(c->lazy && depth + 1 >= (size_t)c->lazy)
+          {
+            ret = cjson_parse_lazy_value(c, &value, max_depth - depth, depth);
+            break;
+          }
+          value.type = *c->json++ == '[' ? CJSON_ARRAY : CJSON_OBJECT;
+          cjson_parse_skip_space(c);
+          if(PEEK(c) == (value.type == CJSON_ARRAY ? ']' : '}'))  //空数组、空对象
+          {
+            c->json++;
+            CJSON_STAT(c, if(depth + 1 > st_->max_depth) st_->max_depth = depth + 1);
+            if(value.type == CJSON_ARRAY)
+            {
+              value.u.arr.elements = NULL;
+              value.u.arr.size = value.u.arr.capacity = 0;
+            }
+            else
+            {
+              value.u.obj.members = NULL;
+              value.u.obj.size = value.u.obj.capacity = 0;
+              value.u.obj.index = NULL;
+            }
+            ret = CJSON_OK;
+            break;
+          }
+          f = (cjson_parse_frame *)cjson_push(c, sizeof(cjson_parse_frame));
+          f->parent = frame;
+          f->size = 0;
+          f->key = NULL;
+          f->key_len = 0;
+          f->type = value.type;
+          frame = (char *)f - c->stack;
+          depth++;
+          open = 1;
+          CJSON_STAT(c, if(depth > st_->max_depth) st_->max_depth = depth);
+          ret = value.type == CJSON_OBJECT ? cjson_parse_key(c, frame) : CJSON_OK;
+          break;
+        default:   ret = cjson_parse_number(c, &value); break;
+      }
+    }
+    if(ret != CJSON_OK)
+      break;
+    if(open)
+      continue;
+
+    //值完成，放到外层容器中，容器随之结束时继续向外
+    while(1)
+    {
+      CJSON_STAT(c, st_->nodes[value.type]++);
+      if(frame == CJSON_NO_FRAME)
+      {
+        *v = value;
+        return CJSON_OK;
+      }
+      cjson_parse_emit(c, frame, &value);
+      f = CJSON_FRAME(c, frame);
+
+      cjson_parse_skip_space(c);
+      ch = PEEK(c);
+      if(ch == ',')   //如果逗号之后没有字符了会在下一个值中报错
+      {
+        c->json++;
+        if(f->type == CJSON_OBJECT)
+        {
+          cjson_parse_skip_space(c);
+          ret = cjson_parse_key(c, frame);
+        }
+        break;
+      }
+      if(ch == (f->type == CJSON_ARRAY ? ']' : '}'))
+      {
+        c->json++;
+        value.flags = c->arena ? CJSON_FLAG_ARENA : 0;
+        cjson_parse_close(c, &frame, &value);
+        depth--;
+        continue;
+      }
+      ret = f->type == CJSON_ARRAY ? CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET : CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET;
+      break;
+    }
+    if(ret != CJSON_OK)
+      break;
+  }
+
+  cjson_parse_unwind(c, frame);
+  return ret;
+}
+
+//---------------------------SAX---------------------------//
+//和cjson_parse_value()相同的解析过程，每解析出一个值调用对应的回调，不构造节点，错误码也和DOM解析一致
+//栈中只有每层容器的帧，字符串只在回调期间临时放在帧的上面
+
+#define CJSON_SAX_CALL(h, fn, args) ((h)->fn == NULL || (h)->fn args)   //回调为NULL时当作继续
+
+typedef struct
+{
+  cjson_type type;  //CJSON_ARRAY或CJSON_OBJECT
+  size_t size;      //已经完成的元素(成员)个数
+}cjson_sax_frame;
+
+static CJSON_STATUS cjson_sax_key(cjson_context *c, const cjson_handler *h)  //对象成员的key和冒号
+{
+  CJSON_STATUS ret;
+  const char *key;
+  size_t len;
+
+  if(PEEK(c) != '\"')
+    return CJSON_ERR_OBJECT_NEED_KEY;
+  if((ret = cjson_parse_string_raw(c, &key, &len)) != CJSON_OK)
+    return ret;
+  if(!CJSON_SAX_CALL(h, key_fn, (h->ud, key, len)))
+    return CJSON_ERR_SAX_ABORT;
+
+  cjson_parse_skip_space(c);
+  if(PEEK(c) != ':')
+    return CJSON_ERR_OBJECT_NEED_COLON;
+  c->json++;
+  return CJSON_OK;
+}
+
+static CJSON_STATUS cjson_sax_value(cjson_context *c, const cjson_handler *h)
+{
+  size_t depth = 0, max_depth = c->max_depth > 0 ? c->max_depth : CJSON_MAX_DEPTH;
+  CJSON_STATUS ret;
+  cjson_sax_frame *f;
+  cjson_value v;
+  cjson_type type;
+  const char *str;
+  size_t len;
+  int go, open;   //回调是否要求继续，是否打开了新的一层
+  char ch;
+
+  while(1)
+  {
+    v.flags = 0;
+    go = 1;
+    open = 0;
+    cjson_parse_skip_space(c);
+    if(c->json == c->end)
+      return CJSON_ERR_MISS_VALUE;
+
+    switch (*(c->json))
+    {
+      case 'n':
+        if((ret = cjson_parse_literal(c, &v, "null", CJSON_NULL)) == CJSON_OK)
+          go = CJSON_SAX_CALL(h, null_fn, (h->ud));
+        break;
+      case 't':
+        if((ret = cjson_parse_literal(c, &v, "true", CJSON_TRUE)) == CJSON_OK)
+          go = CJSON_SAX_CALL(h, boolean_fn, (h->ud, 1));
+        break;
+      case 'f':
+        if((ret = cjson_parse_literal(c, &v, "false", CJSON_FALSE)) == CJSON_OK)
+          go = CJSON_SAX_CALL(h, boolean_fn, (h->ud, 0));
+        break;
+      case '\"':
+        if((ret = cjson_parse_string_raw(c, &str, &len)) == CJSON_OK)
+          go = CJSON_SAX_CALL(h, string_fn, (h->ud, str, len));
+        break;
+      case '[':
+      case '{':
+        if(depth == max_depth)
+          return CJSON_ERR_DEPTH;
+        type = *c->json++ == '[' ? CJSON_ARRAY : CJSON_OBJECT;
+        ret = CJSON_OK;
+        if(!(go = type == CJSON_ARRAY ? CJSON_SAX_CALL(h, start_array_fn, (h->ud)) : CJSON_SAX_CALL(h, start_object_fn, (h->ud))))
+          break;
+        cjson_parse_skip_space(c);
+        if(PEEK(c) == (type == CJSON_ARRAY ? ']' : '}'))
+        {
+          c->json++;
+          go = type == CJSON_ARRAY ? CJSON_SAX_CALL(h, end_array_fn, (h->ud, 0)) : CJSON_SAX_CALL(h, end_object_fn, (h->ud, 0));
+          break;
+        }
+        f = (cjson_sax_frame *)cjson_push(c, sizeof(cjson_sax_frame));
+        f->type = type;
+        f->size = 0;
+        depth++;
+        open = 1;
+        if(type == CJSON_OBJECT)
+          ret = cjson_sax_key(c, h);
+        break;
+      default:
+        if((ret = cjson_parse_number(c, &v)) == CJSON_OK)
+          go = CJSON_SAX_CALL(h, number_fn, (h->ud, &v));
+        break;
+    }
+    if(ret != CJSON_OK)
+      return ret;
+    if(!go)
+      return CJSON_ERR_SAX_ABORT;
+    if(open)
+      continue;
+
+    //值完成，容器随之结束时继续向外
+    while(1)
+    {
+      if(depth == 0)
+        return CJSON_OK;
+      f = (cjson_sax_frame *)(c->stack + c->top) - 1;
+      f->size++;
+
+      cjson_parse_skip_space(c);
+      ch = PEEK(c);
+      if(ch == ',')
+      {
+        c->json++;
+        if(f->type == CJSON_OBJECT)
+        {
+          cjson_parse_skip_space(c);
+          if((ret = cjson_sax_key(c, h)) != CJSON_OK)
+            return ret;
+        }
+        break;
+      }
+      if(ch != (f->type == CJSON_ARRAY ? ']' : '}'))
+        return f->type == CJSON_ARRAY ? CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET : CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET;
+      c->json++;
+      c->top -= sizeof(cjson_sax_frame);
+      depth--;
+      if(!(f->type == CJSON_ARRAY ? CJSON_SAX_CALL(h, end_array_fn, (h->ud, f->size)) : CJSON_SAX_CALL(h, end_object_fn, (h->ud, f->size))))
+        return CJSON_ERR_SAX_ABORT;
+    }
+  }
+}
+
+static CJSON_STATUS cjson_sax_context(cjson_context *c, const cjson_handler *h, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  assert(h != NULL);
+  assert(json != NULL || len == 0);
+  c->json = json;
+  c->end = json + len;
+  c->top = 0;
+
+  if((ret = cjson_sax_value(c, h)) == CJSON_OK)
+  {
+    cjson_parse_skip_space(c);
+    if(c->json != c->end)
+      ret = CJSON_ERR_ROOT_NOT_SINGULAR;
+  }
+  c->top = 0;   //出错时栈上可能还有字符串
+  return ret;
+}
+
+//---------------------------数字格式化---------------------------//
+//Grisu2：用64位的浮点近似和缓存的10的幂生成数字，结果一定能往返，绝大多数情况下也是最短的
+//不依赖sprintf和locale，布局和 %.17g 一致：指数小于-4或不小于17时用科学计数法
+
+typedef struct
+{
+  uint64_t f;
+  int e;
+}cjson_diyfp;   //值为 f * 2^e
+
+static const uint64_t cjson_cached_powers_f[] = {  //10^-348, 10^-340, ..., 10^340 规范化后的64位尾数
+  0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+  0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+  0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+  0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+  0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+  0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+  0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+  0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+  0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+  0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+  0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+  0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+  0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+  0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+  0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+  0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+  0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+  0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+  0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+  0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+  0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+  0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+  0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+  0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+  0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+  0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+  0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+  0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+  0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+static const int16_t cjson_cached_powers_e[] = {
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+  -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+  -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+  -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+  56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+  694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+  1013, 1039, 1066
+};
+
+static const uint64_t cjson_pow10_u64[] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+  10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+  1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+  10000000000000000000ULL
+};
+
+static cjson_diyfp cjson_diyfp_normalize(cjson_diyfp x) //最高位移到第63位，x.f不能为0
+{
+#if defined(__GNUC__)
+  int s = __builtin_clzll(x.f);
+  x.f <<= s;
+  x.e -= s;
+#else
+  while(!(x.f & ((uint64_t)1 << 63)))
+  {
+    x.f <<= 1;
+    x.e--;
+  }
+#endif
+  return x;
+}
+
+static cjson_diyfp cjson_diyfp_mul(cjson_diyfp x, cjson_diyfp y)  //128位乘积的高64位，四舍五入
+{
+  const uint64_t m32 = 0xFFFFFFFF;
+  uint64_t a = x.f >> 32, b = x.f & m32, c = y.f >> 32, d = y.f & m32;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32) + ((uint64_t)1 << 31);
+  cjson_diyfp r;
+
+  r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+static cjson_diyfp cjson_cached_power(int e, int *k)  //取10^-k，使乘积的二进制指数落在[-60, -32]
+{
+  double dk = (-61 - e) * 0.30102999566398114 + 347;  //ceil((-61 - e) * log10(2)) + 347，保持为正数再取整
+  int ik = (int)dk;
+  unsigned int index;
+  cjson_diyfp r;
+
+  if(dk - ik > 0.0)
+    ik++;
+  index = (unsigned int)((ik >> 3) + 1);
+  *k = -(-348 + (int)(index << 3));
+  r.f = cjson_cached_powers_f[index];
+  r.e = cjson_cached_powers_e[index];
+  return r;
+}
+
+static void cjson_grisu_round(char *buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)  //把最后一位往w靠近
+{
+  while(rest < wp_w && delta - rest >= ten_kappa &&
+        (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+  {
+    buf[len - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+static int cjson_grisu_digits(cjson_diyfp w, cjson_diyfp mp, uint64_t delta, char *buf, int *k)  //生成[mp - delta, mp]内最短的数字，返回位数
+{
+  cjson_diyfp one;
+  uint64_t wp_w = mp.f - w.f, p2, tmp;
+  uint32_t p1;
+  int kappa = 1, len = 0;
+
+  one.e = mp.e;
+  one.f = (uint64_t)1 << -one.e;
+  p1 = (uint32_t)(mp.f >> -one.e);  //整数部分
+  p2 = mp.f & (one.f - 1);           //小数部分
+  while(kappa < 10 && p1 >= cjson_pow10_u64[kappa])
+    kappa++;
+
+  while(kappa > 0)
+  {
+    uint32_t d = p1 / (uint32_t)cjson_pow10_u64[kappa - 1];
+    p1 %= (uint32_t)cjson_pow10_u64[kappa - 1];
+    if(d || len)
+      buf[len++] = (char)('0' + d);
+    kappa--;
+    tmp = ((uint64_t)p1 << -one.e) + p2;
+    if(tmp <= delta)
+    {
+      *k += kappa;
+      cjson_grisu_round(buf, len, delta, tmp, cjson_pow10_u64[kappa] << -one.e, wp_w);
+      return len;
+    }
+  }
+
+  for(;;)   //整数部分用完，继续生成小数部分
+  {
+    char d;
+    p2 *= 10;
+    delta *= 10;
+    d = (char)(p2 >> -one.e);
+    if(d || len)
+      buf[len++] = (char)('0' + d);
+    p2 &= one.f - 1;
+    kappa--;
+    if(p2 < delta)
+    {
+      *k += kappa;
+      cjson_grisu_round(buf, len, delta, p2, one.f, wp_w * (-kappa < 20 ? cjson_pow10_u64[-kappa] : 0));
+      return len;
+    }
+  }
+}
+
+static int cjson_grisu2(uint64_t bits, char *buf, int *k)  //bits是有限正数的位表示，值为 buf * 10^k，返回位数
+{
+  const uint64_t hidden = (uint64_t)1 << 52;
+  int biased_e = (int)(bits >> 52) & 0x7FF;
+  cjson_diyfp v, w, mp, mm, c;
+
+  v.f = bits & (hidden - 1);
+  if(biased_e)
+  {
+    v.f += hidden;
+    v.e = biased_e - 1075;
+  }
+  else
+    v.e = -1074;
+
+  mp.f = (v.f << 1) + 1;  //和相邻浮点数的中点，在这两个边界之间的数都会读回v
+  mp.e = v.e - 1;
+  mp = cjson_diyfp_normalize(mp);
+  if(v.f == hidden)   //尾数是2的幂时，下面的相邻数更近
+  {
+    mm.f = (v.f << 2) - 1;
+    mm.e = v.e - 2;
+  }
+  else
+  {
+    mm.f = (v.f << 1) - 1;
+    mm.e = v.e - 1;
+  }
+  mm.f <<= mm.e - mp.e;
+  mm.e = mp.e;
+
+  c = cjson_cached_power(mp.e, k);
+  w = cjson_diyfp_mul(cjson_diyfp_normalize(v), c);
+  mp = cjson_diyfp_mul(mp, c);
+  mm = cjson_diyfp_mul(mm, c);
+  mm.f++;   //乘法有误差，边界各向内收缩1保证结果仍在区间内
+  mp.f--;
+  return cjson_grisu_digits(w, mp, mp.f - mm.f, buf, k);
+}
+
+static size_t cjson_format_double(char *buf, double num)  //写入buf，返回长度，最长不超过25字节
+{
+  uint64_t bits;
+  char *p = buf;
+  int len, k, e10;
+
+  memcpy(&bits, &num, sizeof(bits));
+  if(bits >> 63)
+    *p++ = '-';
+  bits &= ~((uint64_t)1 << 63);
+
+  if(bits >= (uint64_t)0x7FF << 52)   //inf和nan不是合法的json，写法和 %.17g 一致
+  {
+    memcpy(p, bits == (uint64_t)0x7FF << 52 ? "inf" : "nan", 3);
+    return (size_t)(p - buf) + 3;
+  }
+  if(bits == 0)
+  {
+    *p++ = '0';
+    return (size_t)(p - buf);
+  }
+
+  len = cjson_grisu2(bits, p, &k);
+  e10 = len + k - 1;  //第一位数字的指数
+
+  if(e10 < -4 || e10 >= 17)   //d.ddde+XX
+  {
+    if(len > 1)
+    {
+      memmove(p + 2, p + 1, (size_t)len - 1);
+      p[1] = '.';
+      p += len + 1;
+    }
+    else
+      p++;
+    *p++ = 'e';
+    *p++ = e10 < 0 ? '-' : '+';
+    if(e10 < 0)
+      e10 = -e10;
+    if(e10 >= 100)
+    {
+      *p++ = (char)('0' + e10 / 100);
+      e10 %= 100;
+    }
+    *p++ = (char)('0' + e10 / 10);
+    *p++ = (char)('0' + e10 % 10);
+  }
+  else if(k >= 0)   //整数，补上末尾的0
+  {
+    memset(p + len, '0', (size_t)k);
+    p += len + k;
+  }
+  else if(len + k > 0)  //小数点在数字中间
+  {
+    memmove(p + len + k + 1, p + len + k, (size_t)-k);
+    p[len + k] = '.';
+    p += len + 1;
+  }
+  else  //0.000ddd
+  {
+    memmove(p + 2 - (len + k), p, (size_t)len);
+    p[0] = '0';
+    p[1] = '.';
+    memset(p + 2, '0', (size_t)-(len + k));
+    p += 2 - k;
+  }
+
+  return (size_t)(p - buf);
+}
+
+static size_t cjson_format_uint64(char *buf, uint64_t num)  //写入buf，返回长度，最长20字节
+{
+  char tmp[20];
+  size_t len = 0;
+
+  do
+  {
+    tmp[len++] = (char)('0' + num % 10);
+    num /= 10;
+  }while(num);
+  for(size_t i = 0; i < len; i++)
+    buf[i] = tmp[len - 1 - i];
+  return len;
+}
+
+static size_t cjson_format_number(char *buf, const cjson_value *v)
+{
+  if(v->flags & CJSON_FLAG_UINT64)
+    return cjson_format_uint64(buf, v->u.u64);
+  if(v->flags & CJSON_FLAG_INT64)
+  {
+    if(v->u.i64 >= 0)
+      return cjson_format_uint64(buf, (uint64_t)v->u.i64);
+    buf[0] = '-';
+    return 1 + cjson_format_uint64(buf + 1, 0 - (uint64_t)v->u.i64);
+  }
+  return cjson_format_double(buf, v->u.num);
+}
+
+static size_t cjson_scan_ascii(const char *p, const char *end)  //返回从p开始的ASCII字节数
+{
+  const char *q = p;
+  while(q < end && (unsigned char)*q < 0x80)
+    q++;
+  return q - p;
+}
+
+static size_t cjson_decode_utf8(const char *s, const char *end, unsigned *u)  //解码一个非ASCII字符，返回字节数，无效时返回0
+{
+  const unsigned char *p = (const unsigned char *)s;
+  size_t n, i;
+  unsigned min;
+
+  if(p[0] >= 0xC2 && p[0] <= 0xDF)      { n = 2; *u = p[0] & 0x1F; min = 0x80; }
+  else if(p[0] >= 0xE0 && p[0] <= 0xEF) { n = 3; *u = p[0] & 0x0F; min = 0x800; }
+  else if(p[0] >= 0xF0 && p[0] <= 0xF4) { n = 4; *u = p[0] & 0x07; min = 0x10000; }
+  else return 0;
+
+  if((size_t)(end - s) < n)
+    return 0;
+  for(i = 1; i < n; i++)
+  {
+    if((p[i] & 0xC0) != 0x80)
+      return 0;
+    *u = (*u << 6) | (p[i] & 0x3F);
+  }
+  if(*u < min || *u > 0x10FFFF || (*u >= 0xD800 && *u <= 0xDFFF))   //过长编码、超出范围和代理项都是无效的
+    return 0;
+  return n;
+}
+
+static char *cjson_stringify_unicode(char *p, unsigned u)  //写出\uXXXX，返回写完之后的位置
+{
+  static const char hex[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+  *p++ = '\\';  *p++ = 'u';
+  *p++ = hex[(u >> 12) & 0x0f];
+  *p++ = hex[(u >> 8) & 0x0f];
+  *p++ = hex[(u >> 4) & 0x0f];
+  *p++ = hex[u & 0x0f];
+  return p;
+}
+
+static void cjson_stringify_string(cjson_context *c, const char *str, size_t len)
+{
+  const char *s = str, *end = str + len;
+  int ascii_only = c->options != NULL && c->options->ascii_only;
+  size_t reserve = ascii_only ? 12 : 6;   //一个转义字符最长的输出，代理对为12字节
+  char *p, *head;
+  size_t n, k;
+  unsigned u;
+
+  PUSH_CHAR_TO_STACK(c, '\"');
+
+  while(1)
+  {
+    //不需要转义的部分成块复制，每次只为这一段和后面的一个转义字符申请栈空间，不按整个字符串的最坏情况预留
+    if(c->sink != NULL && (size_t)(end - s) > c->size / 2)  //写到sink时每段最多半个缓冲区，缓冲区不用扩大
+      n = cjson_scan_string(s, s + c->size / 2);
+    else
+      n = cjson_scan_string(s, end);
+    if(ascii_only)
+      n = cjson_scan_ascii(s, s + n);
+    p = head = cjson_push(c, n + reserve);
+    memcpy(p, s, n);
+    p += n;
+    s += n;
+
+    if(s == end || !(IS_STRING_SPECIAL(*s) || (ascii_only && (unsigned char)*s >= 0x80)))
+    {
+      c->top -= reserve;
+      if(s == end)
+        break;
+      continue;
+    }
+
+    if((unsigned char)*s >= 0x80)  //只在ascii_only时出现
+    {
+      if((k = cjson_decode_utf8(s, end, &u)) == 0)
+      {
+        u = 0xFFFD;
+        k = 1;
+      }
+      if(u >= 0x10000)
+      {
+        u -= 0x10000;
+        p = cjson_stringify_unicode(p, 0xD800 | (u >> 10));
+        u = 0xDC00 | (u & 0x3FF);
+      }
+      p = cjson_stringify_unicode(p, u);
+      s += k;
+      c->top -= n + reserve - (p - head);
+      continue;
+    }
+
+    switch(*s)
+    {
+      case '\b': *p++ = '\\'; *p++ = 'b'; break;
+      case '\f': *p++ = '\\'; *p++ = 'f'; break;
+      case '\r': *p++ = '\\'; *p++ = 'r'; break;
+      case '\n': *p++ = '\\'; *p++ = 'n'; break;
+      case '\t': *p++ = '\\'; *p++ = 't'; break;
+      case '\\': *p++ = '\\'; *p++ = '\\'; break;
+      case '\"': *p++ = '\\'; *p++ = '\"'; break;
+      default : p = cjson_stringify_unicode(p, (unsigned char)*s); break;  //其余小于0x20的控制字符
+    }
+    s++;
+    c->top -= n + reserve - (p - head);
+  }
+
+  PUSH_CHAR_TO_STACK(c, '\"');
+}
+
+static void cjson_stringify_newline(cjson_context *c, size_t depth)  //换行并缩进到第depth层
+{
+  const cjson_stringify_options *o = c->options;
+  size_t n = depth * o->indent;
+  char *p = cjson_push(c, (o->crlf ? 2 : 1) + n);
+
+  if(o->crlf)
+    *p++ = '\r';
+  *p++ = '\n';
+  memset(p, ' ', n);
+}
+
+static int cjson_member_compare(const void *lhs, const void *rhs)  //按key的字节序比较，相同的key按原来的位置
+{
+  const cjson_member *a = *(const cjson_member * const *)lhs;
+  const cjson_member *b = *(const cjson_member * const *)rhs;
+  size_t n = a->key_len < b->key_len ? a->key_len : b->key_len;
+  int ret = n > 0 ? memcmp(a->key, b->key, n) : 0;
+
+  if(ret != 0)
+    return ret;
+  if(a->key_len != b->key_len)
+    return a->key_len < b->key_len ? -1 : 1;
+  return a < b ? -1 : a > b;
+}
+
+typedef struct
+{
+  const cjson_value *v;         //正在输出的数组或对象
+  size_t i;                     //下一个要输出的元素
+  const cjson_member **order;   //排序输出时成员的顺序，否则为NULL
+}cjson_stringify_frame;
+
+static void cjson_stringify_value(cjson_context *c, const cjson_value *v) //生成json字符串，c->options不为NULL时按选项换行、缩进和排序
+{
+  const cjson_stringify_options *o = c->options;
+  unsigned int indent = o != NULL ? o->indent : 0;
+  cjson_stringify_frame *f;
+  const cjson_member *m;
+  cjson_walk w;
+  size_t size, depth;
+
+  cjson_walk_init(&w, c->allocator);
+  while(1)
+  {
+    switch(v->type)
+    {
+      case CJSON_NULL: memcpy(cjson_push(c, 4), "null", 4); break;
+      case CJSON_TRUE: memcpy(cjson_push(c, 4), "true", 4); break;
+      case CJSON_FALSE: memcpy(cjson_push(c, 5), "false", 5); break;
+      case CJSON_NUMBER: c->top -= 32 - cjson_format_number(cjson_push(c, 32), v); break; //数字的最长长度为25
+      case CJSON_STRING: cjson_stringify_string(c, v->u.str.buf, v->u.str.l); break;
+      case CJSON_ARRAY:
+      case CJSON_OBJECT:
+        v = cjson_lazy_get(v);
+        PUSH_CHAR_TO_STACK(c, v->type == CJSON_ARRAY ? '[' : '{');
+        f = (cjson_stringify_frame *)cjson_walk_push(&w, sizeof(cjson_stringify_frame));
+        f->v = v;
+        f->i = 0;
+        f->order = NULL;
+        if(v->type == CJSON_OBJECT && o != NULL && o->sort_keys && (size = v->u.obj.size) > 1)  //只排序成员的指针，不改动对象本身
+        {
+          f->order = (const cjson_member **)CJSON_MALLOC(c->allocator, size * sizeof(*f->order));
+          for(size_t i = 0; i < size; i++)
+            f->order[i] = v->u.obj.members + i;
+          qsort((void *)f->order, size, sizeof(*f->order), cjson_member_compare);
+        }
+        break;
+    }
+
+    //找到下一个要输出的值，已经输出完的容器在这里结束
+    v = NULL;
+    while(w.top > 0)
+    {
+      f = CJSON_WALK_TOP(&w, cjson_stringify_frame);
+      depth = w.top / sizeof(cjson_stringify_frame);
+      size = f->v->type == CJSON_ARRAY ? f->v->u.arr.size : f->v->u.obj.size;
+      if(f->i < size)
+      {
+        if(f->i != 0)
+          PUSH_CHAR_TO_STACK(c, ',');
+        if(indent > 0)
+          cjson_stringify_newline(c, depth);
+        if(f->v->type == CJSON_ARRAY)
+          v = f->v->u.arr.elements + f->i;    //数组中的第i个元素
+        else
+        {
+          m = f->order != NULL ? f->order[f->i] : f->v->u.obj.members + f->i;
+          cjson_stringify_string(c, m->key, m->key_len);
+          PUSH_CHAR_TO_STACK(c, ':');
+          if(indent > 0)
+            PUSH_CHAR_TO_STACK(c, ' ');
+          v = &m->value;   //对象中的第i个key-value的 value
+        }
+        f->i++;
+        break;
+      }
+
+      if(size > 0 && indent > 0)   //空数组、空对象输出为[]、{}
+        cjson_stringify_newline(c, depth - 1);
+      PUSH_CHAR_TO_STACK(c, f->v->type == CJSON_ARRAY ? ']' : '}');
+      if(f->order != NULL)
+        CJSON_FREE(c->allocator, (void *)f->order);
+      CJSON_WALK_POP(&w, cjson_stringify_frame);
+    }
+    if(v == NULL)
+      break;
+  }
+  cjson_walk_free(&w);
+}
+
+//--------------------------API--------------------------//
+
+void cjson_set_allocator(const cjson_allocator *allocator)
+{
+  cjson_global_allocator = allocator ? *allocator : cjson_default_allocator;
+}
+
+const cjson_allocator *cjson_get_allocator(void)
+{
+  return &cjson_global_allocator;
+}
+
+void cjson_free(void *ptr)
+{
+  if(ptr)
+    CJSON_FREE(&cjson_global_allocator, ptr);
+}
+
+char *cjson_stringify(cjson_value v, size_t *length)
+{
+  return cjson_stringify_with_allocator(&cjson_global_allocator, v, length);
+}
+
+static void cjson_stringify_context(cjson_context *c, const cjson_value *v, size_t *length)  //结果在 c->stack 中，以'\0'结尾
+{
+  c->top = 0;
+  cjson_stringify_value(c, v);
+
+  if(length)
+    *length = c->top;
+
+  *(char*)cjson_push(c, sizeof(char)) = '\0';
+}
+
+char *cjson_stringify_with_allocator(const cjson_allocator *allocator, cjson_value v, size_t *length)
+{
+  cjson_context c = {0};
+  assert(allocator != NULL);
+  c.allocator = allocator;
+
+  cjson_stringify_context(&c, &v, length);
+
+  return c.stack;
+}
+
+char *cjson_stringify_ex(cjson_value v, const cjson_stringify_options *options, size_t *length)
+{
+  cjson_context c = {0};
+  c.allocator = &cjson_global_allocator;
+  c.options = options;
+
+  cjson_stringify_context(&c, &v, length);
+
+  return c.stack;
+}
+
+CJSON_STATUS cjson_parse(cjson_value* v, const char *json)
+{
+  assert(json != NULL);
+  return cjson_parse_n(v, json, strlen(json));
+}
+
+static CJSON_STATUS cjson_parse_context(cjson_context *c, cjson_value* v, const char *json, size_t len)  //使用c中已有的栈、分配器和arena解析
+{
+  CJSON_STATUS ret;
+  assert(v != NULL);
+  assert(json != NULL || len == 0);
+  c->json = json;
+  c->end = json + len;
+  c->top = 0;
+  CJSON_STAT(c, memset(st_, 0, sizeof(cjson_parse_stats)); st_->stack_size = c->size);
+
+  cjson_value_init(v);
+
+  if((ret = cjson_parse_value(c, v)) == CJSON_OK)
+  {
+    cjson_parse_skip_space(c);
+    if(c->json != c->end)
+    {
+      cjson_value_free_with_allocator(c->allocator, v);
+      ret = CJSON_ERR_ROOT_NOT_SINGULAR;
+    }
+  }
+  else
+    cjson_value_init(v);
+  assert(c->top == 0);
+  return ret;
+}
+
+static CJSON_STATUS cjson_parse_root(const cjson_allocator *allocator, cjson_arena *arena, int insitu, cjson_value* v, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  cjson_context c = {0};
+  c.stack = NULL;
+  c.size = c.top = 0;
+  c.allocator = allocator;
+  c.arena = arena;
+  c.insitu = insitu;
+
+  ret = cjson_parse_context(&c, v, json, len);
+  if(c.stack)
+    CJSON_FREE(allocator, c.stack);
+  return ret;
+}
+
+static CJSON_STATUS cjson_parse_context_indexed(cjson_context *c, uint32_t **tokens, size_t *capacity, cjson_value *v, const char *json, size_t len)  //先建立结构索引，再按索引解析
+{
+  CJSON_STATUS ret;
+
+  if(len >= UINT32_MAX)   //位置用32位保存，更大的输入按普通方式解析
+    return cjson_parse_context(c, v, json, len);
+  *tokens = cjson_index_structurals(c->allocator, *tokens, capacity, json, len);
+  c->begin = json;
+  c->token = *tokens;
+  ret = cjson_parse_context(c, v, json, len);
+  c->token = NULL;
+  return ret;
+}
+
+CJSON_STATUS cjson_parse_n(cjson_value* v, const char *json, size_t len)
+{
+  return cjson_parse_root(&cjson_global_allocator, NULL, 0, v, json, len);
+}
+
+#ifdef CJSON_STATS
+CJSON_STATUS cjson_parse_with_stats(cjson_parse_stats *stats, cjson_value *v, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  cjson_context c = {0};
+  assert(stats != NULL);
+  c.allocator = &cjson_global_allocator;
+  c.stats = stats;
+
+  ret = cjson_parse_context(&c, v, json, len);
+  if(c.stack)
+    CJSON_FREE(c.allocator, c.stack);
+  return ret;
+}
+#endif
+
+CJSON_STATUS cjson_parse_insitu(cjson_value *v, char *json, size_t len)
+{
+  return cjson_parse_root(&cjson_global_allocator, NULL, 1, v, json, len);
+}
+
+static void cjson_locate_error(cjson_parse_error *error, const char *json, size_t len, size_t offset)  //只在出错时调用，计算行列和附近的片段
+{
+  const size_t radius = (sizeof(error->context) - 1) / 2;
+  size_t begin, end, line = 1, column = 1;
+
+  for(size_t i = 0; i < offset; i++)  //"\r\n"、"\n"和单独的"\r"都算换行
+  {
+    if(json[i] == '\n' || (json[i] == '\r' && (i + 1 == len || json[i + 1] != '\n')))
+    {
+      line++;
+      column = 1;
+    }
+    else if(json[i] != '\r')
+      column++;
+  }
+  error->offset = offset;
+  error->line = line;
+  error->column = column;
+
+  begin = offset > radius ? offset - radius : 0;
+  end = len - offset > radius ? offset + radius : len;
+  while(begin < offset && ((unsigned char)json[begin] & 0xC0) == 0x80)  //不从多字节字符的中间开始或结束
+    begin++;
+  while(end > offset && end < len && ((unsigned char)json[end] & 0xC0) == 0x80)
+    end--;
+  for(size_t i = begin; i < end; i++)
+    error->context[i - begin] = (unsigned char)json[i] < 0x20 ? ' ' : json[i];   //换行等控制字符替换为空格，片段保持在一行
+  error->context[end - begin] = '\0';
+  error->context_offset = offset - begin;
+}
+
+CJSON_STATUS cjson_parse_ex(cjson_value *v, const char *json, size_t len, cjson_parse_error *error)
+{
+  CJSON_STATUS ret;
+  cjson_context c = {0};
+  c.allocator = &cjson_global_allocator;
+
+  ret = cjson_parse_context(&c, v, json, len);
+  if(c.stack)
+    CJSON_FREE(c.allocator, c.stack);
+  if(error != NULL)
+  {
+    memset(error, 0, sizeof(cjson_parse_error));
+    error->status = ret;
+    if(ret != CJSON_OK)
+      cjson_locate_error(error, json, len, c.json - json);
+  }
+  return ret;
+}
+
+CJSON_STATUS cjson_parse_indexed(cjson_value *v, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  cjson_context c = {0};
+  uint32_t *tokens = NULL;
+  size_t capacity = 0;
+  assert(json != NULL || len == 0);
+  c.allocator = &cjson_global_allocator;
+
+  ret = cjson_parse_context_indexed(&c, &tokens, &capacity, v, json, len);
+  if(c.stack)
+    CJSON_FREE(c.allocator, c.stack);
+  if(tokens)
+    CJSON_FREE(c.allocator, tokens);
+  return ret;
+}
+
+CJSON_STATUS cjson_parse_lazy(cjson_value *v, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  cjson_context c = {0};
+  c.allocator = &cjson_global_allocator;
+  c.lazy = 1;   //最外层就延迟
+
+  ret = cjson_parse_context(&c, v, json, len);
+  if(c.stack)
+    CJSON_FREE(c.allocator, c.stack);
+  return ret;
+}
+
+int cjson_is_lazy(cjson_value value)
+{
+  return (value.flags & CJSON_FLAG_LAZY) && !value.u.lazy->parsed;
+}
+
+CJSON_STATUS cjson_lazy_load(cjson_value *v)
+{
+  CJSON_STATUS ret;
+  assert(v != NULL);
+
+  if(!(v->flags & CJSON_FLAG_LAZY))
+    return CJSON_OK;
+  cjson_lazy_parse(v->u.lazy);
+  ret = v->u.lazy->status;
+  cjson_lazy_resolve(v);
+  return ret;
+}
+
+CJSON_STATUS cjson_parse_with_allocator(const cjson_allocator *allocator, cjson_value *v, const char *json, size_t len)
+{
+  assert(allocator != NULL);
+  return cjson_parse_root(allocator, NULL, 0, v, json, len);
+}
+
+void cjson_value_free(cjson_value *value)
+{
+  cjson_value_free_with_allocator(&cjson_global_allocator, value);
+}
+
+static void cjson_free_node(const cjson_allocator *allocator, cjson_value *value)   //释放值本身申请的内存，数组和对象的元素(成员)必须已经释放
+{
+  if(!(value->flags & CJSON_FLAG_ARENA))  //arena中的内存由arena统一释放
+  {
+    switch(value->type)
+    {
+      case CJSON_STRING:
+        if(!(value->flags & CJSON_FLAG_INSITU))
+          CJSON_FREE(allocator, value->u.str.buf);
+        break;
+      case CJSON_ARRAY:
+        if(value->u.arr.elements)
+          CJSON_FREE(allocator, value->u.arr.elements);
+        break;
+      case CJSON_OBJECT:
+        if(value->u.obj.members)
+          CJSON_FREE(allocator, value->u.obj.members);
+        if(value->u.obj.index)
+          CJSON_FREE(allocator, value->u.obj.index);
+        break;
+      default:
+        break;
+    }
+  }
+  cjson_value_init(value);
+}
+
+typedef struct
+{
+  cjson_value *v;   //正在释放的数组或对象
+  size_t i;         //下一个要释放的元素
+}cjson_free_frame;
+
+void cjson_value_free_with_allocator(const cjson_allocator *allocator, cjson_value *value)   //释放value申请的内存，主要针对str，arr，obj类型
+{
+  cjson_free_frame *f;
+  cjson_member *m;
+  cjson_walk w;
+  size_t size;
+
+  assert(allocator != NULL);
+  assert(value != NULL);
+
+  cjson_walk_init(&w, allocator);
+  while(1)
+  {
+    if(value->flags & CJSON_FLAG_LAZY)  //解析过的放回值中按普通容器释放，没有解析过的只释放片段
+    {
+      if(value->u.lazy->parsed)
+        cjson_lazy_resolve(value);
+      else
+      {
+        CJSON_FREE(allocator, value->u.lazy);
+        cjson_value_init(value);
+      }
+    }
+
+    //元素先于容器释放，非空的容器压栈，其余的直接释放
+    size = value->type == CJSON_ARRAY ? value->u.arr.size : value->type == CJSON_OBJECT ? value->u.obj.size : 0;
+    if(size > 0 && !(value->flags & CJSON_FLAG_ARENA))
+    {
+      f = (cjson_free_frame *)cjson_walk_push(&w, sizeof(cjson_free_frame));
+      f->v = value;
+      f->i = 0;
+    }
+    else
+      cjson_free_node(allocator, value);
+
+    value = NULL;
+    while(w.top > 0)
+    {
+      f = CJSON_WALK_TOP(&w, cjson_free_frame);
+      if(f->v->type == CJSON_ARRAY && f->i < f->v->u.arr.size)
+      {
+        value = f->v->u.arr.elements + f->i++;
+        break;
+      }
+      if(f->v->type == CJSON_OBJECT && f->i < f->v->u.obj.size)
+      {
+        m = f->v->u.obj.members + f->i++;
+        if(!(f->v->flags & CJSON_FLAG_INSITU))
+          CJSON_FREE(allocator, m->key);
+        value = &m->value;
+        break;
+      }
+      cjson_free_node(allocator, f->v);
+      CJSON_WALK_POP(&w, cjson_free_frame);
+    }
+    if(value == NULL)
+      break;
+  }
+  cjson_walk_free(&w);
+}
+
+static int cjson_integer_equal_double(const cjson_value *i, double d)  //i是整数，d必须恰好是同一个整数
+{
+  if(i->flags & CJSON_FLAG_UINT64)  //大于INT64_MAX，这个范围的double都是整数
+    return d >= 9223372036854775808.0 && d < 18446744073709551616.0 && (uint64_t)d == i->u.u64;
+  return d >= -9223372036854775808.0 && d < 9223372036854775808.0 && (int64_t)d == i->u.i64 && (double)(int64_t)d == d;
+}
+
+static int cjson_number_is_equal(const cjson_value *lhs, const cjson_value *rhs)  //按数值比较，1和1.0相同
+{
+  unsigned int li = lhs->flags & CJSON_FLAG_INTEGER, ri = rhs->flags & CJSON_FLAG_INTEGER;
+
+  if(li && ri)  //大于INT64_MAX的数只会以uint64保存，两种整数不会相等
+    return li == ri && lhs->u.u64 == rhs->u.u64;
+  if(li)
+    return cjson_integer_equal_double(lhs, rhs->u.num);
+  if(ri)
+    return cjson_integer_equal_double(rhs, lhs->u.num);
+  return lhs->u.num == rhs->u.num;
+}
+
+typedef struct
+{
+  const cjson_value *lhs, *rhs;   //正在比较的两个数组或对象，大小已经相同
+  size_t i;                       //下一个要比较的元素
+  size_t dup;                     //lhs中跳过的重复key个数
+}cjson_equal_frame;
+
+int cjson_is_equal(const cjson_value* lhs, const cjson_value* rhs)
+{
+  assert(lhs != NULL && rhs != NULL);
+  cjson_equal_frame *f;
+  cjson_walk w;
+  int ret = 1;
+
+  cjson_walk_init(&w, &cjson_global_allocator);
+  while(ret)
+  {
+    //比较一对值，数组和对象大小相同时压栈，元素在后面逐个比较
+    lhs = cjson_lazy_get(lhs);
+    rhs = cjson_lazy_get(rhs);
+    if(lhs->type != rhs->type)
+      ret = 0;
+    else
+    {
+      switch(lhs->type)
+      {
+        case CJSON_NUMBER:
+          ret = cjson_number_is_equal(lhs, rhs);
+          break;
+        case CJSON_STRING:
+          ret = lhs->u.str.l == rhs->u.str.l && !memcmp(lhs->u.str.buf, rhs->u.str.buf, lhs->u.str.l);
+          break;
+        case CJSON_ARRAY:   //arr相同，内部元素顺序必须相同
+        case CJSON_OBJECT:  //obj相同，内部键值对可能顺序不同，按key在rhs中查找，有索引时每次查找是O(1)
+          if(lhs->type == CJSON_ARRAY ? lhs->u.arr.size != rhs->u.arr.size : lhs->u.obj.size != rhs->u.obj.size)
+            ret = 0;
+          else
+          {
+            f = (cjson_equal_frame *)cjson_walk_push(&w, sizeof(cjson_equal_frame));
+            f->lhs = lhs;
+            f->rhs = rhs;
+            f->i = 0;
+            f->dup = 0;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    //找到下一对要比较的值
+    lhs = NULL;
+    while(ret && w.top > 0)
+    {
+      f = CJSON_WALK_TOP(&w, cjson_equal_frame);
+      if(f->lhs->type == CJSON_ARRAY && f->i < f->lhs->u.arr.size)
+      {
+        lhs = f->lhs->u.arr.elements + f->i;
+        rhs = f->rhs->u.arr.elements + f->i++;
+        break;
+      }
+      if(f->lhs->type == CJSON_OBJECT && f->i < f->lhs->u.obj.size)
+      {
+        //重复key只比较第一个，和cjson_object_find一致
+        const cjson_member *m = f->lhs->u.obj.members + f->i;
+        size_t j;
+
+        if(cjson_object_find(f->lhs, m->key, m->key_len) != f->i++)
+        {
+          f->dup++;
+          continue;
+        }
+        if(!(ret = (j = cjson_object_find(f->rhs, m->key, m->key_len)) != CJSON_KEY_NOT_EXIST))
+          break;
+        lhs = &m->value;
+        rhs = &f->rhs->u.obj.members[j].value;
+        break;
+      }
+      if(f->lhs->type == CJSON_OBJECT && f->dup > 0)
+      {
+        //lhs的每个key都能在rhs找到，rhs不同key的个数也相同时才没有多余的key
+        size_t k, distinct = 0;
+
+        for(k = 0; k < f->rhs->u.obj.size; k++)
+        {
+          const cjson_member *n = f->rhs->u.obj.members + k;
+          distinct += cjson_object_find(f->rhs, n->key, n->key_len) == k;
+        }
+        if(!(ret = distinct == f->lhs->u.obj.size - f->dup))
+          break;
+      }
+      CJSON_WALK_POP(&w, cjson_equal_frame);
+    }
+    if(lhs == NULL)
+      break;
+  }
+  cjson_walk_free(&w);
+  return ret;
+}
+
+static uint64_t cjson_hash_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static uint64_t cjson_hash_number(const cjson_value *v)  //和cjson_number_is_equal一致，数值相同的整数和double哈希相同
+{
+  uint64_t bits;
+  double d = v->u.num;
+
+  if(v->flags & CJSON_FLAG_INTEGER)
+    bits = v->u.u64;
+  else if(d >= -9223372036854775808.0 && d < 9223372036854775808.0 && (double)(int64_t)d == d)  //0.0和-0.0也相同
+    bits = (uint64_t)(int64_t)d;
+  else if(d >= 9223372036854775808.0 && d < 18446744073709551616.0)
+    bits = (uint64_t)d;
+  else
+    memcpy(&bits, &d, sizeof(bits));
+  return cjson_hash_mix(bits);
+}
+
+typedef struct
+{
+  const cjson_value *v;   //正在计算的数组或对象
+  size_t i;               //下一个要计算的元素
+  uint64_t h;             //已经完成的元素累计的哈希
+}cjson_hash_frame;
+
+size_t cjson_hash(const cjson_value *v)
+{
+  cjson_hash_frame *f;
+  const cjson_member *m;
+  cjson_walk w;
+  uint64_t h = 0;
+  int done;   //h是刚刚完成的一个值的哈希，还没有合并到外层
+
+  assert(v != NULL);
+  cjson_walk_init(&w, &cjson_global_allocator);
+  while(1)
+  {
+    done = 1;
+    v = cjson_lazy_get(v);
+    switch(v->type)
+    {
+      case CJSON_NUMBER:
+        h = cjson_hash_number(v);
+        break;
+      case CJSON_STRING:
+        h = cjson_hash_key(v->u.str.buf, v->u.str.l);
+        break;
+      case CJSON_ARRAY:   //和元素顺序有关
+      case CJSON_OBJECT:  //和成员顺序无关，每个成员的哈希相加
+        f = (cjson_hash_frame *)cjson_walk_push(&w, sizeof(cjson_hash_frame));
+        f->v = v;
+        f->i = 0;
+        f->h = v->type == CJSON_ARRAY ? cjson_hash_mix(CJSON_ARRAY + v->u.arr.size) : 0;
+        done = 0;
+        break;
+      default:
+        h = cjson_hash_mix(v->type);
+        break;
+    }
+
+    //把完成的值合并到外层，找到下一个要计算的值
+    v = NULL;
+    while(w.top > 0)
+    {
+      f = CJSON_WALK_TOP(&w, cjson_hash_frame);
+      if(done)
+      {
+        if(f->v->type == CJSON_ARRAY)
+          f->h = cjson_hash_mix(f->h + h);
+        else
+        {
+          m = f->v->u.obj.members + f->i - 1;
+          f->h += cjson_hash_mix(cjson_hash_key(m->key, m->key_len) ^ cjson_hash_mix(h));
+        }
+      }
+      if(f->i < (f->v->type == CJSON_ARRAY ? f->v->u.arr.size : f->v->u.obj.size))
+      {
+        v = f->v->type == CJSON_ARRAY ? f->v->u.arr.elements + f->i : &f->v->u.obj.members[f->i].value;
+        f->i++;
+        break;
+      }
+      h = f->v->type == CJSON_ARRAY ? f->h : cjson_hash_mix(f->h + CJSON_OBJECT + f->v->u.obj.size);
+      done = 1;
+      CJSON_WALK_POP(&w, cjson_hash_frame);
+    }
+    if(v == NULL)
+      break;
+  }
+  cjson_walk_free(&w);
+  return (size_t)h;
+}
+
+typedef struct
+{
+  const cjson_value *src;   //正在复制的数组或对象
+  cjson_value *dest;        //已经申请好元素(成员)空间的目标，对象的key和索引也已经复制
+  size_t i;                 //下一个要复制的元素
+}cjson_copy_frame;
+
+static void cjson_copy_value(const cjson_allocator *a, cjson_arena *arena, cjson_value *dest, const cjson_value *src)  //深度复制，dest必须是未初始化或已释放的值
+{
+  cjson_copy_frame *f;
+  cjson_walk w;
+  size_t size;
+
+  cjson_walk_init(&w, a);
+  while(1)
+  {
+    src = cjson_lazy_get(src);   //复制出的是普通的值
+    dest->type = src->type;
+    dest->flags = arena ? CJSON_FLAG_ARENA : 0;
+    switch(src->type)
+    {
+      case CJSON_NULL:
+      case CJSON_TRUE:
+      case CJSON_FALSE:
+        break;
+      case CJSON_NUMBER:
+        dest->u = src->u;
+        dest->flags |= src->flags & CJSON_FLAG_INTEGER;
+        break;
+      case CJSON_STRING:
+        cjson_set_string_raw(a, arena, dest, src->u.str.buf, src->u.str.l);
+        break;
+      case CJSON_ARRAY:
+        //要保证深度复制，数组、字符串、对象元素中的指针都要指向新的内存，元素在后面逐个复制
+        size = src->u.arr.size;
+        dest->u.arr.size = dest->u.arr.capacity = size;
+        dest->u.arr.elements = size > 0 ? (cjson_value *)cjson_malloc(a, arena, size * sizeof(cjson_value)) : NULL;
+        break;
+      case CJSON_OBJECT:
+        size = src->u.obj.size;
+        dest->u.obj.size = dest->u.obj.capacity = size;
+        dest->u.obj.members = size > 0 ? (cjson_member *)cjson_malloc(a, arena, size * sizeof(cjson_member)) : NULL;
+        for(size_t i = 0; i < size; i++)
+        {
+          const cjson_member *m = src->u.obj.members + i;
+          cjson_member *d = dest->u.obj.members + i;
+
+          d->key_len = m->key_len;
+          memcpy(d->key = (char *)cjson_malloc(a, arena, m->key_len + 1), m->key, m->key_len);
+          d->key[m->key_len] = '\0';  //注意必须添加字符串结束符
+        }
+        dest->u.obj.index = size >= CJSON_OBJECT_INDEX_THRESHOLD ? cjson_index_build(a, arena, dest->u.obj.members, size) : NULL;
+        break;
+    }
+    if(src->type == CJSON_ARRAY || src->type == CJSON_OBJECT)
+    {
+      f = (cjson_copy_frame *)cjson_walk_push(&w, sizeof(cjson_copy_frame));
+      f->src = src;
+      f->dest = dest;
+      f->i = 0;
+    }
+
+    //找到下一个要复制的值
+    src = NULL;
+    while(w.top > 0)
+    {
+      f = CJSON_WALK_TOP(&w, cjson_copy_frame);
+      if(f->src->type == CJSON_ARRAY && f->i < f->src->u.arr.size)
+      {
+        src = f->src->u.arr.elements + f->i;
+        dest = f->dest->u.arr.elements + f->i++;
+        break;
+      }
+      if(f->src->type == CJSON_OBJECT && f->i < f->src->u.obj.size)
+      {
+        src = &f->src->u.obj.members[f->i].value;
+        dest = &f->dest->u.obj.members[f->i++].value;
+        break;
+      }
+      CJSON_WALK_POP(&w, cjson_copy_frame);
+    }
+    if(src == NULL)
+      break;
+  }
+  cjson_walk_free(&w);
+}
+
+void cjson_copy(cjson_value *dest, const cjson_value *src)
+{
+  assert(dest != NULL && src != NULL);
+  if(dest == src)
+    return;
+  cjson_value_free(dest);
+  cjson_copy_value(&cjson_global_allocator, NULL, dest, src);
+}
+
+void cjson_copy_with_allocator(const cjson_allocator *allocator, cjson_value *dest, const cjson_value *src)
+{
+  assert(allocator != NULL);
+  assert(dest != NULL && src != NULL);
+  if(dest == src)
+    return;
+  cjson_value_free_with_allocator(allocator, dest);
+  cjson_copy_value(allocator, NULL, dest, src);
+}
+
+void cjson_move(cjson_value *dest, cjson_value *src)
+{
+  assert(dest != NULL && src != NULL);
+
+  cjson_value_free(dest);
+  memcpy(dest, src, sizeof(cjson_value));
+  cjson_value_init(src);
+}
+
+void cjson_swap(cjson_value *dest, cjson_value *src)  //交换，如果是要把两个指针的指向交换的话，需要传入指针的指针
+{
+  assert(dest != NULL && src != NULL);
+  cjson_value tmp;
+
+  if(dest != src)
+  {
+    memcpy(&tmp, src, sizeof(cjson_value));
+    memcpy(src, dest, sizeof(cjson_value));
+    memcpy(dest, &tmp, sizeof(cjson_value));
+  }
+}
+
+cjson_type cjson_get_type(cjson_value value)
+{
+  return value.type;
+}
+
+int cjson_get_boolean(cjson_value value)
+{
+  assert(value.type == CJSON_TRUE || value.type == CJSON_FALSE);
+  return value.type == CJSON_TRUE;
+}
+
+void cjson_set_boolean(cjson_value *value, int bool)
+{
+  assert(value != NULL);
+  cjson_value_free(value);
+  value->type = bool ? CJSON_TRUE : CJSON_FALSE;
+}
+
+double cjson_get_number(cjson_value value)  //整数转换为最接近的double
+{
+  assert(value.type == CJSON_NUMBER);
+  if(value.flags & CJSON_FLAG_UINT64)
+    return (double)value.u.u64;
+  if(value.flags & CJSON_FLAG_INT64)
+    return (double)value.u.i64;
+  return value.u.num;
+}
+
+void cjson_set_number(cjson_value *value, double num)
+{
+  assert(value != NULL);
+  cjson_value_free(value);
+  value->type = CJSON_NUMBER;
+  value->u.num = num;
+}
+
+int cjson_is_integer(cjson_value value)
+{
+  assert(value.type == CJSON_NUMBER);
+  return (value.flags & CJSON_FLAG_INTEGER) != 0;
+}
+
+int64_t cjson_get_int64(cjson_value value)  //double截断小数部分，超出范围的数不能取
+{
+  assert(value.type == CJSON_NUMBER);
+  if(value.flags & CJSON_FLAG_INT64)
+    return value.u.i64;
+  assert(!(value.flags & CJSON_FLAG_UINT64));
+  assert(value.u.num >= -9223372036854775808.0 && value.u.num < 9223372036854775808.0);
+  return (int64_t)value.u.num;
+}
+
+void cjson_set_int64(cjson_value *value, int64_t num)
+{
+  assert(value != NULL);
+  cjson_value_free(value);
+  value->type = CJSON_NUMBER;
+  value->flags |= CJSON_FLAG_INT64;
+  value->u.i64 = num;
+}
+
+uint64_t cjson_get_uint64(cjson_value value)  //double截断小数部分，负数和超出范围的数不能取
+{
+  assert(value.type == CJSON_NUMBER);
+  if(value.flags & CJSON_FLAG_UINT64)
+    return value.u.u64;
+  if(value.flags & CJSON_FLAG_INT64)
+  {
+    assert(value.u.i64 >= 0);
+    return (uint64_t)value.u.i64;
+  }
+  assert(value.u.num > -1.0 && value.u.num < 18446744073709551616.0);
+  return (uint64_t)value.u.num;
+}
+
+void cjson_set_uint64(cjson_value *value, uint64_t num)
+{
+  assert(value != NULL);
+  cjson_value_free(value);
+  value->type = CJSON_NUMBER;
+  value->flags |= num <= (uint64_t)INT64_MAX ? CJSON_FLAG_INT64 : CJSON_FLAG_UINT64;   //能放进int64的数统一用int64保存
+  value->u.u64 = num;
+}
+
+size_t cjson_get_string_length(cjson_value value)
+{
+  assert(value.type == CJSON_STRING);
+  return value.u.str.l;
+}
+
+char* cjson_get_string(cjson_value value)
+{
+  assert(value.type == CJSON_STRING);
+  return value.u.str.buf;
+}
+
+void cjson_set_string(cjson_value *value, const char *buf, size_t len)
+{
+  assert(value != NULL);
+  assert(buf != NULL || len == 0);
+  cjson_value_free(value);
+  cjson_set_string_raw(&cjson_global_allocator, NULL, value, buf, len);
+}
+
+size_t cjson_get_array_size(cjson_value value)
+{
+  assert(value.type == CJSON_ARRAY);
+  const cjson_value *v = cjson_lazy_get(&value);
+  return v->u.arr.size;
+}
+
+size_t cjson_get_array_capacity(cjson_value value)
+{
+  assert(value.type == CJSON_ARRAY);
+  const cjson_value *v = cjson_lazy_get(&value);
+  return v->u.arr.capacity;
+}
+
+cjson_value *cjson_get_array_element(cjson_value value, size_t index)
+{
+  assert(value.type == CJSON_ARRAY);
+  const cjson_value *v = cjson_lazy_get(&value);
+  assert(v->u.arr.size > index);  //index为索引号，从0开始，size为元素数，从1开始
+  return v->u.arr.elements + index;
+}
+
+void cjson_init_array(cjson_value *value, size_t cap)
+{
+  assert(value != NULL);
+
+  cjson_value_free(value);
+  value->type = CJSON_ARRAY;
+  value->u.arr.size = 0;
+  value->u.arr.capacity = cap;
+  value->u.arr.elements = cap > 0 ? (cjson_value *)CJSON_MALLOC(&cjson_global_allocator, sizeof(cjson_value) * cap) : NULL;
+}
+
+void cjson_resize_array(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_ARRAY);
+  cjson_lazy_resolve(value);
+  assert(!(value->flags & CJSON_FLAG_ARENA));  //arena中的数组不能扩容
+  if(value->u.arr.capacity <= value->u.arr.size)
+  {
+    // value->u.arr.capacity = value->u.arr.capacity == 0? 1 : value->u.arr.capacity + value->u.arr.capacity >> 1; //这里不能把数组容量扩大到1.5倍，cap为1，这个最终结果还是1
+    value->u.arr.capacity = value->u.arr.capacity == 0? 1 : value->u.arr.capacity << 1; //这里不能把数组容量扩大到1.5倍，cap为1，这个最终结果还是1
+    value->u.arr.elements = (cjson_value *)CJSON_REALLOC(&cjson_global_allocator, value->u.arr.elements, value->u.arr.capacity * sizeof(cjson_value));
+  }
+}
+cjson_value *cjson_pushback_array_element(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_ARRAY);
+  cjson_lazy_resolve(value);
+
+  if(value->u.arr.size >= value->u.arr.capacity)
+    cjson_resize_array(value);
+  
+  cjson_value_init(value->u.arr.elements + value->u.arr.size);
+  return value->u.arr.elements + value->u.arr.size++;
+}
+
+cjson_value *cjson_popback_array_element(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_ARRAY);
+  cjson_lazy_resolve(value);
+  return value->u.arr.elements + --value->u.arr.size;
+}
+
+cjson_value *cjson_insert_array_element(cjson_value *value, size_t index)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_ARRAY);
+  cjson_lazy_resolve(value);
+
+  if(value->u.arr.size >= value->u.arr.capacity)
+    cjson_resize_array(value);
+
+  memmove(value->u.arr.elements + index + 1, value->u.arr.elements + index, sizeof(cjson_value) * (value->u.arr.size - index));
+  value->u.arr.size++;
+
+  return value->u.arr.elements + index;
+}
+
+void cjson_erase_array_element(cjson_value *value, size_t index, size_t count)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_ARRAY);
+  cjson_lazy_resolve(value);
+  assert(index + count <= value->u.arr.size);   //一共9个元素，index从8开始删除1个，即删除最后一共元素，所以这里需要等号
+
+  for(size_t i = 0; i < count; i++)
+  {
+    cjson_value_free(value->u.arr.elements + index + i);
+  }
+  value->u.arr.size -= count;
+  memmove(value->u.arr.elements + index, value->u.arr.elements + index + count, sizeof(cjson_value) * (value->u.arr.size - index));
+}
+
+void cjson_clear_array_element(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_ARRAY);
+  cjson_lazy_resolve(value);  //先解析，延迟解析的值中还没有元素个数
+  cjson_erase_array_element(value, 0, value->u.arr.size);
+}
+
+void cjson_shrink_array(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_ARRAY);
+  cjson_lazy_resolve(value);
+  assert(!(value->flags & CJSON_FLAG_ARENA));
+
+  value->u.arr.capacity = value->u.arr.size;
+  if(value->u.arr.capacity == 0)  //realloc(ptr, 0)的行为由实现决定，这里直接释放
+  {
+    if(value->u.arr.elements)
+      CJSON_FREE(&cjson_global_allocator, value->u.arr.elements);
+    value->u.arr.elements = NULL;
+  }
+  else
+    value->u.arr.elements = (cjson_value *)CJSON_REALLOC(&cjson_global_allocator, value->u.arr.elements, value->u.arr.capacity * sizeof(cjson_value));
+}
+
+size_t cjson_get_object_size(cjson_value value)
+{
+  assert(value.type == CJSON_OBJECT);
+  const cjson_value *v = cjson_lazy_get(&value);
+  return v->u.obj.size;
+}
+
+size_t cjson_get_object_capacity(cjson_value value)
+{
+  assert(value.type == CJSON_OBJECT);
+  const cjson_value *v = cjson_lazy_get(&value);
+  return v->u.obj.capacity;
+}
+
+const char *cjson_get_object_key(cjson_value value, size_t index)
+{
+  assert(value.type == CJSON_OBJECT);
+  const cjson_value *v = cjson_lazy_get(&value);
+  assert(v->u.obj.size > index);  //index为索引号，从0开始，size为元素数，从1开始
+  return (v->u.obj.members + index)->key;
+}
+
+size_t cjson_get_object_key_length(cjson_value value, size_t index)
+{
+  assert(value.type == CJSON_OBJECT);
+  const cjson_value *v = cjson_lazy_get(&value);
+  assert(v->u.obj.size > index);  //index为索引号，从0开始，size为元素数，从1开始
+  return (v->u.obj.members + index)->key_len;
+}
+
+cjson_value *cjson_get_object_value(cjson_value value, size_t index)
+{
+  assert(value.type == CJSON_OBJECT);
+  const cjson_value *v = cjson_lazy_get(&value);
+  assert(v->u.obj.size > index);  //index为索引号，从0开始，size为元素数，从1开始
+  return &((v->u.obj.members + index)->value);
+}
+
+void cjson_init_object(cjson_value *value, size_t cap)
+{
+  assert(value != NULL);
+
+  cjson_value_free(value);
+  value->type = CJSON_OBJECT;
+  value->u.obj.size = 0;
+  value->u.obj.capacity = cap;
+  value->u.obj.members = cap > 0 ? (cjson_member *)CJSON_MALLOC(&cjson_global_allocator, sizeof(cjson_member) * cap) : NULL;
+  value->u.obj.index = NULL;
+}
+
+void cjson_resize_object(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_OBJECT);
+  cjson_lazy_resolve(value);
+  assert(!(value->flags & CJSON_FLAG_ARENA));
+
+  if(value->u.obj.capacity <= value->u.obj.size)
+  {
+    value->u.obj.capacity = value->u.obj.capacity == 0? 1 : value->u.obj.capacity << 1; //这里不能把容量扩大到1.5倍，cap为1，这个最终结果还是1
+    value->u.obj.members = (cjson_member *)CJSON_REALLOC(&cjson_global_allocator, value->u.obj.members, value->u.obj.capacity * sizeof(cjson_member));
+  }  
+}
+
+static cjson_value *cjson_object_set(cjson_value *value, const char* key, size_t klen, size_t hash)  //hash同cjson_object_find_hash()，key可以为空串
+{
+  cjson_object_index *index;
+  size_t i;
+
+  assert(value != NULL);
+  assert(value->type == CJSON_OBJECT);
+
+  cjson_lazy_resolve(value);
+  assert(!(value->flags & CJSON_FLAG_ARENA));  //arena中的对象不能增删成员，延迟解析的值要解析之后才有这个标记
+  index = value->u.obj.index;
+  i = cjson_object_find_hash(value, key, klen, hash);
+  if(i != CJSON_KEY_NOT_EXIST)  //key已经存在
+    return &value->u.obj.members[i].value;
+
+  if(value->flags & CJSON_FLAG_INSITU)  //新key在堆上，先把原地解析的key都复制到堆上，之后统一释放
+  {
+    for(i = 0; i < value->u.obj.size; i++)
+    {
+      cjson_member *m = value->u.obj.members + i;
+      char *k = (char *)CJSON_MALLOC(&cjson_global_allocator, m->key_len + 1);
+      memcpy(k, m->key, m->key_len + 1);
+      m->key = k;
+    }
+    value->flags &= ~CJSON_FLAG_INSITU;
+  }
+
+  if(value->u.obj.size >= value->u.obj.capacity)
+    cjson_resize_object(value);
+
+  (value->u.obj.members + value->u.obj.size)->key_len = klen;
+  (value->u.obj.members + value->u.obj.size)->key = (char *)CJSON_MALLOC(&cjson_global_allocator, klen + 1);
+  if(klen > 0)  //空key时key可能为NULL
+    memcpy((value->u.obj.members + value->u.obj.size)->key, key, klen);
+  (value->u.obj.members + value->u.obj.size)->key[klen] = '\0';
+  
+  cjson_value_init(&(value->u.obj.members + value->u.obj.size)->value);
+  value->u.obj.size++;
+
+  if(index != NULL && value->u.obj.size * 2 > index->mask + 1)  //负载超过一半，换成两倍大小的表
+  {
+    CJSON_FREE(&cjson_global_allocator, index);
+    index = NULL;
+  }
+  if(index != NULL)
+    cjson_index_insert(index, value->u.obj.members, value->u.obj.size - 1, hash);
+  else if(value->u.obj.size >= CJSON_OBJECT_INDEX_THRESHOLD)
+    index = cjson_index_build(&cjson_global_allocator, NULL, value->u.obj.members, value->u.obj.size);
+  value->u.obj.index = index;
+
+  return &(value->u.obj.members + value->u.obj.size - 1)->value;
+}
+
+cjson_value *cjson_set_object_value(cjson_value *value, const char* key, size_t klen)
+{
+  assert(key != NULL && klen > 0);
+  assert(value != NULL);
+  assert(value->type == CJSON_OBJECT);
+
+  cjson_lazy_resolve(value);
+  return cjson_object_set(value, key, klen, value->u.obj.index ? cjson_hash_key(key, klen) : 0);
+}
+
+size_t cjson_find_object_index(cjson_value value, const char* key, size_t klen)
+{
+  assert(key != NULL && klen > 0);
+  assert(value.type == CJSON_OBJECT);
+
+  return cjson_object_find(cjson_lazy_get(&value), key, klen);
+}
+
+cjson_value *cjson_find_object_value(cjson_value value, const char* key, size_t klen)
+{
+  size_t i = cjson_find_object_index(value, key, klen);
+  return i == CJSON_KEY_NOT_EXIST ? NULL : cjson_get_object_value(value, i);
+}
+
+void cjson_remove_object_value(cjson_value *value, size_t index)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_OBJECT);
+  cjson_lazy_resolve(value);
+  assert(!(value->flags & CJSON_FLAG_ARENA));
+  assert(index < value->u.obj.size);
+
+  cjson_value_free(&value->u.obj.members[index].value); 
+  if(!(value->flags & CJSON_FLAG_INSITU))
+    CJSON_FREE(&cjson_global_allocator, value->u.obj.members[index].key);
+
+  value->u.obj.size--;
+  memmove(value->u.obj.members + index, value->u.obj.members + index + 1, sizeof(cjson_member) * (value->u.obj.size - index));
+  if(value->u.obj.index)  //后面成员的下标都变了，重建索引
+    cjson_index_rehash(value->u.obj.index, value->u.obj.members, value->u.obj.size);
+}
+
+void cjson_clear_object(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_OBJECT);
+  cjson_lazy_resolve(value);
+  assert(!(value->flags & CJSON_FLAG_ARENA));
+
+  for(size_t i = 0; i < value->u.obj.size; i++)
+  {
+    cjson_value_free(&value->u.obj.members[i].value); 
+    if(!(value->flags & CJSON_FLAG_INSITU))
+      CJSON_FREE(&cjson_global_allocator, value->u.obj.members[i].key);
+  }
+  value->flags &= ~CJSON_FLAG_INSITU;   //已经没有指向输入缓冲区的key了
+  value->u.obj.size = 0;
+  if(value->u.obj.index)
+    CJSON_FREE(&cjson_global_allocator, value->u.obj.index);
+  value->u.obj.index = NULL;
+}
+
+void cjson_shrink_object(cjson_value *value)
+{
+  assert(value != NULL);
+  assert(value->type == CJSON_OBJECT);
+  cjson_lazy_resolve(value);
+  assert(!(value->flags & CJSON_FLAG_ARENA));
+  // assert(value->u.obj.capacity > value->u.obj.size);
+
+  value->u.obj.capacity = value->u.obj.size;
+  if(value->u.obj.capacity == 0)
+  {
+    if(value->u.obj.members)
+      CJSON_FREE(&cjson_global_allocator, value->u.obj.members);
+    value->u.obj.members = NULL;
+  }
+  else
+    value->u.obj.members = (cjson_member *)CJSON_REALLOC(&cjson_global_allocator, value->u.obj.members, sizeof(cjson_member) * value->u.obj.size);
+}
+
+cjson_arena *cjson_arena_create(size_t block_size)
+{
+  cjson_arena *arena = (cjson_arena *)CJSON_MALLOC(&cjson_global_allocator, sizeof(cjson_arena));
+
+  arena->allocator = cjson_global_allocator;
+  arena->head = NULL;
+  arena->block_size = block_size > 0 ? CJSON_ARENA_ALIGN(block_size) : CJSON_ARENA_BLOCK_SIZE;
+  return arena;
+}
+
+void cjson_arena_reset(cjson_arena *arena)
+{
+  cjson_arena_block *b, *next, *keep = NULL;
+  assert(arena != NULL);
+
+  for(b = arena->head; b != NULL; b = next)
+  {
+    next = b->next;
+    if(keep == NULL && b->size == arena->block_size)  //保留一个标准大小的块
+      keep = b;
+    else
+      CJSON_FREE(&arena->allocator, b);
+  }
+
+  if(keep)
+  {
+    keep->next = NULL;
+    keep->used = 0;
+  }
+  arena->head = keep;
+}
+
+void cjson_arena_destroy(cjson_arena *arena)
+{
+  cjson_arena_block *b, *next;
+
+  if(arena == NULL)
+    return;
+
+  for(b = arena->head; b != NULL; b = next)
+  {
+    next = b->next;
+    CJSON_FREE(&arena->allocator, b);
+  }
+  CJSON_FREE(&arena->allocator, arena);
+}
+
+CJSON_STATUS cjson_arena_parse(cjson_arena *arena, cjson_value *v, const char *json, size_t len)
+{
+  assert(arena != NULL);
+  return cjson_parse_root(&arena->allocator, arena, 0, v, json, len);
+}
+
+void cjson_arena_copy(cjson_arena *arena, cjson_value *dest, const cjson_value *src)
+{
+  assert(arena != NULL);
+  assert(dest != NULL && src != NULL);
+  if(dest == src)
+    return;
+  cjson_value_free(dest);
+  cjson_copy_value(NULL, arena, dest, src);
+}
+
+void cjson_arena_set_string(cjson_arena *arena, cjson_value *value, const char *buf, size_t len)
+{
+  assert(arena != NULL);
+  assert(value != NULL);
+  assert(buf != NULL || len == 0);
+  cjson_value_free(value);
+  cjson_set_string_raw(NULL, arena, value, buf, len);
+}
+
+static void cjson_parser_resize_stack(cjson_parser *parser, size_t size)  //把栈调整到size字节，size为0时释放
+{
+  cjson_context *c = &parser->c;
+
+  if(c->size == size)
+    return;
+  if(size == 0)
+  {
+    CJSON_FREE(&parser->allocator, c->stack);
+    c->stack = NULL;
+  }
+  else
+    c->stack = CJSON_REALLOC(&parser->allocator, c->stack, size);
+  c->size = size;
+}
+
+static void cjson_parser_free_tokens(cjson_parser *parser)
+{
+  if(parser->tokens != NULL)
+    CJSON_FREE(&parser->allocator, parser->tokens);
+  parser->tokens = NULL;
+  parser->token_capacity = 0;
+}
+
+static void cjson_parser_trim(cjson_parser *parser)
+{
+  if(parser->trim_size > 0 && parser->c.size > parser->trim_size)   //超过高水位就收缩，避免一次大文档之后一直占用大块内存
+    cjson_parser_resize_stack(parser, parser->stack_size);
+  if(parser->trim_size > 0 && parser->token_capacity * sizeof(uint32_t) > parser->trim_size)
+    cjson_parser_free_tokens(parser);
+}
+
+static CJSON_STATUS cjson_parser_run(cjson_parser *parser, cjson_value *v, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+
+#ifdef CJSON_STATS
+  parser->c.stats = parser->stats;  //只统计DOM解析，SAX不统计
+#endif
+  if(parser->indexed)
+    ret = cjson_parse_context_indexed(&parser->c, &parser->tokens, &parser->token_capacity, v, json, len);
+  else
+    ret = cjson_parse_context(&parser->c, v, json, len);
+#ifdef CJSON_STATS
+  parser->c.stats = NULL;
+#endif
+  return ret;
+}
+
+cjson_parser *cjson_parser_create(size_t stack_size)
+{
+  cjson_parser *parser = (cjson_parser *)CJSON_MALLOC(&cjson_global_allocator, sizeof(cjson_parser));
+
+  memset(parser, 0, sizeof(cjson_parser));
+  parser->allocator = cjson_global_allocator;
+  parser->c.allocator = &parser->allocator;
+  parser->stack_size = stack_size > 0 ? stack_size : CJSON_STACK_SIZE;
+  cjson_parser_resize_stack(parser, parser->stack_size);
+  return parser;
+}
+
+void cjson_parser_destroy(cjson_parser *parser)
+{
+  if(parser == NULL)
+    return;
+  cjson_parser_resize_stack(parser, 0);
+  cjson_parser_free_tokens(parser);
+  CJSON_FREE(&parser->allocator, parser);
+}
+
+void cjson_parser_reset(cjson_parser *parser)
+{
+  assert(parser != NULL);
+  parser->c.top = 0;
+  cjson_parser_resize_stack(parser, parser->stack_size);
+  cjson_parser_free_tokens(parser);
+}
+
+void cjson_parser_set_trim(cjson_parser *parser, size_t trim_size)
+{
+  assert(parser != NULL);
+  parser->trim_size = trim_size;
+}
+
+void cjson_parser_set_arena(cjson_parser *parser, cjson_arena *arena)
+{
+  assert(parser != NULL);
+  parser->c.arena = arena;
+}
+
+void cjson_parser_set_max_depth(cjson_parser *parser, size_t max_depth)
+{
+  assert(parser != NULL);
+  parser->c.max_depth = max_depth;
+}
+
+void cjson_parser_set_indexed(cjson_parser *parser, int indexed)
+{
+  assert(parser != NULL);
+  parser->indexed = indexed;
+}
+
+#ifdef CJSON_STATS
+void cjson_parser_set_stats(cjson_parser *parser, cjson_parse_stats *stats)
+{
+  assert(parser != NULL);
+  parser->stats = stats;
+}
+#endif
+
+size_t cjson_parser_get_stack_size(const cjson_parser *parser)
+{
+  assert(parser != NULL);
+  return parser->c.size;
+}
+
+CJSON_STATUS cjson_parser_parse(cjson_parser *parser, cjson_value *v, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  assert(parser != NULL);
+
+  ret = cjson_parser_run(parser, v, json, len);
+  cjson_parser_trim(parser);
+  return ret;
+}
+
+CJSON_STATUS cjson_parser_parse_insitu(cjson_parser *parser, cjson_value *v, char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  assert(parser != NULL);
+
+  parser->c.insitu = 1;
+  ret = cjson_parser_run(parser, v, json, len);
+  parser->c.insitu = 0;
+  cjson_parser_trim(parser);
+  return ret;
+}
+
+const char *cjson_parser_stringify(cjson_parser *parser, const cjson_value *v, size_t *length)
+{
+  assert(parser != NULL);
+  assert(v != NULL);
+
+  cjson_parser_trim(parser);   //上一次序列化的结果还在栈里，所以在调用开始时收缩
+  cjson_stringify_context(&parser->c, v, length);
+  return parser->c.stack;
+}
+
+CJSON_STATUS cjson_sax_parse(const cjson_handler *handler, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  cjson_context c = {0};
+
+  c.allocator = &cjson_global_allocator;
+  ret = cjson_sax_context(&c, handler, json, len);
+  if(c.stack)
+    CJSON_FREE(c.allocator, c.stack);
+  return ret;
+}
+
+CJSON_STATUS cjson_parser_sax(cjson_parser *parser, const cjson_handler *handler, const char *json, size_t len)
+{
+  CJSON_STATUS ret;
+  assert(parser != NULL);
+
+  ret = cjson_sax_context(&parser->c, handler, json, len);
+  cjson_parser_trim(parser);
+  return ret;
+}
+
+//---------------------------JSON Pointer---------------------------//
+//RFC 6901，编译时把路径拆成token，还原~1、~0，算好key的哈希和数组下标，每次查找只需要逐层取子节点
+
+#define CJSON_POINTER_NOT_INDEX ((size_t)-1)  //token不是合法的数组下标
+#define CJSON_POINTER_END       ((size_t)-2)  //"-"，数组最后一个元素之后的位置
+
+typedef struct
+{
+  const char *key;  //还原之后的key，在pointer的内存中，不以'\0'结尾
+  size_t key_len;
+  size_t hash;      //cjson_hash_key(key, key_len)
+  size_t index;     //作为数组下标的值
+}cjson_pointer_token;
+
+struct cjson_pointer__
+{
+  cjson_allocator allocator;  //编译时的全局分配器
+  size_t size;                //token个数，0表示整个文档
+  cjson_pointer_token tokens[];   //所有key的内容紧跟在tokens之后
+};
+
+static size_t cjson_pointer_index(const char *key, size_t len)  //0或者不以0开头的十进制数
+{
+  size_t index = 0;
+
+  if(len == 1 && key[0] == '-')
+    return CJSON_POINTER_END;
+  if(len == 0 || len > 19 || (key[0] == '0' && len > 1))  //19位以内不会溢出
+    return CJSON_POINTER_NOT_INDEX;
+  for(size_t i = 0; i < len; i++)
+  {
+    if(!IS0TO9(key[i]))
+      return CJSON_POINTER_NOT_INDEX;
+    index = index * 10 + (key[i] - '0');
+  }
+  return index;
+}
+
+static cjson_value *cjson_pointer_step(const cjson_value *v, const cjson_pointer_token *t)  //取v中t指向的子节点，不存在时返回NULL
+{
+  size_t i;
+
+  v = cjson_lazy_get(v);
+  if(v->type == CJSON_OBJECT)
+  {
+    i = cjson_object_find_hash(v, t->key, t->key_len, t->hash);
+    return i == CJSON_KEY_NOT_EXIST ? NULL : &v->u.obj.members[i].value;
+  }
+  if(v->type == CJSON_ARRAY && t->index < v->u.arr.size)  //两个特殊下标都大于任何数组的大小
+    return v->u.arr.elements + t->index;
+  return NULL;
+}
+
+static cjson_value *cjson_pointer_parent(const cjson_pointer *pointer, const cjson_value *root)  //最后一个token所在的容器
+{
+  const cjson_value *v = root;
+
+  for(size_t i = 0; v != NULL && i + 1 < pointer->size; i++)
+    v = cjson_pointer_step(v, pointer->tokens + i);
+  return (cjson_value *)v;
+}
+
+cjson_pointer *cjson_pointer_compile(const char *path, size_t len)
+{
+  cjson_pointer *pointer;
+  cjson_pointer_token *t;
+  const char *p = path, *end = path + len;
+  char *key;
+  size_t size = 0;
+
+  assert(path != NULL || len == 0);
+  if(len > 0 && path[0] != '/')
+    return NULL;
+  for(size_t i = 0; i < len; i++)
+    size += path[i] == '/';
+
+  pointer = (cjson_pointer *)CJSON_MALLOC(&cjson_global_allocator, sizeof(cjson_pointer) + size * sizeof(cjson_pointer_token) + len);
+  pointer->allocator = cjson_global_allocator;
+  pointer->size = size;
+  key = (char *)(pointer->tokens + size);
+
+  for(t = pointer->tokens; p < end; t++)
+  {
+    t->key = key;
+    for(p++; p < end && *p != '/'; p++)   //跳过'/'，还原到下一个'/'为止
+    {
+      if(*p != '~')
+        *key++ = *p;
+      else if(p + 1 < end && (p[1] == '0' || p[1] == '1'))
+        *key++ = *++p == '0' ? '~' : '/';
+      else  //'~'之后只能是0或1
+      {
+        cjson_pointer_free(pointer);
+        return NULL;
+      }
+    }
+    t->key_len = key - t->key;
+    t->hash = cjson_hash_key(t->key, t->key_len);
+    t->index = cjson_pointer_index(t->key, t->key_len);
+  }
+  return pointer;
+}
+
+void cjson_pointer_free(cjson_pointer *pointer)
+{
+  if(pointer)
+    CJSON_FREE(&pointer->allocator, pointer);
+}
+
+cjson_value *cjson_pointer_get(const cjson_pointer *pointer, const cjson_value *root)
+{
+  cjson_value *v;
+
+  assert(pointer != NULL && root != NULL);
+  if(pointer->size == 0)
+    return (cjson_value *)root;
+  if((v = cjson_pointer_parent(pointer, root)) == NULL)
+    return NULL;
+  return cjson_pointer_step(v, pointer->tokens + pointer->size - 1);
+}
+
+cjson_value *cjson_pointer_set(const cjson_pointer *pointer, cjson_value *root)
+{
+  const cjson_pointer_token *t;
+  cjson_value *v;
+
+  assert(pointer != NULL && root != NULL);
+  if(pointer->size == 0)
+    return root;
+  if((v = cjson_pointer_parent(pointer, root)) == NULL)
+    return NULL;
+
+  cjson_lazy_resolve(v);
+  t = pointer->tokens + pointer->size - 1;
+  if(v->type == CJSON_OBJECT)
+    return cjson_object_set(v, t->key, t->key_len, t->hash);
+  if(v->type == CJSON_ARRAY)
+  {
+    if(t->index < v->u.arr.size)
+      return v->u.arr.elements + t->index;
+    if(t->index == v->u.arr.size || t->index == CJSON_POINTER_END)
+      return cjson_pushback_array_element(v);
+  }
+  return NULL;
+}
+
+int cjson_pointer_remove(const cjson_pointer *pointer, cjson_value *root)
+{
+  const cjson_pointer_token *t;
+  cjson_value *v;
+  size_t i;
+
+  assert(pointer != NULL && root != NULL);
+  if(pointer->size == 0 || (v = cjson_pointer_parent(pointer, root)) == NULL)
+    return 0;
+
+  cjson_lazy_resolve(v);
+  t = pointer->tokens + pointer->size - 1;
+  if(v->type == CJSON_OBJECT && (i = cjson_object_find_hash(v, t->key, t->key_len, t->hash)) != CJSON_KEY_NOT_EXIST)
+    cjson_remove_object_value(v, i);
+  else if(v->type == CJSON_ARRAY && t->index < v->u.arr.size)
+    cjson_erase_array_element(v, t->index, 1);
+  else
+    return 0;
+  return 1;
+}
+
+//---------------------------tape---------------------------//
+//只读的扁平表示：整个文档是一段连续的64位字，高8位是标签，低56位是参数，字符串放在字后面的同一块内存中
+//数字：标签之后的一个字是int64/uint64/double的位；字符串：参数是字符串区中的偏移，那里是8字节长度、内容和'\0'
+//数组和对象：参数是元素表的位置，元素表是个数加上每个元素(对象是每个key)的位置，对象的值紧跟在key之后
+//元素表放在所有元素之后，这样解析时不需要预先知道元素个数
+
+enum
+{
+  CJSON_TAPE_NULL,
+  CJSON_TAPE_TRUE,
+  CJSON_TAPE_FALSE,
+  CJSON_TAPE_DOUBLE,
+  CJSON_TAPE_INT64,
+  CJSON_TAPE_UINT64,
+  CJSON_TAPE_STRING,
+  CJSON_TAPE_ARRAY,
+  CJSON_TAPE_OBJECT
+};
+
+#define CJSON_TAPE_WORD(tag, payload) (((uint64_t)(tag) << 56) | (uint64_t)(payload))
+#define CJSON_TAPE_TAG(word) ((unsigned)((word) >> 56))
+#define CJSON_TAPE_PAYLOAD(word) ((size_t)((word) & (((uint64_t)1 << 56) - 1)))
+
+struct cjson_tape__
+{
+  cjson_allocator allocator;  //创建时的全局分配器
+  size_t size;                //字数
+  uint64_t *words;
+  char *strings;              //字符串区
+};
+
+typedef struct
+{
+  size_t parent;    //外层帧在栈中的位置
+  size_t header;    //容器标签字的位置，结束时填入元素表的位置
+  cjson_type type;
+}cjson_tape_frame;
+
+typedef struct
+{
+  const cjson_allocator *allocator;
+  cjson_walk w;       //每层容器一帧，帧的上面是这一层已经完成的元素(对象是key)的位置
+  size_t frame;       //最内层的帧，CJSON_NO_FRAME表示在根层
+  uint64_t *words;
+  size_t size, capacity;
+  char *strings;
+  size_t strings_len, strings_capacity;
+}cjson_tape_builder;
+
+static void cjson_tape_builder_init(cjson_tape_builder *b, const cjson_allocator *a)
+{
+  memset(b, 0, sizeof(cjson_tape_builder));
+  b->allocator = a;
+  cjson_walk_init(&b->w, a);
+  b->frame = CJSON_NO_FRAME;
+}
+
+static void cjson_tape_builder_free(cjson_tape_builder *b)
+{
+  cjson_walk_free(&b->w);
+  if(b->words != NULL)
+    CJSON_FREE(b->allocator, b->words);
+  if(b->strings != NULL)
+    CJSON_FREE(b->allocator, b->strings);
+}
+
+static size_t cjson_tape_append(cjson_tape_builder *b, uint64_t word)  //返回这个字的位置
+{
+  if(b->size == b->capacity)
+  {
+    b->capacity = b->capacity > 0 ? b->capacity + (b->capacity >> 1) : 64;
+    b->words = (uint64_t *)CJSON_REALLOC(b->allocator, b->words, b->capacity * sizeof(uint64_t));
+  }
+  b->words[b->size] = word;
+  return b->size++;
+}
+
+static void cjson_tape_start(cjson_tape_builder *b)   //一个值开始，数组中记录它的位置
+{
+  if(b->frame != CJSON_NO_FRAME && ((cjson_tape_frame *)(b->w.stack + b->frame))->type == CJSON_ARRAY)
+    *(uint64_t *)cjson_walk_push(&b->w, sizeof(uint64_t)) = b->size;
+}
+
+static void cjson_tape_scalar(cjson_tape_builder *b, const cjson_value *v)  //null、布尔、数字
+{
+  static const unsigned char tags[] = { CJSON_TAPE_NULL, CJSON_TAPE_TRUE, CJSON_TAPE_FALSE };
+
+  cjson_tape_start(b);
+  if(v->type != CJSON_NUMBER)
+    cjson_tape_append(b, CJSON_TAPE_WORD(tags[v->type], 0));
+  else
+  {
+    cjson_tape_append(b, CJSON_TAPE_WORD(v->flags & CJSON_FLAG_UINT64 ? CJSON_TAPE_UINT64 : v->flags & CJSON_FLAG_INT64 ? CJSON_TAPE_INT64 : CJSON_TAPE_DOUBLE, 0));
+    cjson_tape_append(b, v->u.u64);   //三种数字都按位保存
+  }
+}
+
+static void cjson_tape_string(cjson_tape_builder *b, const char *str, size_t len, int key)
+{
+  uint64_t l = len;
+
+  if(key)
+    *(uint64_t *)cjson_walk_push(&b->w, sizeof(uint64_t)) = b->size;
+  else
+    cjson_tape_start(b);
+  if(b->strings_len + sizeof(l) + len + 1 > b->strings_capacity)
+  {
+    if(b->strings_capacity == 0)
+      b->strings_capacity = 256;
+    while(b->strings_len + sizeof(l) + len + 1 > b->strings_capacity)
+      b->strings_capacity += b->strings_capacity >> 1;
+    b->strings = (char *)CJSON_REALLOC(b->allocator, b->strings, b->strings_capacity);
+  }
+  cjson_tape_append(b, CJSON_TAPE_WORD(CJSON_TAPE_STRING, b->strings_len));
+  memcpy(b->strings + b->strings_len, &l, sizeof(l));
+  if(len > 0)
+    memcpy(b->strings + b->strings_len + sizeof(l), str, len);
+  b->strings[b->strings_len + sizeof(l) + len] = '\0';
+  b->strings_len += sizeof(l) + len + 1;
+}
+
+static void cjson_tape_open(cjson_tape_builder *b, cjson_type type)
+{
+  cjson_tape_frame *f;
+
+  cjson_tape_start(b);
+  f = (cjson_tape_frame *)cjson_walk_push(&b->w, sizeof(cjson_tape_frame));
+  f->parent = b->frame;
+  f->header = cjson_tape_append(b, CJSON_TAPE_WORD(type == CJSON_ARRAY ? CJSON_TAPE_ARRAY : CJSON_TAPE_OBJECT, 0));
+  f->type = type;
+  b->frame = (char *)f - b->w.stack;
+}
+
+static void cjson_tape_close(cjson_tape_builder *b)   //最内层容器结束，写出元素表
+{
+  cjson_tape_frame *f = (cjson_tape_frame *)(b->w.stack + b->frame);
+  const uint64_t *pos = (const uint64_t *)(f + 1);
+  size_t count = (b->w.top - b->frame - sizeof(cjson_tape_frame)) / sizeof(uint64_t), table;
+
+  table = cjson_tape_append(b, count);
+  b->words[f->header] |= table;
+  for(size_t i = 0; i < count; i++)
+    cjson_tape_append(b, pos[i]);
+  b->w.top = b->frame;
+  b->frame = f->parent;
+}
+
+static cjson_tape *cjson_tape_finish(cjson_tape_builder *b)  //字和字符串区收缩到实际大小，所有权转移到tape
+{
+  cjson_tape *tape = (cjson_tape *)CJSON_MALLOC(b->allocator, sizeof(cjson_tape));
+
+  tape->allocator = *b->allocator;
+  tape->size = b->size;
+  tape->words = (uint64_t *)CJSON_REALLOC(b->allocator, b->words, b->size * sizeof(uint64_t));
+  tape->strings = b->strings_len > 0 ? (char *)CJSON_REALLOC(b->allocator, b->strings, b->strings_len) : b->strings;
+  b->words = NULL;
+  b->strings = NULL;
+  cjson_tape_builder_free(b);
+  return tape;
+}
+
+static int cjson_tape_sax_null(void *ud)
+{
+  cjson_value v;
+  cjson_value_init(&v);
+  cjson_tape_scalar((cjson_tape_builder *)ud, &v);
+  return 1;
+}
+
+static int cjson_tape_sax_boolean(void *ud, int b)
+{
+  cjson_value v;
+  cjson_value_init(&v);
+  v.type = b ? CJSON_TRUE : CJSON_FALSE;
+  cjson_tape_scalar((cjson_tape_builder *)ud, &v);
+  return 1;
+}
+
+static int cjson_tape_sax_number(void *ud, const cjson_value *num)  { cjson_tape_scalar((cjson_tape_builder *)ud, num); return 1; }
+static int cjson_tape_sax_string(void *ud, const char *str, size_t len)  { cjson_tape_string((cjson_tape_builder *)ud, str, len, 0); return 1; }
+static int cjson_tape_sax_key(void *ud, const char *key, size_t len)  { cjson_tape_string((cjson_tape_builder *)ud, key, len, 1); return 1; }
+static int cjson_tape_sax_start_object(void *ud)  { cjson_tape_open((cjson_tape_builder *)ud, CJSON_OBJECT); return 1; }
+static int cjson_tape_sax_start_array(void *ud)  { cjson_tape_open((cjson_tape_builder *)ud, CJSON_ARRAY); return 1; }
+static int cjson_tape_sax_end(void *ud, size_t size)  { (void)size; cjson_tape_close((cjson_tape_builder *)ud); return 1; }
+
+CJSON_STATUS cjson_tape_parse(cjson_tape **tape, const char *json, size_t len)
+{
+  cjson_tape_builder b;
+  cjson_handler h = {
+    cjson_tape_sax_null, cjson_tape_sax_boolean, cjson_tape_sax_number, cjson_tape_sax_string, cjson_tape_sax_key,
+    cjson_tape_sax_start_object, cjson_tape_sax_end, cjson_tape_sax_start_array, cjson_tape_sax_end, NULL
+  };
+  cjson_context c = {0};
+  CJSON_STATUS ret;
+
+  assert(tape != NULL);
+  cjson_tape_builder_init(&b, &cjson_global_allocator);
+  b.capacity = len / 8 + 64;  //按输入长度预估，减少扩容次数
+  b.words = (uint64_t *)CJSON_MALLOC(b.allocator, b.capacity * sizeof(uint64_t));
+  h.ud = &b;
+  c.allocator = &cjson_global_allocator;
+  ret = cjson_sax_context(&c, &h, json, len);
+  if(c.stack)
+    CJSON_FREE(c.allocator, c.stack);
+  if(ret != CJSON_OK)
+  {
+    cjson_tape_builder_free(&b);
+    *tape = NULL;
+    return ret;
+  }
+  *tape = cjson_tape_finish(&b);
+  return CJSON_OK;
+}
+
+cjson_tape *cjson_tape_from_value(const cjson_value *v)
+{
+  cjson_tape_builder b;
+  cjson_copy_frame *f;
+  cjson_walk w;
+
+  assert(v != NULL);
+  cjson_tape_builder_init(&b, &cjson_global_allocator);
+  cjson_walk_init(&w, &cjson_global_allocator);
+  while(1)
+  {
+    v = cjson_lazy_get(v);
+    switch(v->type)
+    {
+      case CJSON_STRING:
+        cjson_tape_string(&b, v->u.str.buf, v->u.str.l, 0);
+        break;
+      case CJSON_ARRAY:
+      case CJSON_OBJECT:
+        cjson_tape_open(&b, v->type);
+        f = (cjson_copy_frame *)cjson_walk_push(&w, sizeof(cjson_copy_frame));
+        f->src = v;
+        f->i = 0;
+        break;
+      default:
+        cjson_tape_scalar(&b, v);
+        break;
+    }
+
+    //找到下一个值，结束的容器写出元素表
+    v = NULL;
+    while(w.top > 0)
+    {
+      f = CJSON_WALK_TOP(&w, cjson_copy_frame);
+      if(f->src->type == CJSON_ARRAY && f->i < f->src->u.arr.size)
+      {
+        v = f->src->u.arr.elements + f->i++;
+        break;
+      }
+      if(f->src->type == CJSON_OBJECT && f->i < f->src->u.obj.size)
+      {
+        const cjson_member *m = f->src->u.obj.members + f->i++;
+        cjson_tape_string(&b, m->key, m->key_len, 1);
+        v = &m->value;
+        break;
+      }
+      cjson_tape_close(&b);
+      CJSON_WALK_POP(&w, cjson_copy_frame);
+    }
+    if(v == NULL)
+      break;
+  }
+  cjson_walk_free(&w);
+  return cjson_tape_finish(&b);
+}
+
+void cjson_tape_free(cjson_tape *tape)
+{
+  if(tape == NULL)
+    return;
+  CJSON_FREE(&tape->allocator, tape->words);
+  if(tape->strings != NULL)
+    CJSON_FREE(&tape->allocator, tape->strings);
+  CJSON_FREE(&tape->allocator, tape);
+}
+
+cjson_tape_value cjson_tape_root(const cjson_tape *tape)
+{
+  cjson_tape_value v;
+  assert(tape != NULL);
+  v.tape = tape;
+  v.pos = 0;
+  return v;
+}
+
+#define CJSON_TAPE_AT(v) ((v).tape->words[(v).pos])
+
+cjson_type cjson_tape_get_type(cjson_tape_value value)
+{
+  static const cjson_type types[] = { CJSON_NULL, CJSON_TRUE, CJSON_FALSE, CJSON_NUMBER, CJSON_NUMBER, CJSON_NUMBER, CJSON_STRING, CJSON_ARRAY, CJSON_OBJECT };
+  return types[CJSON_TAPE_TAG(CJSON_TAPE_AT(value))];
+}
+
+int cjson_tape_get_boolean(cjson_tape_value value)
+{
+  assert(cjson_tape_get_type(value) == CJSON_TRUE || cjson_tape_get_type(value) == CJSON_FALSE);
+  return CJSON_TAPE_TAG(CJSON_TAPE_AT(value)) == CJSON_TAPE_TRUE;
+}
+
+static void cjson_tape_get_value(cjson_tape_value value, cjson_value *v)   //数字读成cjson_value，和树使用同样的转换规则
+{
+  unsigned tag = CJSON_TAPE_TAG(CJSON_TAPE_AT(value));
+
+  assert(tag == CJSON_TAPE_DOUBLE || tag == CJSON_TAPE_INT64 || tag == CJSON_TAPE_UINT64);
+  v->type = CJSON_NUMBER;
+  v->flags = tag == CJSON_TAPE_INT64 ? CJSON_FLAG_INT64 : tag == CJSON_TAPE_UINT64 ? CJSON_FLAG_UINT64 : 0;
+  v->u.u64 = value.tape->words[value.pos + 1];
+}
+
+double cjson_tape_get_number(cjson_tape_value value)
+{
+  cjson_value v;
+  cjson_tape_get_value(value, &v);
+  return cjson_get_number(v);
+}
+
+int cjson_tape_is_integer(cjson_tape_value value)
+{
+  cjson_value v;
+  cjson_tape_get_value(value, &v);
+  return cjson_is_integer(v);
+}
+
+int64_t cjson_tape_get_int64(cjson_tape_value value)
+{
+  cjson_value v;
+  cjson_tape_get_value(value, &v);
+  return cjson_get_int64(v);
+}
+
+uint64_t cjson_tape_get_uint64(cjson_tape_value value)
+{
+  cjson_value v;
+  cjson_tape_get_value(value, &v);
+  return cjson_get_uint64(v);
+}
+
+size_t cjson_tape_get_string_length(cjson_tape_value value)
+{
+  uint64_t l;
+  assert(CJSON_TAPE_TAG(CJSON_TAPE_AT(value)) == CJSON_TAPE_STRING);
+  memcpy(&l, value.tape->strings + CJSON_TAPE_PAYLOAD(CJSON_TAPE_AT(value)), sizeof(l));
+  return (size_t)l;
+}
+
+const char *cjson_tape_get_string(cjson_tape_value value)
+{
+  assert(CJSON_TAPE_TAG(CJSON_TAPE_AT(value)) == CJSON_TAPE_STRING);
+  return value.tape->strings + CJSON_TAPE_PAYLOAD(CJSON_TAPE_AT(value)) + sizeof(uint64_t);
+}
+
+static const uint64_t *cjson_tape_table(cjson_tape_value value, unsigned tag)  //容器的元素表，第一个字是个数
+{
+  assert(CJSON_TAPE_TAG(CJSON_TAPE_AT(value)) == tag);
+  (void)tag;
+  return value.tape->words + CJSON_TAPE_PAYLOAD(CJSON_TAPE_AT(value));
+}
+
+size_t cjson_tape_get_array_size(cjson_tape_value value)
+{
+  return (size_t)cjson_tape_table(value, CJSON_TAPE_ARRAY)[0];
+}
+
+cjson_tape_value cjson_tape_get_array_element(cjson_tape_value value, size_t index)
+{
+  const uint64_t *table = cjson_tape_table(value, CJSON_TAPE_ARRAY);
+  assert(index < table[0]);
+  value.pos = (size_t)table[1 + index];
+  return value;
+}
+
+size_t cjson_tape_get_object_size(cjson_tape_value value)
+{
+  return (size_t)cjson_tape_table(value, CJSON_TAPE_OBJECT)[0];
+}
+
+static cjson_tape_value cjson_tape_get_object_key_value(cjson_tape_value value, size_t index)  //第index个成员的key
+{
+  const uint64_t *table = cjson_tape_table(value, CJSON_TAPE_OBJECT);
+  assert(index < table[0]);
+  value.pos = (size_t)table[1 + index];
+  return value;
+}
+
+const char *cjson_tape_get_object_key(cjson_tape_value value, size_t index)
+{
+  return cjson_tape_get_string(cjson_tape_get_object_key_value(value, index));
+}
+
+size_t cjson_tape_get_object_key_length(cjson_tape_value value, size_t index)
+{
+  return cjson_tape_get_string_length(cjson_tape_get_object_key_value(value, index));
+}
+
+cjson_tape_value cjson_tape_get_object_value(cjson_tape_value value, size_t index)
+{
+  value = cjson_tape_get_object_key_value(value, index);
+  value.pos++;
+  return value;
+}
+
+size_t cjson_tape_find_object_index(cjson_tape_value value, const char *key, size_t klen)   //线性查找，有重复key时返回第一个
+{
+  size_t size = cjson_tape_get_object_size(value);
+
+  assert(key != NULL || klen == 0);
+  for(size_t i = 0; i < size; i++)
+  {
+    cjson_tape_value k = cjson_tape_get_object_key_value(value, i);
+    if(cjson_tape_get_string_length(k) == klen && (klen == 0 || memcmp(cjson_tape_get_string(k), key, klen) == 0))
+      return i;
+  }
+  return CJSON_KEY_NOT_EXIST;
+}
+
+typedef struct
+{
+  cjson_tape_value src;
+  cjson_value *dest;
+  size_t i;
+}cjson_tape_convert_frame;
+
+void cjson_tape_to_value(cjson_tape_value value, cjson_value *dest)
+{
+  const cjson_allocator *a = &cjson_global_allocator;
+  cjson_tape_convert_frame *f;
+  cjson_walk w;
+  size_t size;
+
+  assert(dest != NULL);
+  cjson_value_free(dest);
+  cjson_walk_init(&w, a);
+  while(1)
+  {
+    dest->type = cjson_tape_get_type(value);
+    dest->flags = 0;
+    switch(dest->type)
+    {
+      case CJSON_NULL:
+      case CJSON_TRUE:
+      case CJSON_FALSE:
+        break;
+      case CJSON_NUMBER:
+        cjson_tape_get_value(value, dest);
+        break;
+      case CJSON_STRING:
+        cjson_set_string_raw(a, NULL, dest, cjson_tape_get_string(value), cjson_tape_get_string_length(value));
+        break;
+      case CJSON_ARRAY:
+        size = cjson_tape_get_array_size(value);
+        dest->u.arr.size = dest->u.arr.capacity = size;
+        dest->u.arr.elements = size > 0 ? (cjson_value *)CJSON_MALLOC(a, size * sizeof(cjson_value)) : NULL;
+        break;
+      case CJSON_OBJECT:
+        size = cjson_tape_get_object_size(value);
+        dest->u.obj.size = dest->u.obj.capacity = size;
+        dest->u.obj.members = size > 0 ? (cjson_member *)CJSON_MALLOC(a, size * sizeof(cjson_member)) : NULL;
+        for(size_t i = 0; i < size; i++)
+        {
+          cjson_member *m = dest->u.obj.members + i;
+          m->key_len = cjson_tape_get_object_key_length(value, i);
+          m->key = (char *)memcpy(CJSON_MALLOC(a, m->key_len + 1), cjson_tape_get_object_key(value, i), m->key_len + 1);  //包括'\0'
+        }
+        dest->u.obj.index = size >= CJSON_OBJECT_INDEX_THRESHOLD ? cjson_index_build(a, NULL, dest->u.obj.members, size) : NULL;
+        break;
+    }
+    if(dest->type == CJSON_ARRAY || dest->type == CJSON_OBJECT)
+    {
+      f = (cjson_tape_convert_frame *)cjson_walk_push(&w, sizeof(cjson_tape_convert_frame));
+      f->src = value;
+      f->dest = dest;
+      f->i = 0;
+    }
+
+    //找到下一个要转换的值
+    dest = NULL;
+    while(w.top > 0)
+    {
+      f = CJSON_WALK_TOP(&w, cjson_tape_convert_frame);
+      if(f->dest->type == CJSON_ARRAY && f->i < f->dest->u.arr.size)
+      {
+        value = cjson_tape_get_array_element(f->src, f->i);
+        dest = f->dest->u.arr.elements + f->i++;
+        break;
+      }
+      if(f->dest->type == CJSON_OBJECT && f->i < f->dest->u.obj.size)
+      {
+        value = cjson_tape_get_object_value(f->src, f->i);
+        dest = &f->dest->u.obj.members[f->i++].value;
+        break;
+      }
+      CJSON_WALK_POP(&w, cjson_tape_convert_frame);
+    }
+    if(dest == NULL)
       break;
+  }
+  cjson_walk_free(&w);
+}
+
+//---------------------------流式解析---------------------------//
+//输入可以在任意位置切分，每次feed只处理这一块，状态(包括字符串、转义、\uXXXX和数字的中间状态)保存在cjson_stream中
+//容器中已经完成的元素和未完成的字符串、数字都放在栈上，和cjson_parse_value()的做法相同，结果和cjson_parse()一致
+
+typedef enum
+{
+  CJSON_STREAM_VALUE,           //期待一个值
+  CJSON_STREAM_ARRAY_FIRST,     //'['之后，可以是']'或者第一个元素
+  CJSON_STREAM_ARRAY_NEXT,      //元素之后，期待','或']'
+  CJSON_STREAM_OBJECT_FIRST,    //'{'之后，可以是'}'或者第一个key
+  CJSON_STREAM_OBJECT_KEY,      //','之后，期待key
+  CJSON_STREAM_OBJECT_COLON,    //key之后，期待':'
+  CJSON_STREAM_OBJECT_NEXT,     //成员之后，期待','或'}'
+  CJSON_STREAM_ROOT_END,        //根值之后只能有空白
+  CJSON_STREAM_LITERAL,         //null，true，false中间
+  CJSON_STREAM_NUMBER,          //之后的状态在栈上有未完成的数字或字符串
+  CJSON_STREAM_STRING,
+  CJSON_STREAM_STRING_ESCAPE,   //'\'之后
+  CJSON_STREAM_STRING_HEX,      //\u之后的4位16进制数
+  CJSON_STREAM_SURROGATE_SLASH, //高代理项之后，期待'\'
+  CJSON_STREAM_SURROGATE_U      //高代理项之后，期待'u'
+}cjson_stream_state;
+
+typedef struct
+{
+  cjson_type type;  //CJSON_ARRAY或CJSON_OBJECT
+  size_t size;      //已经完成的元素(成员)个数，都在栈上
+  char *key;        //对象中正在解析的成员的key
+  size_t key_len;
+}cjson_stream_frame;
+
+struct cjson_stream__
+{
+  cjson_context c;
+  cjson_allocator allocator;  //创建时的全局分配器
+  cjson_stream_frame *frames; //还没有结束的数组和对象，frames[depth - 1]是最内层
+  size_t depth, frame_capacity;
+  cjson_value root;
+  int has_root;
+  cjson_stream_state state;
+  CJSON_STATUS status;  //出错之后一直返回这个错误，直到reset
+  size_t mark;          //当前字符串或数字在栈中的起始位置
+  int is_key;           //当前字符串是对象的key
+  const char *literal;  //正在匹配的文字和已经匹配的长度
+  cjson_type literal_type;
+  int literal_len;
+  int hex_len, low;     //\u已经读取的位数，是否在读低代理项
+  uint16_t hex, high;
+};
+
+#define IS_NUMBER_CHAR(ch) (IS0TO9(ch) || (ch) == '-' || (ch) == '+' || (ch) == '.' || (ch) == 'e' || (ch) == 'E')
+
+static void cjson_stream_clear(cjson_stream *s)   //释放还没有完成的值，回到初始状态
+{
+  cjson_context *c = &s->c;
+
+  if(s->state >= CJSON_STREAM_NUMBER)  //丢掉未完成的字符串或数字
+    c->top = s->mark;
+  while(s->depth > 0)
+  {
+    cjson_stream_frame *f = s->frames + --s->depth;
+
+    for(size_t i = 0; i < f->size; i++)
+    {
+      if(f->type == CJSON_ARRAY)
+        cjson_value_free_with_allocator(&s->allocator, (cjson_value *)cjson_pop(c, sizeof(cjson_value)));
+      else
+      {
+        cjson_member *m = (cjson_member *)cjson_pop(c, sizeof(cjson_member));
+        CJSON_FREE(&s->allocator, m->key);
+        cjson_value_free_with_allocator(&s->allocator, &m->value);
+      }
+    }
+    if(f->key)
+      CJSON_FREE(&s->allocator, f->key);
+  }
+  if(s->has_root)
+    cjson_value_free_with_allocator(&s->allocator, &s->root);
+  assert(c->top == 0);
+
+  s->has_root = 0;
+  s->mark = 0;
+  s->state = CJSON_STREAM_VALUE;
+  s->status = CJSON_OK;
+}
+
+static void cjson_stream_emit(cjson_stream *s, const cjson_value *v)   //一个值完成，放到外层容器中
+{
+  cjson_stream_frame *f;
+
+  if(s->depth == 0)
+  {
+    s->root = *v;
+    s->has_root = 1;
+    s->state = CJSON_STREAM_ROOT_END;
+    return;
+  }
+
+  f = s->frames + s->depth - 1;
+  if(f->type == CJSON_ARRAY)
+  {
+    memcpy(cjson_push(&s->c, sizeof(cjson_value)), v, sizeof(cjson_value));
+    s->state = CJSON_STREAM_ARRAY_NEXT;
+  }
+  else
+  {
+    cjson_member *m = (cjson_member *)cjson_push(&s->c, sizeof(cjson_member));
+    m->key = f->key;
+    m->key_len = f->key_len;
+    m->value = *v;
+    f->key = NULL;  //所有权转移到栈上的成员
+    s->state = CJSON_STREAM_OBJECT_NEXT;
+  }
+  f->size++;
+}
+
+static void cjson_stream_open(cjson_stream *s, cjson_type type)
+{
+  cjson_stream_frame *f;
+
+  if(s->depth == s->frame_capacity)
+  {
+    s->frame_capacity = s->frame_capacity == 0 ? 16 : s->frame_capacity + (s->frame_capacity >> 1);
+    s->frames = (cjson_stream_frame *)CJSON_REALLOC(&s->allocator, s->frames, s->frame_capacity * sizeof(cjson_stream_frame));
+  }
+  f = s->frames + s->depth++;
+  f->type = type;
+  f->size = 0;
+  f->key = NULL;
+  f->key_len = 0;
+  s->state = type == CJSON_ARRAY ? CJSON_STREAM_ARRAY_FIRST : CJSON_STREAM_OBJECT_FIRST;
+}
+
+static void cjson_stream_close(cjson_stream *s)   //最内层容器结束，元素出栈
+{
+  cjson_stream_frame *f = s->frames + --s->depth;
+  cjson_value v;
+  size_t size;
+
+  cjson_value_init(&v);
+  v.type = f->type;
+  if(f->type == CJSON_ARRAY)
+  {
+    size = f->size * sizeof(cjson_value);
+    v.u.arr.size = v.u.arr.capacity = f->size;
+    v.u.arr.elements = size > 0 ? (cjson_value *)memcpy(CJSON_MALLOC(&s->allocator, size), cjson_pop(&s->c, size), size) : NULL;
+  }
+  else
+  {
+    size = f->size * sizeof(cjson_member);
+    v.u.obj.size = v.u.obj.capacity = f->size;
+    v.u.obj.members = size > 0 ? (cjson_member *)memcpy(CJSON_MALLOC(&s->allocator, size), cjson_pop(&s->c, size), size) : NULL;
+    v.u.obj.index = f->size >= CJSON_OBJECT_INDEX_THRESHOLD ? cjson_index_build(&s->allocator, NULL, v.u.obj.members, f->size) : NULL;
+  }
+  cjson_stream_emit(s, &v);
+}
+
+static void cjson_stream_string_end(cjson_stream *s)
+{
+  size_t len = s->c.top - s->mark;
+  const char *buf = (const char *)cjson_pop(&s->c, len);
+
+  if(s->is_key)
+  {
+    cjson_stream_frame *f = s->frames + s->depth - 1;
+    f->key = (char *)CJSON_MALLOC(&s->allocator, len + 1);
+    if(len > 0)
+      memcpy(f->key, buf, len);
+    f->key[len] = '\0';
+    f->key_len = len;
+    s->state = CJSON_STREAM_OBJECT_COLON;
+  }
+  else
+  {
+    cjson_value v;
+    cjson_set_string_raw(&s->allocator, NULL, &v, buf, len);
+    cjson_stream_emit(s, &v);
+  }
+}
+
+static CJSON_STATUS cjson_stream_number_end(cjson_stream *s)  //数字后面出现了其他字符或者输入结束
+{
+  size_t len = s->c.top - s->mark;
+  const char *buf = (const char *)cjson_pop(&s->c, len);
+  cjson_context t = {0};
+  cjson_value v;
+  CJSON_STATUS ret;
+
+  t.json = buf;
+  t.end = buf + len;
+  v.flags = 0;
+  if((ret = cjson_parse_number(&t, &v)) != CJSON_OK)
+    return ret;
+  cjson_stream_emit(s, &v);
+  if(t.json != t.end)   //剩下的字符出现在值之后，和cjson_parse()一样报告外层的错误
+    return s->state == CJSON_STREAM_ROOT_END ? CJSON_ERR_ROOT_NOT_SINGULAR :
+           s->state == CJSON_STREAM_ARRAY_NEXT ? CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET : CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET;
+  return CJSON_OK;
+}
+
+static CJSON_STATUS cjson_stream_run(cjson_stream *s, const char *p, const char *end, int eof)  //eof为1时在输入结尾处理结束
+{
+  cjson_context *c = &s->c;
+  CJSON_STATUS ret;
+  int ch;   //-1表示输入结束
+  size_t len;
+
+  while(1)
+  {
+    if(p < end)
+      ch = (unsigned char)*p;
+    else if(eof)
+      ch = -1;
+    else
+      return CJSON_OK;
+
+    switch(s->state)
+    {
+      case CJSON_STREAM_VALUE:
+      case CJSON_STREAM_ARRAY_FIRST:
+        if(IS_SPACE(ch))
+        {
+          p++;
+          break;
+        }
+        if(s->state == CJSON_STREAM_ARRAY_FIRST && ch == ']')
+        {
+          p++;
+          cjson_stream_close(s);
+          break;
+        }
+        switch(ch)
+        {
+          case -1:  return CJSON_ERR_MISS_VALUE;
+          case 'n': s->literal = "null";  s->literal_type = CJSON_NULL;  break;
+          case 't': s->literal = "true";  s->literal_type = CJSON_TRUE;  break;
+          case 'f': s->literal = "false"; s->literal_type = CJSON_FALSE; break;
+          case '\"':
+            s->is_key = 0;
+            s->mark = c->top;
+            s->state = CJSON_STREAM_STRING;
+            break;
+          case '[':
+          case '{':
+            if(s->depth == CJSON_MAX_DEPTH)
+              return CJSON_ERR_DEPTH;
+            cjson_stream_open(s, ch == '[' ? CJSON_ARRAY : CJSON_OBJECT);
+            break;
+          default:  //不是数字的字符也交给cjson_parse_number()报错
+            s->mark = c->top;
+            s->state = CJSON_STREAM_NUMBER;
+            continue;
+        }
+        if(ch == 'n' || ch == 't' || ch == 'f')
+        {
+          s->literal_len = 1;
+          s->state = CJSON_STREAM_LITERAL;
+        }
+        p++;
+        break;
+
+      case CJSON_STREAM_ARRAY_NEXT:
+        if(IS_SPACE(ch))
+          p++;
+        else if(ch == ',')
+        {
+          p++;
+          s->state = CJSON_STREAM_VALUE;
+        }
+        else if(ch == ']')
+        {
+          p++;
+          cjson_stream_close(s);
+        }
+        else
+          return CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET;
+        break;
+
+      case CJSON_STREAM_OBJECT_FIRST:
+      case CJSON_STREAM_OBJECT_KEY:
+        if(IS_SPACE(ch))
+          p++;
+        else if(s->state == CJSON_STREAM_OBJECT_FIRST && ch == '}')
+        {
+          p++;
+          cjson_stream_close(s);
+        }
+        else if(ch == '\"')
+        {
+          p++;
+          s->is_key = 1;
+          s->mark = c->top;
+          s->state = CJSON_STREAM_STRING;
+        }
+        else
+          return CJSON_ERR_OBJECT_NEED_KEY;
+        break;
+
+      case CJSON_STREAM_OBJECT_COLON:
+        if(IS_SPACE(ch))
+          p++;
+        else if(ch == ':')
+        {
+          p++;
+          s->state = CJSON_STREAM_VALUE;
+        }
+        else
+          return CJSON_ERR_OBJECT_NEED_COLON;
+        break;
+
+      case CJSON_STREAM_OBJECT_NEXT:
+        if(IS_SPACE(ch))
+          p++;
+        else if(ch == ',')
+        {
+          p++;
+          s->state = CJSON_STREAM_OBJECT_KEY;
+        }
+        else if(ch == '}')
+        {
+          p++;
+          cjson_stream_close(s);
+        }
+        else
+          return CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET;
+        break;
+
+      case CJSON_STREAM_ROOT_END:
+        if(ch == -1)
+          return CJSON_OK;
+        if(!IS_SPACE(ch))
+          return CJSON_ERR_ROOT_NOT_SINGULAR;
+        p++;
+        break;
+
+      case CJSON_STREAM_LITERAL:
+        if(ch != s->literal[s->literal_len])
+          return CJSON_ERR_LITERAL;
+        p++;
+        if(s->literal[++s->literal_len] == '\0')
+        {
+          cjson_value v;
+          cjson_value_init(&v);
+          v.type = s->literal_type;
+          cjson_stream_emit(s, &v);
+        }
+        break;
+
+      case CJSON_STREAM_NUMBER:
+        for(len = 0; p + len < end && IS_NUMBER_CHAR(p[len]); len++)
+          ;
+        if(len > 0)
+        {
+          memcpy(cjson_push(c, len), p, len);
+          p += len;
+          break;
+        }
+        if((ret = cjson_stream_number_end(s)) != CJSON_OK)
+          return ret;
+        break;
+
+      case CJSON_STREAM_STRING:
+        if((len = cjson_scan_string(p, end)) > 0)
+        {
+          memcpy(cjson_push(c, len), p, len);
+          p += len;
+          break;
+        }
+        if(ch == -1)
+          return CJSON_ERR_STRING_MISS_QUOTATION_MARK;
+        p++;
+        if(ch == '\"')
+          cjson_stream_string_end(s);
+        else if(ch == '\\')
+          s->state = CJSON_STREAM_STRING_ESCAPE;
+        else
+          return CJSON_ERR_STRING_INVALID_CAHR;
+        break;
 
-    case CJSON_OBJECT:
-      for(size_t i = 0; i < src->u.obj.size; i++)
-      {//这里需要遍历每个元素，递归添加，要保证深度复制就要看数组、字符串、对象元素中的指针指向新的内存
-        size_t size = src->u.obj.size;
-        dest->u.obj.size = size;
-        size *= sizeof(cjson_member);
-        dest->u.obj.members = malloc(size);
+      case CJSON_STREAM_STRING_ESCAPE:
+        if(ch == -1)
+          return CJSON_ERR_STRING_MISS_QUOTATION_MARK;
+        p++;
+        s->state = CJSON_STREAM_STRING;
+        switch(ch)
+        {
+          case 'b':  PUSH_CHAR_TO_STACK(c, '\b'); break;
+          case 'f':  PUSH_CHAR_TO_STACK(c, '\f'); break;
+          case 'r':  PUSH_CHAR_TO_STACK(c, '\r'); break;
+          case 'n':  PUSH_CHAR_TO_STACK(c, '\n'); break;
+          case 't':  PUSH_CHAR_TO_STACK(c, '\t'); break;
+          case '\\': PUSH_CHAR_TO_STACK(c, '\\'); break;
+          case '\"': PUSH_CHAR_TO_STACK(c, '\"'); break;
+          case '/':  PUSH_CHAR_TO_STACK(c, '/');  break;
+          case 'u':
+            s->hex = 0;
+            s->hex_len = 0;
+            s->low = 0;
+            s->state = CJSON_STREAM_STRING_HEX;
+            break;
+          default:
+            return CJSON_ERR_STRING_INVALID_ESCAPE;
+        }
+        break;
 
-        size = src->u.obj.members[i].key_len * sizeof(char);
-        dest->u.obj.members[i].key_len = size;
-        memcpy(dest->u.obj.members[i].key = malloc(size + 1), src->u.obj.members[i].key, size);
-        dest->u.obj.members[i].key[size] = '\0';  //注意必须添加字符串结束符
+      case CJSON_STREAM_STRING_HEX:
+        s->hex <<= 4;
+        if(IS0TO9(ch))
+          s->hex |= ch - '0';
+        else if(ch >= 'a' && ch <= 'f')
+          s->hex |= ch - 'a' + 10;
+        else if(ch >= 'A' && ch <= 'F')
+          s->hex |= ch - 'A' + 10;
+        else
+          return CJSON_ERR_UNICODE_HEX;
+        p++;
+        if(++s->hex_len < 4)
+          break;
+        if(!s->low && s->hex >= 0xd800 && s->hex <= 0xdbff)  //高代理项，后面必须是\u和低代理项
+        {
+          s->high = s->hex;
+          s->state = CJSON_STREAM_SURROGATE_SLASH;
+          break;
+        }
+        if(s->low && (s->hex < 0xdc00 || s->hex > 0xdfff))
+          return CJSON_ERR_UNICODE_SURROGATE;
+        len = cjson_encode_utf8((char *)cjson_push(c, 4), s->low ? 0x10000 + (s->high - 0xd800) * 0x400 + (s->hex - 0xdc00) : s->hex);
+        c->top -= 4 - len;
+        s->state = CJSON_STREAM_STRING;
+        break;
 
-        cjson_copy(&dest->u.obj.members[i].value, &src->u.obj.members[i].value);
-      }
-      break;
+      case CJSON_STREAM_SURROGATE_SLASH:
+      case CJSON_STREAM_SURROGATE_U:
+        if(ch != (s->state == CJSON_STREAM_SURROGATE_SLASH ? '\\' : 'u'))
+          return CJSON_ERR_UNICODE_SURROGATE;
+        p++;
+        if(s->state == CJSON_STREAM_SURROGATE_SLASH)
+          s->state = CJSON_STREAM_SURROGATE_U;
+        else
+        {
+          s->hex = 0;
+          s->hex_len = 0;
+          s->low = 1;
+          s->state = CJSON_STREAM_STRING_HEX;
+        }
+        break;
+    }
   }
 }
 
-void cjson_move(cjson_value *dest, cjson_value *src)
+cjson_stream *cjson_stream_create(void)
 {
-  assert(dest != NULL && src != NULL);
+  cjson_stream *s = (cjson_stream *)CJSON_MALLOC(&cjson_global_allocator, sizeof(cjson_stream));
 
-  cjson_value_free(dest);
-  memcpy(dest, src, sizeof(cjson_value));
-  cjson_value_init(src);
+  memset(s, 0, sizeof(cjson_stream));
+  s->allocator = cjson_global_allocator;
+  s->c.allocator = &s->allocator;
+  s->state = CJSON_STREAM_VALUE;
+  return s;
 }
 
-void cjson_swap(cjson_value *dest, cjson_value *src)  //交换，如果是要把两个指针的指向交换的话，需要传入指针的指针
+void cjson_stream_destroy(cjson_stream *stream)
 {
-  assert(dest != NULL && src != NULL);
-  cjson_value tmp;
-
-  if(dest != src)
-  {
-    memcpy(&tmp, src, sizeof(cjson_value));
-    memcpy(src, dest, sizeof(cjson_value));
-    memcpy(dest, &tmp, sizeof(cjson_value));
-  }
+  if(stream == NULL)
+    return;
+  cjson_stream_clear(stream);
+  if(stream->c.stack)
+    CJSON_FREE(&stream->allocator, stream->c.stack);
+  if(stream->frames)
+    CJSON_FREE(&stream->allocator, stream->frames);
+  CJSON_FREE(&stream->allocator, stream);
 }
 
-cjson_type cjson_get_type(cjson_value value)
+void cjson_stream_reset(cjson_stream *stream)
 {
-  return value.type;
+  assert(stream != NULL);
+  cjson_stream_clear(stream);
 }
 
-int cjson_get_boolean(cjson_value value)
+CJSON_STATUS cjson_stream_feed(cjson_stream *stream, const char *chunk, size_t len)
 {
-  assert(value.type == CJSON_TRUE || value.type == CJSON_FALSE);
-  return value.type == CJSON_TRUE;
+  assert(stream != NULL);
+  assert(chunk != NULL || len == 0);
+
+  if(stream->status != CJSON_OK)
+    return stream->status;
+  if((stream->status = cjson_stream_run(stream, chunk, chunk + len, 0)) != CJSON_OK)
+  {
+    CJSON_STATUS ret = stream->status;
+    cjson_stream_clear(stream);   //出错之后立刻释放已经解析的部分
+    stream->status = ret;
+  }
+  return stream->status;
 }
 
-void cjson_set_boolean(cjson_value *value, int bool)
+CJSON_STATUS cjson_stream_finish(cjson_stream *stream, cjson_value *v)
 {
-  assert(value != NULL);
-  cjson_value_free(value);
-  value->type = bool ? CJSON_TRUE : CJSON_FALSE;
+  CJSON_STATUS ret;
+  assert(stream != NULL);
+  assert(v != NULL);
+
+  cjson_value_init(v);
+  if((ret = stream->status) == CJSON_OK && (ret = cjson_stream_run(stream, NULL, NULL, 1)) == CJSON_OK)
+  {
+    *v = stream->root;
+    stream->has_root = 0;
+  }
+  cjson_stream_clear(stream);   //可以接着解析下一个文档
+  return ret;
 }
 
-double cjson_get_number(cjson_value value)
+//---------------------------写出---------------------------//
+//和cjson_stringify()使用同一套生成函数，区别只是栈的大小固定，满了就交给sink
+
+#define CJSON_WRITER_OBJECT   (0x01)  //这一层是对象
+#define CJSON_WRITER_NONEMPTY (0x02)  //这一层已经写过元素，下一个元素前要加逗号
+
+struct cjson_writer__
 {
-  assert(value.type == CJSON_NUMBER);
-  return value.u.num;
+  cjson_context c;
+  cjson_allocator allocator;  //创建时的全局分配器
+  unsigned char *levels;      //每一层容器的 CJSON_WRITER_* 标志
+  size_t depth, level_capacity;
+  int after_key;    //对象中已经写了key，下一个必须是值
+  size_t roots;     //根层已经写出的值的个数
+};
+
+CJSON_STATUS cjson_stringify_to_sink(const cjson_value *v, cjson_sink_fn sink, void *ud)
+{
+  cjson_context c = {0};
+  assert(v != NULL && sink != NULL);
+
+  c.allocator = &cjson_global_allocator;
+  c.sink = sink;
+  c.sink_ud = ud;
+  c.size = CJSON_WRITER_BUFFER_SIZE;
+  c.stack = (char *)CJSON_MALLOC(c.allocator, c.size);
+  cjson_stringify_value(&c, v);
+  cjson_sink_flush(&c);
+  CJSON_FREE(c.allocator, c.stack);
+  return c.sink_status;
 }
 
-void cjson_set_number(cjson_value *value, double num)
+cjson_writer *cjson_writer_create(cjson_sink_fn sink, void *ud, size_t buffer_size)
 {
-  assert(value != NULL);
-  cjson_value_free(value);
-  value->type = CJSON_NUMBER;
-  value->u.num = num;
+  cjson_writer *w = (cjson_writer *)CJSON_MALLOC(&cjson_global_allocator, sizeof(cjson_writer));
+  assert(sink != NULL);
+
+  memset(w, 0, sizeof(cjson_writer));
+  w->allocator = cjson_global_allocator;
+  w->c.allocator = &w->allocator;
+  w->c.sink = sink;
+  w->c.sink_ud = ud;
+  w->c.size = buffer_size >= 64 ? buffer_size : (buffer_size > 0 ? 64 : CJSON_WRITER_BUFFER_SIZE);  //至少要放得下一个数字或一个转义字符
+  w->c.stack = (char *)CJSON_MALLOC(&w->allocator, w->c.size);
+  return w;
 }
 
-size_t cjson_get_string_length(cjson_value value)
+void cjson_writer_destroy(cjson_writer *writer)
 {
-  assert(value.type == CJSON_STRING);
-  return value.u.str.l;
+  if(writer == NULL)
+    return;
+  CJSON_FREE(&writer->allocator, writer->c.stack);
+  if(writer->levels)
+    CJSON_FREE(&writer->allocator, writer->levels);
+  CJSON_FREE(&writer->allocator, writer);
 }
 
-char* cjson_get_string(cjson_value value)
+CJSON_STATUS cjson_writer_flush(cjson_writer *writer)
 {
-  assert(value.type == CJSON_STRING);
-  return value.u.str.buf;
+  assert(writer != NULL);
+  cjson_sink_flush(&writer->c);
+  return writer->c.sink_status;
 }
 
-void cjson_set_string(cjson_value *value, const char *buf, size_t len)
+static void cjson_writer_prefix(cjson_writer *w, int key)   //写出元素前的分隔符
 {
-  assert(value != NULL);
-  assert(buf != NULL || len == 0);
-  cjson_value_free(value);
-  value->type = CJSON_STRING;
-  value->u.str.buf = malloc(len + 1);
+  unsigned char *level;
 
-  memcpy(value->u.str.buf, buf, len);
-  value->u.str.buf[len] = '\0';
-  value->u.str.l = len;
-}
+  if(w->depth == 0)
+  {
+    assert(!key);
+    if(w->roots++ > 0)
+      PUSH_CHAR_TO_STACK(&w->c, '\n');
+    return;
+  }
 
-size_t cjson_get_array_size(cjson_value value)
-{
-  assert(value.type == CJSON_ARRAY);
-  return value.u.arr.size;
+  level = w->levels + w->depth - 1;
+  if((*level & CJSON_WRITER_OBJECT) && !key)  //对象中的值紧跟在key之后
+  {
+    assert(w->after_key);
+    w->after_key = 0;
+    return;
+  }
+  assert(key == ((*level & CJSON_WRITER_OBJECT) != 0));   //对象中先写key，数组中不能写key
+  if(*level & CJSON_WRITER_NONEMPTY)
+    PUSH_CHAR_TO_STACK(&w->c, ',');
+  *level |= CJSON_WRITER_NONEMPTY;
 }
 
-size_t cjson_get_array_capacity(cjson_value value)
+static CJSON_STATUS cjson_writer_start(cjson_writer *w, unsigned char type, char ch)
 {
-  assert(value.type == CJSON_ARRAY);
-  return value.u.arr.capacity;
+  cjson_writer_prefix(w, 0);
+  if(w->depth == w->level_capacity)
+  {
+    w->level_capacity = w->level_capacity == 0 ? 16 : w->level_capacity << 1;
+    w->levels = (unsigned char *)CJSON_REALLOC(&w->allocator, w->levels, w->level_capacity);
+  }
+  w->levels[w->depth++] = type;
+  PUSH_CHAR_TO_STACK(&w->c, ch);
+  return w->c.sink_status;
 }
 
-cjson_value *cjson_get_array_element(cjson_value value, size_t index)
+static CJSON_STATUS cjson_writer_end(cjson_writer *w, unsigned char type, char ch)
 {
-  assert(value.type == CJSON_ARRAY);
-  assert(value.u.arr.size > index);  //index为索引号，从0开始，size为元素数，从1开始
-  return value.u.arr.elements + index;
+  assert(w->depth > 0 && (w->levels[w->depth - 1] & CJSON_WRITER_OBJECT) == type);
+  assert(!w->after_key);
+  w->depth--;
+  PUSH_CHAR_TO_STACK(&w->c, ch);
+  return w->c.sink_status;
 }
 
-void cjson_init_array(cjson_value *value, size_t cap)
+CJSON_STATUS cjson_writer_start_object(cjson_writer *writer)
 {
-  assert(value != NULL);
-
-  cjson_value_free(value);
-  value->type = CJSON_ARRAY;
-  value->u.arr.size = 0;
-  value->u.arr.capacity = cap;
-  value->u.arr.elements = cap > 0 ? (cjson_value *)malloc(sizeof(cjson_value) * cap) : NULL;
+  assert(writer != NULL);
+  return cjson_writer_start(writer, CJSON_WRITER_OBJECT, '{');
 }
 
-void cjson_resize_array(cjson_value *value)
+CJSON_STATUS cjson_writer_end_object(cjson_writer *writer)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_ARRAY);
-  if(value->u.arr.capacity <= value->u.arr.size)
-  {
-    // value->u.arr.capacity = value->u.arr.capacity == 0? 1 : value->u.arr.capacity + value->u.arr.capacity >> 1; //这里不能把数组容量扩大到1.5倍，cap为1，这个最终结果还是1
-    value->u.arr.capacity = value->u.arr.capacity == 0? 1 : value->u.arr.capacity << 1; //这里不能把数组容量扩大到1.5倍，cap为1，这个最终结果还是1
-    value->u.arr.elements = (cjson_value *)realloc(value->u.arr.elements, value->u.arr.capacity * sizeof(cjson_value));
-  }
+  assert(writer != NULL);
+  return cjson_writer_end(writer, CJSON_WRITER_OBJECT, '}');
 }
-cjson_value *cjson_pushback_array_element(cjson_value *value)
-{
-  assert(value != NULL);
-  assert(value->type == CJSON_ARRAY);
 
-  if(value->u.arr.size >= value->u.arr.capacity)
-    cjson_resize_array(value);
-  
-  cjson_value_init(value->u.arr.elements + value->u.arr.size);
-  return value->u.arr.elements + value->u.arr.size++;
+CJSON_STATUS cjson_writer_start_array(cjson_writer *writer)
+{
+  assert(writer != NULL);
+  return cjson_writer_start(writer, 0, '[');
 }
 
-cjson_value *cjson_popback_array_element(cjson_value *value)
+CJSON_STATUS cjson_writer_end_array(cjson_writer *writer)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_ARRAY);
-  return value->u.arr.elements + --value->u.arr.size;
+  assert(writer != NULL);
+  return cjson_writer_end(writer, 0, ']');
 }
 
-cjson_value *cjson_insert_array_element(cjson_value *value, size_t index)
+CJSON_STATUS cjson_writer_key(cjson_writer *writer, const char *key, size_t len)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_ARRAY);
-
-  if(value->u.arr.size >= value->u.arr.capacity)
-    cjson_resize_array(value);
-
-  memmove(value->u.arr.elements + index + 1, value->u.arr.elements + index, sizeof(cjson_value) * (value->u.arr.size - index));
-  value->u.arr.size++;
-
-  return value->u.arr.elements + index;
+  assert(writer != NULL);
+  assert(key != NULL);
+  cjson_writer_prefix(writer, 1);
+  cjson_stringify_string(&writer->c, key, len);
+  PUSH_CHAR_TO_STACK(&writer->c, ':');
+  writer->after_key = 1;
+  return writer->c.sink_status;
 }
 
-void cjson_erase_array_element(cjson_value *value, size_t index, size_t count)
+CJSON_STATUS cjson_writer_null(cjson_writer *writer)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_ARRAY);
-  assert(index + count <= value->u.arr.size);   //一共9个元素，index从8开始删除1个，即删除最后一共元素，所以这里需要等号
-
-  for(size_t i = 0; i < count; i++)
-  {
-    cjson_value_free(value->u.arr.elements + index + i);
-  }
-  value->u.arr.size -= count;
-  memmove(value->u.arr.elements + index, value->u.arr.elements + index + count, sizeof(cjson_value) * (value->u.arr.size - index));
+  assert(writer != NULL);
+  cjson_writer_prefix(writer, 0);
+  memcpy(cjson_push(&writer->c, 4), "null", 4);
+  return writer->c.sink_status;
 }
 
-void cjson_clear_array_element(cjson_value *value)
+CJSON_STATUS cjson_writer_boolean(cjson_writer *writer, int b)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_ARRAY);
-  cjson_erase_array_element(value, 0, value->u.arr.size);
+  assert(writer != NULL);
+  cjson_writer_prefix(writer, 0);
+  if(b)
+    memcpy(cjson_push(&writer->c, 4), "true", 4);
+  else
+    memcpy(cjson_push(&writer->c, 5), "false", 5);
+  return writer->c.sink_status;
 }
 
-void cjson_shrink_array(cjson_value *value)
+CJSON_STATUS cjson_writer_number(cjson_writer *writer, double num)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_ARRAY);
-
-  value->u.arr.capacity = value->u.arr.size;
-  value->u.arr.elements = realloc(value->u.arr.elements, value->u.arr.capacity * sizeof(cjson_value));
+  assert(writer != NULL);
+  cjson_writer_prefix(writer, 0);
+  writer->c.top -= 32 - cjson_format_double(cjson_push(&writer->c, 32), num);
+  return writer->c.sink_status;
 }
 
-size_t cjson_get_object_size(cjson_value value)
+CJSON_STATUS cjson_writer_int64(cjson_writer *writer, int64_t num)
 {
-  assert(value.type == CJSON_OBJECT);
-  return value.u.obj.size;
+  cjson_value v;
+  assert(writer != NULL);
+
+  v.flags = CJSON_FLAG_INT64;
+  v.u.i64 = num;
+  cjson_writer_prefix(writer, 0);
+  writer->c.top -= 32 - cjson_format_number(cjson_push(&writer->c, 32), &v);
+  return writer->c.sink_status;
 }
 
-size_t cjson_get_object_capacity(cjson_value value)
+CJSON_STATUS cjson_writer_uint64(cjson_writer *writer, uint64_t num)
 {
-  assert(value.type == CJSON_OBJECT);
-  return value.u.obj.capacity;
+  assert(writer != NULL);
+  cjson_writer_prefix(writer, 0);
+  writer->c.top -= 32 - cjson_format_uint64(cjson_push(&writer->c, 32), num);
+  return writer->c.sink_status;
 }
 
-const char *cjson_get_object_key(cjson_value value, size_t index)
+CJSON_STATUS cjson_writer_string(cjson_writer *writer, const char *str, size_t len)
 {
-  assert(value.type == CJSON_OBJECT);
-  assert(value.u.obj.size > index);  //index为索引号，从0开始，size为元素数，从1开始
-  return (value.u.obj.members + index)->key;
+  assert(writer != NULL);
+  assert(str != NULL);
+  cjson_writer_prefix(writer, 0);
+  cjson_stringify_string(&writer->c, str, len);
+  return writer->c.sink_status;
 }
 
-size_t cjson_get_object_key_length(cjson_value value, size_t index)
+CJSON_STATUS cjson_writer_value(cjson_writer *writer, const cjson_value *v)
 {
-  assert(value.type == CJSON_OBJECT);
-  assert(value.u.obj.size > index);  //index为索引号，从0开始，size为元素数，从1开始
-  return (value.u.obj.members + index)->key_len;
+  assert(writer != NULL && v != NULL);
+  cjson_writer_prefix(writer, 0);
+  cjson_stringify_value(&writer->c, v);
+  return writer->c.sink_status;
 }
 
-cjson_value *cjson_get_object_value(cjson_value value, size_t index)
+#ifdef CJSON_NDJSON
+//---------------------------NDJSON---------------------------//
+
+typedef struct   //有序回调时一个块的解析结果，块i放在slots[i % slot_count]中
 {
-  assert(value.type == CJSON_OBJECT);
-  assert(value.u.obj.size > index);  //index为索引号，从0开始，size为元素数，从1开始
-  return &((value.u.obj.members + index)->value);
-}
+  size_t chunk;         //允许放入的块，回调完成后加上slot_count
+  int ready;            //块解析完成，等待回调
+  cjson_arena *arena;   //块中所有记录的值，回调完成后重置
+  cjson_ndjson_record *records;
+  size_t count, capacity;
+}cjson_ndjson_slot;
 
-void cjson_init_object(cjson_value *value, size_t cap)
+typedef struct
 {
-  assert(value != NULL);
+  const char *data;
+  const char *next, *end;   //还没有分配出去的输入
+  size_t chunk_size;
+  size_t chunks;            //已经分配出去的块数
+  int ordered;
+  atomic_int stop;          //回调返回0之后所有线程尽快停止
+  cjson_ndjson_callback callback;
+  void *user_data;
+  pthread_mutex_t lock;     //保护next、chunks和slots的状态
+  pthread_cond_t ready;     //有块解析完成
+  pthread_cond_t free;      //有slot回调完成
+  cjson_ndjson_slot *slots;
+  size_t slot_count;
+}cjson_ndjson_reader;
 
-  cjson_value_free(value);
-  value->type = CJSON_OBJECT;
-  value->u.obj.size = 0;
-  value->u.obj.capacity = cap;
-  value->u.obj.members = cap > 0 ? (cjson_member *)malloc(sizeof(cjson_member) * cap) : NULL;
+typedef struct
+{
+  cjson_ndjson_reader *r;
+  cjson_parser *parser;   //每个线程一个，栈在多次解析之间保留
+  cjson_arena *arena;     //无序回调时每条记录的值，回调之后立即重置
+  pthread_t thread;
+  int started;
+}cjson_ndjson_worker;
+
+static size_t cjson_ndjson_cpu_count(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (size_t)n : 1;
 }
 
-void cjson_resize_object(cjson_value *value)
+static int cjson_ndjson_next_chunk(cjson_ndjson_reader *r, const char **begin, const char **end, size_t *chunk)  //持有锁时调用，从剩下的输入中切出一块，块总是在换行符之后结束
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_OBJECT);
+  const char *p = r->end;
 
-  if(value->u.obj.capacity <= value->u.obj.size)
+  if(r->next == r->end || atomic_load_explicit(&r->stop, memory_order_relaxed))
+    return 0;
+  if((size_t)(r->end - r->next) > r->chunk_size)
   {
-    value->u.obj.capacity = value->u.obj.capacity == 0? 1 : value->u.obj.capacity << 1; //这里不能把容量扩大到1.5倍，cap为1，这个最终结果还是1
-    value->u.obj.members = (cjson_member *)realloc(value->u.obj.members, value->u.obj.capacity * sizeof(cjson_member));
-  }  
+    p = (const char *)memchr(r->next + r->chunk_size - 1, '\n', r->end - r->next - r->chunk_size + 1);
+    p = p != NULL ? p + 1 : r->end;
+  }
+  *begin = r->next;
+  *end = r->next = p;
+  *chunk = r->chunks++;
+  return 1;
 }
 
-cjson_value *cjson_set_object_value(cjson_value *value, const char* key, size_t klen)
+static cjson_ndjson_record *cjson_ndjson_slot_push(cjson_ndjson_slot *slot)
 {
-  assert(key != NULL && klen > 0);
-  assert(value != NULL);
-  assert(value->type == CJSON_OBJECT);
-
-  if(value->u.obj.size >= value->u.obj.capacity)
-    cjson_resize_object(value);
-
-  (value->u.obj.members + value->u.obj.size)->key_len = klen;
-  memcpy((value->u.obj.members + value->u.obj.size)->key = (char *)malloc(klen + 1), key, klen);
-  (value->u.obj.members + value->u.obj.size)->key[klen] = '\0';
-  
-  cjson_value_init(&(value->u.obj.members + value->u.obj.size)->value);
-  value->u.obj.size++;
-  return &(value->u.obj.members + value->u.obj.size - 1)->value;
+  if(slot->count == slot->capacity)
+  {
+    slot->capacity = slot->capacity > 0 ? slot->capacity + (slot->capacity >> 1) : 256;
+    slot->records = (cjson_ndjson_record *)CJSON_REALLOC(&cjson_global_allocator, slot->records, slot->capacity * sizeof(cjson_ndjson_record));
+  }
+  return &slot->records[slot->count++];
 }
 
-size_t cjson_find_object_index(cjson_value value, const char* key, size_t klen)
+static void cjson_ndjson_parse_chunk(cjson_ndjson_worker *w, const char *p, const char *end, cjson_ndjson_slot *slot)  //slot为NULL时每条记录解析完立即回调
 {
-  assert(key != NULL && klen > 0);
-  assert(value.type == CJSON_OBJECT);
+  cjson_ndjson_reader *r = w->r;
+  cjson_ndjson_record one, *record = &one;
+  const char *line, *eol, *q;
 
-  for(size_t i = 0; i < value.u.obj.size; i++)
+  cjson_parser_set_arena(w->parser, slot != NULL ? slot->arena : w->arena);
+  while(p < end && !atomic_load_explicit(&r->stop, memory_order_relaxed))
   {
-    if(value.u.obj.members[i].key_len == klen && !memcmp(value.u.obj.members[i].key, key, klen))
-      return i;
+    line = p;
+    eol = (const char *)memchr(p, '\n', end - p);
+    if(eol == NULL)
+      eol = p = end;
+    else
+      p = eol + 1;
+    if(eol > line && eol[-1] == '\r')
+      eol--;
+
+    for(q = line; q < eol && IS_SPACE(*q); q++);
+    if(q == eol)  //跳过空行
+      continue;
+
+    if(slot != NULL)
+      record = cjson_ndjson_slot_push(slot);
+    record->offset = line - r->data;
+    record->length = eol - line;
+    record->status = cjson_parser_parse(w->parser, &record->value, line, eol - line);
+    if(slot == NULL)
+    {
+      if(!r->callback(r->user_data, record))
+        atomic_store(&r->stop, 1);
+      cjson_arena_reset(w->arena);
+    }
   }
-  return CJSON_KEY_NOT_EXIST;
 }
 
-cjson_value *cjson_find_object_value(cjson_value value, const char* key, size_t klen)
+static void *cjson_ndjson_thread(void *arg)  //不断领取下一块解析，直到输入分配完
 {
-  size_t i = cjson_find_object_index(value, key, klen);
-  return i == CJSON_KEY_NOT_EXIST ? NULL : cjson_get_object_value(value, i);
+  cjson_ndjson_worker *w = (cjson_ndjson_worker *)arg;
+  cjson_ndjson_reader *r = w->r;
+  cjson_ndjson_slot *slot = NULL;
+  const char *begin, *end;
+  size_t chunk;
+
+  pthread_mutex_lock(&r->lock);
+  while(cjson_ndjson_next_chunk(r, &begin, &end, &chunk))
+  {
+    if(r->ordered)
+    {
+      slot = &r->slots[chunk % r->slot_count];
+      while(slot->chunk != chunk && !atomic_load(&r->stop))   //等待前面的块回调完成，解析结果最多领先回调slot_count块
+        pthread_cond_wait(&r->free, &r->lock);
+      if(slot->chunk != chunk)
+        break;
+    }
+    pthread_mutex_unlock(&r->lock);
+
+    cjson_ndjson_parse_chunk(w, begin, end, slot);
+
+    pthread_mutex_lock(&r->lock);
+    if(slot != NULL)
+    {
+      slot->ready = 1;
+      pthread_cond_signal(&r->ready);
+    }
+  }
+  pthread_mutex_unlock(&r->lock);
+  return NULL;
 }
 
-void cjson_remove_object_value(cjson_value *value, size_t index)
+static void cjson_ndjson_deliver(cjson_ndjson_reader *r)   //有序回调：在调用线程中按块的顺序回调
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_OBJECT);
-  assert(index < value->u.obj.size);
+  cjson_ndjson_slot *slot;
+  size_t chunk = 0, i;
 
-  cjson_value_free(&value->u.obj.members[index].value); 
-  free(value->u.obj.members[index].key);
+  pthread_mutex_lock(&r->lock);
+  while(!atomic_load(&r->stop))
+  {
+    slot = &r->slots[chunk % r->slot_count];
+    while(!(slot->chunk == chunk && slot->ready) && !(chunk == r->chunks && r->next == r->end))
+      pthread_cond_wait(&r->ready, &r->lock);
+    if(slot->chunk != chunk || !slot->ready)  //所有块都已经回调
+      break;
+    pthread_mutex_unlock(&r->lock);
 
-  value->u.obj.size--;
-  memmove(value->u.obj.members + index, value->u.obj.members + index + 1, sizeof(cjson_member) * (value->u.obj.size - index));
+    for(i = 0; i < slot->count; i++)
+    {
+      if(!r->callback(r->user_data, &slot->records[i]))
+      {
+        atomic_store(&r->stop, 1);
+        break;
+      }
+    }
+    slot->count = 0;
+    cjson_arena_reset(slot->arena);
+
+    pthread_mutex_lock(&r->lock);
+    slot->ready = 0;
+    slot->chunk = chunk + r->slot_count;
+    chunk++;
+    pthread_cond_broadcast(&r->free);   //中止时也唤醒等待slot的线程，让它们退出
+  }
+  pthread_mutex_unlock(&r->lock);
 }
 
-void cjson_clear_object(cjson_value *value)
+CJSON_STATUS cjson_ndjson_parse(const char *data, size_t len, const cjson_ndjson_options *options, cjson_ndjson_callback callback, void *user_data)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_OBJECT);
+  cjson_ndjson_reader r;
+  cjson_ndjson_worker *workers;
+  size_t threads, started = 0, i;
+
+  assert(data != NULL || len == 0);
+  assert(callback != NULL);
+
+  threads = options != NULL && options->threads > 0 ? options->threads : cjson_ndjson_cpu_count();
+  memset(&r, 0, sizeof(cjson_ndjson_reader));
+  r.data = r.next = data;
+  r.end = data + len;
+  r.chunk_size = options != NULL && options->chunk_size > 0 ? options->chunk_size : CJSON_NDJSON_CHUNK_SIZE;
+  r.ordered = options != NULL && options->ordered && threads > 1;   //只有一个线程时直接解析一条回调一条，本来就是有序的
+  atomic_init(&r.stop, 0);
+  r.callback = callback;
+  r.user_data = user_data;
+  pthread_mutex_init(&r.lock, NULL);
+  pthread_cond_init(&r.ready, NULL);
+  pthread_cond_init(&r.free, NULL);
+
+  workers = (cjson_ndjson_worker *)CJSON_MALLOC(&cjson_global_allocator, threads * sizeof(cjson_ndjson_worker));
+  for(i = 0; i < threads; i++)
+  {
+    workers[i].r = &r;
+    workers[i].parser = cjson_parser_create(0);
+    workers[i].arena = cjson_arena_create(0);
+    workers[i].started = 0;
+  }
+  if(r.ordered)
+  {
+    r.slot_count = threads * 2;
+    r.slots = (cjson_ndjson_slot *)CJSON_MALLOC(&cjson_global_allocator, r.slot_count * sizeof(cjson_ndjson_slot));
+    memset(r.slots, 0, r.slot_count * sizeof(cjson_ndjson_slot));
+    for(i = 0; i < r.slot_count; i++)
+    {
+      r.slots[i].chunk = i;
+      r.slots[i].arena = cjson_arena_create(r.chunk_size * 4);
+    }
+  }
 
-  for(size_t i = 0; i < value->u.obj.size; i++)
+  //有序时调用线程负责回调，所有工作线程都另外创建；无序时调用线程也参与解析
+  for(i = r.ordered ? 0 : 1; i < threads; i++)
   {
-    cjson_value_free(&value->u.obj.members[i].value); 
-    free(value->u.obj.members[i].key);
+    workers[i].started = pthread_create(&workers[i].thread, NULL, cjson_ndjson_thread, &workers[i]) == 0;
+    started += workers[i].started;
   }
-  value->u.arr.size = 0;
+  if(r.ordered && started == 0)   //一个线程也没有创建成功，在调用线程中按顺序解析
+    r.ordered = 0;
+  if(r.ordered)
+    cjson_ndjson_deliver(&r);
+  else
+    cjson_ndjson_thread(&workers[0]);
+
+  for(i = 0; i < threads; i++)
+  {
+    if(workers[i].started)
+      pthread_join(workers[i].thread, NULL);
+    cjson_parser_destroy(workers[i].parser);
+    cjson_arena_destroy(workers[i].arena);
+  }
+  for(i = 0; i < r.slot_count; i++)
+  {
+    cjson_arena_destroy(r.slots[i].arena);
+    if(r.slots[i].records)
+      CJSON_FREE(&cjson_global_allocator, r.slots[i].records);
+  }
+  if(r.slots)
+    CJSON_FREE(&cjson_global_allocator, r.slots);
+  CJSON_FREE(&cjson_global_allocator, workers);
+  pthread_mutex_destroy(&r.lock);
+  pthread_cond_destroy(&r.ready);
+  pthread_cond_destroy(&r.free);
+  return atomic_load(&r.stop) ? CJSON_ERR_SAX_ABORT : CJSON_OK;
 }
 
-void cjson_shrink_object(cjson_value *value)
+CJSON_STATUS cjson_ndjson_parse_file(const char *path, const cjson_ndjson_options *options, cjson_ndjson_callback callback, void *user_data)
 {
-  assert(value != NULL);
-  assert(value->type == CJSON_OBJECT);
-  // assert(value->u.obj.capacity > value->u.obj.size);
+  struct stat st;
+  void *data;
+  CJSON_STATUS ret;
+  int fd;
 
-  value->u.obj.capacity = value->u.obj.size;
-  value->u.obj.members = realloc(value->u.obj.members, sizeof(cjson_member) * value->u.obj.size);
-}
\ No newline at end of file
+  assert(path != NULL);
+  fd = open(path, O_RDONLY);
+  if(fd < 0)
+    return CJSON_ERR_IO;
+  if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (uint64_t)st.st_size > SIZE_MAX)
+  {
+    close(fd);
+    return CJSON_ERR_IO;
+  }
+  if(st.st_size == 0)   //长度为0的文件不能映射
+  {
+    close(fd);
+    return cjson_ndjson_parse("", 0, options, callback, user_data);
+  }
+
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  //映射之后不再需要文件描述符
+  if(data == MAP_FAILED)
+    return CJSON_ERR_IO;
+  madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+  ret = cjson_ndjson_parse((const char *)data, (size_t)st.st_size, options, callback, user_data);
+  munmap(data, (size_t)st.st_size);
+  return ret;
+}
+#endif
@@ -21,11 +21,58 @@ do{\
 #define TEST_DOUBLE(expect, actuall) TEST_BASE((expect) == (actuall), expect, actuall, "%.17g")
 #define TEST_STRING(expect, actuall, length)\
   TEST_BASE((sizeof(expect) == (length + 1)) && !memcmp(expect, actuall, (length + 1)), expect, actuall, "%s")
+#define TEST_INT64(expect, actuall) TEST_BASE((expect) == (actuall), (long long)(expect), (long long)(actuall), "%lld")
+#define TEST_UINT64(expect, actuall) TEST_BASE((expect) == (actuall), (unsigned long long)(expect), (unsigned long long)(actuall), "%llu")
 #define TEST_SIZE_T(expect, actuall) TEST_BASE((expect) == (actuall), (size_t)expect, (size_t)actuall, "%zu")
 #define TEST_TRUE(actuall) TEST_BASE((actuall) != 0, "true", "false", "%s")
 #define TEST_FALSE(actuall) TEST_BASE((actuall) == 0, "false", "true", "%s")
 
 
+/* 计数分配器：统计各种分配的次数，检查内存泄漏 */
+typedef struct {
+  size_t malloc_count, realloc_count, free_count;
+  size_t live, live_bytes;  /* 尚未释放的块数和字节数 */
+} test_alloc_stats;
+
+static test_alloc_stats global_alloc_stats;
+
+static void *test_malloc(void *ud, size_t size) {
+  test_alloc_stats *st = (test_alloc_stats *)ud;
+  size_t *p = (size_t *)malloc(size + 2 * sizeof(size_t));   /* 块头记录大小，保持16字节对齐 */
+  if (p == NULL)
+    return NULL;
+  p[0] = size;
+  st->malloc_count++;
+  st->live++;
+  st->live_bytes += size;
+  return p + 2;
+}
+
+static void *test_realloc(void *ud, void *ptr, size_t size) {
+  test_alloc_stats *st = (test_alloc_stats *)ud;
+  size_t *p;
+  if (ptr == NULL)
+    return test_malloc(ud, size);
+  p = (size_t *)ptr - 2;
+  st->live_bytes -= p[0];
+  p = (size_t *)realloc(p, size + 2 * sizeof(size_t));
+  p[0] = size;
+  st->realloc_count++;
+  st->live_bytes += size;
+  return p + 2;
+}
+
+static void test_free(void *ud, void *ptr) {
+  test_alloc_stats *st = (test_alloc_stats *)ud;
+  size_t *p = (size_t *)ptr - 2;
+  st->free_count++;
+  st->live--;
+  st->live_bytes -= p[0];
+  free(p);
+}
+
+static const cjson_allocator test_allocator = { test_malloc, test_realloc, test_free, &global_alloc_stats };
+
 #define TEST_JSON_LITERAL(json_type, json) \
 do{\
   cjson_value v = {0};\
@@ -88,6 +135,37 @@ static void test_prase_number()
   TEST_JSON_NUMBER(-2.2250738585072014e-308, "-2.2250738585072014e-308");
   TEST_JSON_NUMBER( 1.7976931348623157e+308, "1.7976931348623157e+308");  /* Max double */
   TEST_JSON_NUMBER(-1.7976931348623157e+308, "-1.7976931348623157e+308");
+
+  /* 超过19位有效数字、正好在两个double中间等需要精确转换的情况 */
+  TEST_JSON_NUMBER(9007199254740992.0, "9007199254740993");   /* 2^53 + 1，向偶数舍入 */
+  TEST_JSON_NUMBER(9007199254740994.0, "9007199254740993.0000000000000000001");
+  TEST_JSON_NUMBER(1e23, "1e23");
+  TEST_JSON_NUMBER(1e23, "99999999999999999999999.99999");
+  TEST_JSON_NUMBER(1.2345678901234568e29, "123456789012345678901234567890");
+  TEST_JSON_NUMBER(1.234e-36, "0.000000000000000000000000000000000001234");
+  TEST_JSON_NUMBER(2.2250738585072011e-308, "2.2250738585072011e-308");
+  TEST_JSON_NUMBER(0.0, "2.4703282292062327e-324");   /* 最小非规格化数的一半，舍入到0 */
+  TEST_JSON_NUMBER(4.9406564584124654e-324, "2.4703282292062328e-324");
+  TEST_JSON_NUMBER(1.0000000000000002, "1.00000000000000011102230246251565404236316680908203126");
+  TEST_JSON_NUMBER(1.0, "1.00000000000000011102230246251565404236316680908203125");
+  TEST_JSON_NUMBER(1.7976931348623157e+308, "1.7976931348623158e+308");
+  TEST_JSON_NUMBER(0.0, "0e100000");
+
+  /* 有效数字超过800位，超出的整数部分数字虽然丢弃，仍然要计入小数点的位置 */
+  {
+    char json[1024];
+    memset(json, '0', sizeof(json));
+    json[0] = '1';
+    strcpy(json + 901, "e-850");    /* 1后面900个0 */
+    TEST_JSON_NUMBER(1e50, json);
+    strcpy(json + 851, ".5e-800");  /* 1后面850个0 */
+    TEST_JSON_NUMBER(1e50, json);
+    strcpy(json + 851, "1e-851");   /* 丢弃的非零数字 */
+    TEST_JSON_NUMBER(1.0, json);
+    memcpy(json, "9007199254740993", 16);
+    strcpy(json + 850, "1e-835");   /* 2^53 + 1 + 很小的尾数，丢弃的1决定向上舍入 */
+    TEST_JSON_NUMBER(9007199254740994.0, json);
+  }
 }
 
 #define TEST_JSON_STRING(except, json) \
@@ -265,6 +343,59 @@ static void test_parse_root_not_singular() {
 static void test_parse_number_too_big() {
   TEST_PARSE_ERROR(CJSON_ERR_NUMBER_TOO_BIG, "1e309");
   TEST_PARSE_ERROR(CJSON_ERR_NUMBER_TOO_BIG, "-1e309");
+  TEST_PARSE_ERROR(CJSON_ERR_NUMBER_TOO_BIG, "1.7976931348623159e+308");
+  TEST_PARSE_ERROR(CJSON_ERR_NUMBER_TOO_BIG, "1e99999999999999999999");
+}
+
+#define TEST_JSON_INT64(expect, json) \
+  do{\
+    cjson_value v;\
+    cjson_value_init(&v);\
+    TEST_INT(CJSON_OK, cjson_parse(&v, (json)));\
+    TEST_INT(CJSON_NUMBER, cjson_get_type(v));\
+    TEST_TRUE(cjson_is_integer(v));\
+    TEST_INT64(expect, cjson_get_int64(v));\
+    cjson_value_free(&v);\
+  }while(0)
+
+#define TEST_JSON_UINT64(expect, json) \
+  do{\
+    cjson_value v;\
+    cjson_value_init(&v);\
+    TEST_INT(CJSON_OK, cjson_parse(&v, (json)));\
+    TEST_TRUE(cjson_is_integer(v));\
+    TEST_UINT64(expect, cjson_get_uint64(v));\
+    cjson_value_free(&v);\
+  }while(0)
+
+#define TEST_JSON_NOT_INTEGER(expect, json) \
+  do{\
+    cjson_value v;\
+    cjson_value_init(&v);\
+    TEST_INT(CJSON_OK, cjson_parse(&v, (json)));\
+    TEST_FALSE(cjson_is_integer(v));\
+    TEST_DOUBLE(expect, cjson_get_number(v));\
+    cjson_value_free(&v);\
+  }while(0)
+
+static void test_parse_integer() {
+  TEST_JSON_INT64(0, "0");
+  TEST_JSON_INT64(1, "1");
+  TEST_JSON_INT64(-1, "-1");
+  TEST_JSON_INT64(9007199254740993LL, "9007199254740993"); /* 2^53 + 1, not representable as double */
+  TEST_JSON_INT64(-9007199254740993LL, "-9007199254740993");
+  TEST_JSON_INT64(INT64_MAX, "9223372036854775807");
+  TEST_JSON_INT64(INT64_MIN, "-9223372036854775808");
+  TEST_JSON_UINT64(9223372036854775808ULL, "9223372036854775808");
+  TEST_JSON_UINT64(12345678901234567890ULL, "12345678901234567890");
+  TEST_JSON_UINT64(UINT64_MAX, "18446744073709551615");
+
+  TEST_JSON_NOT_INTEGER(0.0, "-0");
+  TEST_JSON_NOT_INTEGER(1.0, "1.0");
+  TEST_JSON_NOT_INTEGER(100.0, "1e2");
+  TEST_JSON_NOT_INTEGER(-9223372036854775809.0, "-9223372036854775809");
+  TEST_JSON_NOT_INTEGER(18446744073709551616.0, "18446744073709551616");
+  TEST_JSON_NOT_INTEGER(1e20, "100000000000000000000");
 }
 
 static void test_parse_miss_quotation_mark() {
@@ -338,6 +469,314 @@ static void test_parse_miss_comma_or_curly_bracket() {
   TEST_PARSE_ERROR(CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET, "{\"a\":{}");
 }
 
+#define TEST_PARSE_N(error, json, len)\
+  do {\
+    cjson_value v;\
+    cjson_value_init(&v);\
+    TEST_INT(error, cjson_parse_n(&v, json, len));\
+    cjson_value_free(&v);\
+  } while(0)
+
+static void test_parse_n() {
+  cjson_value v;
+  const char buf[] = { '[', '1', ',', '\"', 'a', '\"', ']', 'x' };   /* 没有 '\0' 结尾 */
+
+  cjson_value_init(&v);
+  TEST_INT(CJSON_OK, cjson_parse_n(&v, buf, 7));
+  TEST_INT(CJSON_ARRAY, cjson_get_type(v));
+  TEST_SIZE_T(2, cjson_get_array_size(v));
+  TEST_DOUBLE(1.0, cjson_get_number(*cjson_get_array_element(v, 0)));
+  TEST_STRING("a", cjson_get_string(*cjson_get_array_element(v, 1)), cjson_get_string_length(*cjson_get_array_element(v, 1)));
+  cjson_value_free(&v);
+
+  /* 长度之外的字符不参与解析 */
+  cjson_value_init(&v);
+  TEST_INT(CJSON_OK, cjson_parse_n(&v, "1234", 2));
+  TEST_DOUBLE(12.0, cjson_get_number(v));
+  cjson_value_free(&v);
+
+  TEST_PARSE_N(CJSON_OK, "true ", 4);
+  TEST_PARSE_N(CJSON_ERR_MISS_VALUE, "null", 0);
+  TEST_PARSE_N(CJSON_ERR_LITERAL, "true", 3);
+  TEST_PARSE_N(CJSON_ERR_LITERAL, "1.5", 2);
+  TEST_PARSE_N(CJSON_ERR_LITERAL, "1e5", 2);
+  TEST_PARSE_N(CJSON_ERR_STRING_MISS_QUOTATION_MARK, "\"abc\"", 4);
+  TEST_PARSE_N(CJSON_ERR_STRING_MISS_QUOTATION_MARK, "\"\\n\"", 2);
+  TEST_PARSE_N(CJSON_ERR_UNICODE_HEX, "\"\\u0041\"", 5);
+  TEST_PARSE_N(CJSON_ERR_UNICODE_SURROGATE, "\"\\uD834\\uDD1E\"", 8);
+  TEST_PARSE_N(CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET, "[1]", 2);
+  TEST_PARSE_N(CJSON_ERR_OBJECT_NEED_COLON, "{\"a\":1}", 4);
+  TEST_PARSE_N(CJSON_ERR_ROOT_NOT_SINGULAR, "1\0", 2);              /* 长度范围内的 '\0' 不是结尾 */
+  TEST_PARSE_N(CJSON_ERR_STRING_INVALID_CAHR, "\"a\0b\"", 5);
+}
+
+static void test_parse_insitu() {
+  char json[] = "{\"key\":\"Hello\\nWorld\",\"\\u20AC\":[\"\\uD834\\uDD1E\",\"abc\"],\"k\":1}";
+  char bad[] = "[\"a\",{\"b\":\"c\",\"d\"}]";
+  test_alloc_stats before;
+  cjson_value v, *pv;
+  const char *s;
+
+  cjson_value_init(&v);
+  before = global_alloc_stats;
+  TEST_INT(CJSON_OK, cjson_parse_insitu(&v, json, sizeof(json) - 1));
+  TEST_SIZE_T(3, global_alloc_stats.malloc_count - before.malloc_count);   /* 只有临时栈、对象和数组的元素块 */
+  TEST_TRUE(v.flags & CJSON_FLAG_INSITU);
+
+  s = cjson_get_object_key(v, 0);
+  TEST_TRUE(s > json && s < json + sizeof(json));
+  TEST_STRING("key", s, cjson_get_object_key_length(v, 0));
+  pv = cjson_get_object_value(v, 0);
+  TEST_TRUE(cjson_get_string(*pv) > json && cjson_get_string(*pv) < json + sizeof(json));
+  TEST_STRING("Hello\nWorld", cjson_get_string(*pv), cjson_get_string_length(*pv));
+  TEST_STRING("\xE2\x82\xAC", cjson_get_object_key(v, 1), cjson_get_object_key_length(v, 1));
+  pv = cjson_get_object_value(v, 1);
+  TEST_STRING("\xF0\x9D\x84\x9E", cjson_get_string(*cjson_get_array_element(*pv, 0)), cjson_get_string_length(*cjson_get_array_element(*pv, 0)));
+  TEST_STRING("abc", cjson_get_string(*cjson_get_array_element(*pv, 1)), cjson_get_string_length(*cjson_get_array_element(*pv, 1)));
+
+  /* 修改原地解析的值 */
+  cjson_set_string(cjson_get_array_element(*pv, 1), "heap", 4);
+  cjson_remove_object_value(&v, 2);
+  cjson_set_number(cjson_set_object_value(&v, "new", 3), 1.0);
+  TEST_FALSE(v.flags & CJSON_FLAG_INSITU);
+  TEST_STRING("key", cjson_get_object_key(v, 0), cjson_get_object_key_length(v, 0));
+  TEST_TRUE(cjson_find_object_value(v, "new", 3) != NULL);
+  cjson_value_free(&v);
+
+  TEST_INT(CJSON_ERR_OBJECT_NEED_COLON, cjson_parse_insitu(&v, bad, sizeof(bad) - 1));
+  TEST_INT(CJSON_NULL, cjson_get_type(v));
+}
+
+static void test_parse_long_string() {
+  /* 特殊字符出现在长字符串的各个位置，覆盖按16/32字节成块扫描的边界 */
+  static const char *specials[] = { "\\\"", "\\n", "\\u00e9", "\x01" };
+  static const char *decoded[] = { "\"", "\n", "\xC3\xA9", NULL };
+  char json[128], expect[128];
+  size_t i, k, len;
+  cjson_value v;
+
+  for (k = 0; k < 4; k++) {
+    for (i = 0; i < 70; i++) {
+      size_t n = strlen(specials[k]);
+      memset(json, 'a', sizeof(json));
+      memset(expect, 'a', sizeof(expect));
+      json[0] = '\"';
+      memcpy(json + 1 + i, specials[k], n);
+      json[1 + i + n + 5] = '\"';
+      len = 1 + i + n + 6;
+
+      cjson_value_init(&v);
+      if (decoded[k] == NULL) {
+        TEST_INT(CJSON_ERR_STRING_INVALID_CAHR, cjson_parse_n(&v, json, len));
+        continue;
+      }
+      TEST_INT(CJSON_OK, cjson_parse_n(&v, json, len));
+      memcpy(expect + i, decoded[k], strlen(decoded[k]));
+      TEST_SIZE_T(i + strlen(decoded[k]) + 5, cjson_get_string_length(v));
+      TEST_TRUE(memcmp(expect, cjson_get_string(v), cjson_get_string_length(v)) == 0);
+      cjson_value_free(&v);
+
+      TEST_INT(CJSON_ERR_STRING_MISS_QUOTATION_MARK, cjson_parse_n(&v, json, len - 1));   /* 扫描不能越过长度 */
+
+      TEST_INT(CJSON_OK, cjson_parse_insitu(&v, json, len));
+      TEST_SIZE_T(i + strlen(decoded[k]) + 5, cjson_get_string_length(v));
+      TEST_TRUE(memcmp(expect, cjson_get_string(v), cjson_get_string_length(v)) == 0);
+      cjson_value_free(&v);
+    }
+  }
+}
+
+#define TEST_INDEXED(json, len)\
+  do {\
+    cjson_value v1, v2;\
+    CJSON_STATUS r1 = cjson_parse_n(&v1, json, len);\
+    TEST_INT(r1, cjson_parse_indexed(&v2, json, len));\
+    if (r1 == CJSON_OK) {\
+      TEST_TRUE(cjson_is_equal(&v1, &v2));\
+      cjson_value_free(&v1);\
+    }\
+    else\
+      TEST_INT(CJSON_NULL, cjson_get_type(v2));\
+    cjson_value_free(&v2);\
+  } while(0)
+
+static void test_parse_indexed() {
+  /* 两阶段解析的结果和错误码都和普通解析相同 */
+  static const char *cases[] = {
+    "", " ", "null", " true ", "false", "-1.5e10", "\"\"", "[]", "{}", " [ 1 , [ ] , { } , \"\" ] ",
+    "{\"a\":[1,{\"b\":null}],\"c\":\"x\\u00e9\\ud834\\udd1e\\n\"}", "{\n  \"a\": [\n    1,\n    2\n  ],\n  \"b\": \"[,]{:}\"\n}",
+    "[\"\\\\\", \"\\\"\", \"\\\\\\\"\"]", "\"a\\\"b,c\"",
+    "nul", "nullx", "[truex]", "[1x]", "\"a\"x", "[1 2]", "[1,]", "{\"a\" 1}", "{\"a\":1,}", "{1:2}", "[\"a\"\"b\"]",
+    "[0123]", "\"abc", "[\"a\\\"]", "[1,\\\"a\"]", "1 2", "[\x01]", "\"\x01\"", "{\"a\":\"b\" \"c\":1}",
+    "{\"\":\"\"}", "\"a\tb\"", "[\"ab\",\"c\\td\x1f\"]", "[\"a\\\\\\nb\\u0041\"]", "[\"a\\\"b\", \"c\"]", "[\"a\",\"b"
+  };
+  cjson_parser *parser = cjson_parser_create(0);
+  char json[256], insitu[256];
+  size_t i, k, len;
+  cjson_value v, v2;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    TEST_INDEXED(cases[i], strlen(cases[i]));
+
+  /* 转义、引号和值的开头出现在64字节块边界的各个位置 */
+  for (k = 0; k < 5; k++) {
+    for (i = 50; i < 140; i++) {
+      static const char *tails[] = { "\\\\\",1]", "\\\"\",1]", "\",\"\\\\\\\"\"]", "\" ,  -12, true  ]", "\"\n,\nnull]" };
+      memset(json, ' ', sizeof(json));
+      json[0] = '[';
+      json[i - 1] = '\"';
+      memset(json + i, 'a', 3);
+      len = i + 3;
+      strcpy(json + len, tails[k]);
+      len += strlen(tails[k]);
+      TEST_INDEXED(json, len);
+      TEST_INDEXED(json, len - 1);
+    }
+  }
+
+  /* parser可以切换到两阶段解析，也支持原地解析 */
+  cjson_parser_set_indexed(parser, 1);
+  strcpy(json, "{ \"k\" : [ \"v\\n\" , 1 ] }");
+  len = strlen(json);
+  TEST_INT(CJSON_OK, cjson_parse_n(&v2, json, len));
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, json, len));
+  TEST_TRUE(cjson_is_equal(&v, &v2));
+  cjson_value_free(&v);
+  memcpy(insitu, json, len);
+  TEST_INT(CJSON_OK, cjson_parser_parse_insitu(parser, &v, insitu, len));
+  TEST_TRUE(cjson_is_equal(&v, &v2));
+  cjson_value_free(&v);
+  cjson_value_free(&v2);
+  TEST_INT(CJSON_ERR_OBJECT_NEED_COLON, cjson_parser_parse(parser, &v, "{\"k\" 1}", 7));
+  cjson_parser_destroy(parser);
+}
+
+#ifdef CJSON_STATS
+static void test_parse_stats() {
+  const char *json = "{\"a\":[1,\"x\\n\\u00e9\",true,null,{}],\"b\":\"\"}";
+  cjson_parser *parser = cjson_parser_create(4096);
+  cjson_parse_stats st;
+  cjson_value v;
+
+  TEST_INT(CJSON_OK, cjson_parse_with_stats(&st, &v, json, strlen(json)));
+  TEST_SIZE_T(1, st.nodes[CJSON_NULL]);
+  TEST_SIZE_T(1, st.nodes[CJSON_TRUE]);
+  TEST_SIZE_T(0, st.nodes[CJSON_FALSE]);
+  TEST_SIZE_T(1, st.nodes[CJSON_NUMBER]);
+  TEST_SIZE_T(2, st.nodes[CJSON_STRING]);
+  TEST_SIZE_T(1, st.nodes[CJSON_ARRAY]);
+  TEST_SIZE_T(2, st.nodes[CJSON_OBJECT]);
+  TEST_SIZE_T(3, st.max_depth);
+  TEST_SIZE_T(6, st.string_bytes);  /* "a" "b" "x\n\xC3\xA9" "" */
+  TEST_SIZE_T(2, st.escapes);
+  TEST_SIZE_T(2 + 2 + 5 + 1 + 5 * sizeof(cjson_value) + 2 * sizeof(cjson_member), st.heap_bytes);
+  TEST_TRUE(st.stack_reallocs >= 1);
+  TEST_TRUE(st.stack_size >= 256);
+  cjson_value_free(&v);
+
+  /* parser的栈已经足够大，不再扩容；原地解析不为字符串申请内存 */
+  cjson_parser_set_stats(parser, &st);
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, "[[[]],\"s\"]", 10));
+  TEST_SIZE_T(0, st.stack_reallocs);
+  TEST_SIZE_T(4096, st.stack_size);
+  TEST_SIZE_T(3, st.max_depth);
+  TEST_SIZE_T(3, st.nodes[CJSON_ARRAY]);
+  TEST_SIZE_T(2 + 2 * sizeof(cjson_value) + sizeof(cjson_value), st.heap_bytes);
+  cjson_value_free(&v);
+  {
+    char buf[] = "[\"abc\",\"d\\te\"]";
+    TEST_INT(CJSON_OK, cjson_parser_parse_insitu(parser, &v, buf, strlen(buf)));
+    TEST_SIZE_T(2 * sizeof(cjson_value), st.heap_bytes);
+    TEST_SIZE_T(6, st.string_bytes);
+    TEST_SIZE_T(1, st.escapes);
+    cjson_value_free(&v);
+  }
+
+  /* 出错时统计到出错的位置 */
+  TEST_INT(CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET, cjson_parser_parse(parser, &v, "[1,[2,true}", 11));
+  TEST_SIZE_T(2, st.nodes[CJSON_NUMBER]);
+  TEST_SIZE_T(1, st.nodes[CJSON_TRUE]);
+  TEST_SIZE_T(0, st.nodes[CJSON_ARRAY]);
+  TEST_SIZE_T(2, st.max_depth);
+
+  cjson_parser_set_stats(parser, NULL);
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, "[[[[]]]]", 8));
+  TEST_SIZE_T(2, st.max_depth);   /* 不再写入 */
+  cjson_value_free(&v);
+  cjson_parser_destroy(parser);
+}
+#endif
+
+#define TEST_ERROR_LOCATION(error, json, expect_offset, expect_line, expect_column)\
+  do {\
+    cjson_value v;\
+    cjson_parse_error e;\
+    cjson_value_init(&v);\
+    v.type = CJSON_FALSE;\
+    TEST_INT(error, cjson_parse_ex(&v, json, strlen(json), &e));\
+    TEST_INT(error, e.status);\
+    TEST_SIZE_T(expect_offset, e.offset);\
+    TEST_SIZE_T(expect_line, e.line);\
+    TEST_SIZE_T(expect_column, e.column);\
+    TEST_INT(CJSON_NULL, cjson_get_type(v));\
+    cjson_value_free(&v);\
+  } while(0)
+
+static void test_parse_error_location() {
+  cjson_value v;
+  cjson_parse_error e;
+
+  TEST_ERROR_LOCATION(CJSON_ERR_LITERAL, "tru", 0, 1, 1);
+  TEST_ERROR_LOCATION(CJSON_ERR_MISS_VALUE, "  ", 2, 1, 3);
+  TEST_ERROR_LOCATION(CJSON_ERR_ROOT_NOT_SINGULAR, "null x", 5, 1, 6);
+  TEST_ERROR_LOCATION(CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET, "[1,\n 2\n 3]", 8, 3, 2);
+  TEST_ERROR_LOCATION(CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET, "[1,2", 4, 1, 5);
+  TEST_ERROR_LOCATION(CJSON_ERR_OBJECT_NEED_COLON, "{\"a\" 1}", 5, 1, 6);
+  TEST_ERROR_LOCATION(CJSON_ERR_OBJECT_NEED_KEY, "{\"k\":1,}", 7, 1, 8);
+  TEST_ERROR_LOCATION(CJSON_ERR_NUMBER_TOO_BIG, "[1e999]", 1, 1, 2);
+  TEST_ERROR_LOCATION(CJSON_ERR_STRING_MISS_QUOTATION_MARK, "\"abc", 4, 1, 5);
+  /* 字符串内的错误指向出错的字符或转义序列的反斜杠 */
+  TEST_ERROR_LOCATION(CJSON_ERR_STRING_INVALID_ESCAPE, "{\n  \"a\": 1,\n  \"b\": \"x\\qy\"\n}", 21, 3, 10);
+  TEST_ERROR_LOCATION(CJSON_ERR_STRING_INVALID_CAHR, "\"ab\x01\"", 3, 1, 4);
+  TEST_ERROR_LOCATION(CJSON_ERR_UNICODE_HEX, "\r\n\r\n  [\"\\u12\"]", 8, 3, 5);
+  TEST_ERROR_LOCATION(CJSON_ERR_UNICODE_HEX, "\"\\uD800\\u12\"", 7, 1, 8);
+  TEST_ERROR_LOCATION(CJSON_ERR_UNICODE_SURROGATE, "[\"\xC3\xA9\",\"\\uD800\"]", 7, 1, 8);
+  TEST_ERROR_LOCATION(CJSON_ERR_UNICODE_SURROGATE, "\"\\uDBFF\\uE000\"", 1, 1, 2);
+  /* "\n"、"\r\n"和单独的"\r"都算一次换行 */
+  TEST_ERROR_LOCATION(CJSON_ERR_ROOT_NOT_SINGULAR, "{\"a\":1}\n\r\n\r{", 11, 4, 1);
+
+  /* 片段：出错处前后各最多20字节，控制字符替换为空格 */
+  TEST_INT(CJSON_ERR_ROOT_NOT_SINGULAR, cjson_parse_ex(&v, "{\"a\":1}\n\r\n\r{", 12, &e));
+  TEST_STRING("{\"a\":1}    {", e.context, strlen(e.context));
+  TEST_SIZE_T(11, e.context_offset);
+  TEST_INT(CJSON_ERR_LITERAL, cjson_parse_ex(&v, "[\"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\",x,1,2,3,4,5,6,7,8,9,10,11,12]", 63, &e));
+  TEST_STRING("aaaaaaaaaaaaaaaaaa\",x,1,2,3,4,5,6,7,8,9,", e.context, strlen(e.context));
+  TEST_SIZE_T(20, e.context_offset);
+  TEST_TRUE(e.context[e.context_offset] == 'x');
+  /* 不截断多字节字符 */
+  TEST_INT(CJSON_ERR_LITERAL, cjson_parse_ex(&v, "[\"\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\",x]", 28, &e));
+  TEST_STRING("\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\",x]", e.context, strlen(e.context));
+  TEST_SIZE_T(20, e.context_offset);
+  TEST_INT(CJSON_ERR_LITERAL, cjson_parse_ex(&v, "[\"\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\", x]", 29, &e));
+  TEST_STRING("\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\", x]", e.context, strlen(e.context));
+  TEST_SIZE_T(19, e.context_offset);
+  TEST_INT(CJSON_ERR_STRING_INVALID_ESCAPE, cjson_parse_ex(&v, "[\"\\xa\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\"]", 31, &e));
+  TEST_STRING("[\"\\xa\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9\xC3\xA9", e.context, strlen(e.context));
+  TEST_SIZE_T(2, e.context_offset);
+
+  /* 成功时只设置status，error可以为NULL */
+  TEST_INT(CJSON_OK, cjson_parse_ex(&v, "[1, 2]", 6, &e));
+  TEST_INT(CJSON_OK, e.status);
+  TEST_SIZE_T(0, e.offset);
+  TEST_SIZE_T(0, e.line);
+  TEST_SIZE_T(0, strlen(e.context));
+  TEST_SIZE_T(2, cjson_get_array_size(v));
+  cjson_value_free(&v);
+  TEST_INT(CJSON_ERR_MISS_VALUE, cjson_parse_ex(&v, "[1,", 3, NULL));
+  TEST_INT(CJSON_OK, cjson_parse_ex(&v, "\"x\"", 3, NULL));
+  cjson_value_free(&v);
+}
+
 static void test_prase()
 {
   test_prase_literal();
@@ -350,6 +789,7 @@ static void test_prase()
   test_parse_invalid_value();
   test_parse_root_not_singular();
   test_parse_number_too_big();
+  test_parse_integer();
   test_parse_miss_quotation_mark();
   test_parse_invalid_string_escape();
   test_parse_invalid_string_char();
@@ -359,6 +799,14 @@ static void test_prase()
   test_parse_miss_key();
   test_parse_miss_colon();
   test_parse_miss_comma_or_curly_bracket();
+  test_parse_n();
+  test_parse_insitu();
+  test_parse_long_string();
+  test_parse_indexed();
+  test_parse_error_location();
+#ifdef CJSON_STATS
+  test_parse_stats();
+#endif
 }
 
 
@@ -372,7 +820,20 @@ static void test_prase()
     json2 = cjson_stringify(v, &length);\
     TEST_STRING(json, json2, length);\
     cjson_value_free(&v);\
-    free(json2);\
+    cjson_free(json2);\
+  } while(0)
+
+#define TEST_STRINGIFY(expect, json)\
+  do {\
+    cjson_value v;\
+    char* json2;\
+    size_t length;\
+    cjson_value_init(&v);\
+    TEST_INT(CJSON_OK, cjson_parse(&v, json));\
+    json2 = cjson_stringify(v, &length);\
+    TEST_STRING(expect, json2, length);\
+    cjson_value_free(&v);\
+    cjson_free(json2);\
   } while(0)
 
 static void test_stringify_number() {
@@ -388,14 +849,33 @@ static void test_stringify_number() {
   TEST_ROUNDTRIP("1.234e-20");
 
   TEST_ROUNDTRIP("1.0000000000000002"); /* the smallest number > 1 */
-  TEST_ROUNDTRIP("4.9406564584124654e-324"); /* minimum denormal */
-  TEST_ROUNDTRIP("-4.9406564584124654e-324");
-  TEST_ROUNDTRIP("2.2250738585072009e-308");  /* Max subnormal double */
-  TEST_ROUNDTRIP("-2.2250738585072009e-308");
+  TEST_ROUNDTRIP("5e-324"); /* minimum denormal */
+  TEST_ROUNDTRIP("-5e-324");
+  TEST_ROUNDTRIP("2.225073858507201e-308");  /* Max subnormal double */
+  TEST_ROUNDTRIP("-2.225073858507201e-308");
   TEST_ROUNDTRIP("2.2250738585072014e-308");  /* Min normal positive double */
   TEST_ROUNDTRIP("-2.2250738585072014e-308");
   TEST_ROUNDTRIP("1.7976931348623157e+308");  /* Max double */
   TEST_ROUNDTRIP("-1.7976931348623157e+308");
+
+  /* shortest representation that reads back to the same double */
+  TEST_ROUNDTRIP("0.1");
+  TEST_ROUNDTRIP("0.0001");
+  TEST_ROUNDTRIP("1e-05");
+  TEST_ROUNDTRIP("10000000000000000");
+  TEST_ROUNDTRIP("1e+17");
+  TEST_ROUNDTRIP("123456.789");
+  TEST_STRINGIFY("0.1", "0.10000000000000001");
+  TEST_STRINGIFY("0.30000000000000004", "0.30000000000000004");
+  TEST_STRINGIFY("5e-324", "4.9406564584124654e-324");
+  TEST_STRINGIFY("123", "123.0");
+  TEST_STRINGIFY("1e+100", "1E100");
+  TEST_STRINGIFY("1.5e-07", "0.00000015");
+
+  TEST_ROUNDTRIP("9007199254740993");
+  TEST_ROUNDTRIP("-9223372036854775808");
+  TEST_ROUNDTRIP("18446744073709551615");
+  TEST_STRINGIFY("1.8446744073709552e+19", "18446744073709551616");
 }
 
 static void test_stringify_string() {
@@ -416,6 +896,122 @@ static void test_stringify_object() {
   TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}");
 }
 
+static void test_stringify_long_string() {
+  static const char *escaped[] = { "\\\"", "\\\\", "\\n", "\\u001F", "\\u0000" };
+  cjson_parser *parser = cjson_parser_create(0);
+  char json[128], *big;
+  const char *out;
+  size_t i, k, len, out_len;
+  cjson_value v;
+
+  /* 转义字符出现在各个位置 */
+  for (k = 0; k < 5; k++) {
+    for (i = 0; i < 70; i++) {
+      size_t n = strlen(escaped[k]);
+      memset(json, 'a', sizeof(json));
+      json[0] = '\"';
+      memcpy(json + 1 + i, escaped[k], n);
+      json[1 + i + n + 5] = '\"';
+      len = 1 + i + n + 6;
+      cjson_value_init(&v);
+      TEST_INT(CJSON_OK, cjson_parse_n(&v, json, len));
+      out = cjson_parser_stringify(parser, &v, &out_len);
+      TEST_SIZE_T(len, out_len);
+      TEST_TRUE(memcmp(json, out, len) == 0);
+      cjson_value_free(&v);
+    }
+  }
+
+  /* 长字符串序列化时栈不按6倍预留 */
+  len = 1 << 20;
+  big = (char *)malloc(len);
+  memset(big, 'x', len);
+  cjson_value_init(&v);
+  cjson_set_string(&v, big, len);
+  cjson_parser_reset(parser);
+  out = cjson_parser_stringify(parser, &v, &out_len);
+  TEST_SIZE_T(len + 2, out_len);
+  TEST_TRUE(out[0] == '"' && out[len + 1] == '"');
+  TEST_TRUE(cjson_parser_get_stack_size(parser) < 2 * len);
+  cjson_value_free(&v);
+  free(big);
+  cjson_parser_destroy(parser);
+}
+
+#define TEST_STRINGIFY_EX(expect, json, indent, crlf, sort_keys, ascii_only)\
+  do {\
+    cjson_stringify_options opt = { indent, crlf, sort_keys, ascii_only };\
+    cjson_value v, v2;\
+    char* json2;\
+    size_t length;\
+    cjson_value_init(&v);\
+    cjson_value_init(&v2);\
+    TEST_INT(CJSON_OK, cjson_parse(&v, json));\
+    json2 = cjson_stringify_ex(v, &opt, &length);\
+    TEST_STRING(expect, json2, length);\
+    TEST_INT(CJSON_OK, cjson_parse_n(&v2, json2, length));\
+    TEST_TRUE(cjson_is_equal(&v, &v2));\
+    cjson_value_free(&v);\
+    cjson_value_free(&v2);\
+    cjson_free(json2);\
+  } while(0)
+
+static void test_stringify_options() {
+  /* 默认选项和紧凑输出相同 */
+  TEST_STRINGIFY_EX("{\"a\":[1,{}],\"b\":\"\\n\"}", "{ \"a\" : [ 1 , { } ] , \"b\" : \"\\n\" }", 0, 0, 0, 0);
+
+  /* 缩进 */
+  TEST_STRINGIFY_EX("1", "1", 2, 0, 0, 0);
+  TEST_STRINGIFY_EX("[]", "[ ]", 2, 0, 0, 0);
+  TEST_STRINGIFY_EX("{}", "{ }", 2, 0, 0, 0);
+  TEST_STRINGIFY_EX("[\n  1,\n  2\n]", "[1,2]", 2, 0, 0, 0);
+  TEST_STRINGIFY_EX("{\n    \"a\": [\n        1,\n        {},\n        []\n    ],\n    \"b\": {\n        \"c\": null\n    }\n}",
+    "{\"a\":[1,{},[]],\"b\":{\"c\":null}}", 4, 0, 0, 0);
+  TEST_STRINGIFY_EX("{\r\n  \"a\": [\r\n    true\r\n  ]\r\n}", "{\"a\":[true]}", 2, 1, 0, 0);
+
+  /* key排序，按字节序，重复的key保持原来的顺序 */
+  TEST_STRINGIFY_EX("{\"\":0,\"a\":1,\"ab\":2,\"b\":{\"x\":1,\"y\":2},\"\xC3\xA9\":3}",
+    "{\"b\":{\"y\":2,\"x\":1},\"\xC3\xA9\":3,\"ab\":2,\"a\":1,\"\":0}", 0, 0, 1, 0);
+  {
+    cjson_stringify_options opt = { 0, 0, 1, 0 };
+    cjson_value v;
+    char *json;
+    size_t length;
+    cjson_value_init(&v);
+    TEST_INT(CJSON_OK, cjson_parse(&v, "[{\"b\":0,\"a\":1,\"a\":2,\"a\":3}]"));
+    json = cjson_stringify_ex(v, &opt, &length);
+    TEST_STRING("[{\"a\":1,\"a\":2,\"a\":3,\"b\":0}]", json, length);
+    cjson_free(json);
+    cjson_value_free(&v);
+  }
+  TEST_STRINGIFY_EX("{\n \"a\": 1,\n \"b\": 2\n}", "{\"b\":2,\"a\":1}", 1, 0, 1, 0);
+  TEST_STRINGIFY_EX("{\"a\":2,\"a\":3,\"b\":1}", "{\"b\":1,\"a\":2,\"a\":3}", 0, 0, 1, 0);  /* 重复key排序后重新解析仍然相等 */
+
+  /* 只输出ASCII */
+  TEST_STRINGIFY_EX("\"abc\"", "\"abc\"", 0, 0, 0, 1);
+  TEST_STRINGIFY_EX("\"\\u00A2\\u20AC\\uD834\\uDD1E\\n\"", "\"\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\\n\"", 0, 0, 0, 1);
+  TEST_STRINGIFY_EX("{\"\\u00E9\":\"x\\u00E9y\"}", "{\"\\u00e9\":\"x\xC3\xA9y\"}", 0, 0, 0, 1);
+  TEST_STRINGIFY_EX("\"\\uD83D\\uDE00\\uFFFF\"", "\"\\uD83D\\uDE00\\uffff\"", 0, 0, 0, 1);
+
+  /* 无效的UTF-8字节 */
+  {
+    cjson_stringify_options opt = { 0, 0, 0, 1 };
+    cjson_value v;
+    char *json;
+    size_t length;
+    cjson_value_init(&v);
+    cjson_set_string(&v, "a\xFF\xC3(\xE2\x82", 6);
+    json = cjson_stringify_ex(v, &opt, &length);
+    TEST_STRING("\"a\\uFFFD\\uFFFD(\\uFFFD\\uFFFD\"", json, length);
+    cjson_free(json);
+    cjson_set_string(&v, "\xED\xA0\x80\xC0\xAF", 5);  /* 代理项和过长编码 */
+    json = cjson_stringify_ex(v, &opt, &length);
+    TEST_STRING("\"\\uFFFD\\uFFFD\\uFFFD\\uFFFD\\uFFFD\"", json, length);
+    cjson_free(json);
+    cjson_value_free(&v);
+  }
+}
+
 static void test_stringify() {
   TEST_ROUNDTRIP("null");
   TEST_ROUNDTRIP("false");
@@ -424,6 +1020,8 @@ static void test_stringify() {
   test_stringify_string();
   test_stringify_array();
   test_stringify_object();
+  test_stringify_long_string();
+  test_stringify_options();
 }
 
 
@@ -447,6 +1045,13 @@ static void test_equal() {
   TEST_EQUAL("null", "0", 0);
   TEST_EQUAL("123", "123", 1);
   TEST_EQUAL("123", "456", 0);
+  TEST_EQUAL("123", "123.0", 1);
+  TEST_EQUAL("123", "1.23e2", 1);
+  TEST_EQUAL("123", "123.5", 0);
+  TEST_EQUAL("9007199254740993", "9007199254740992", 0);
+  TEST_EQUAL("9007199254740992", "9007199254740992.0", 1);
+  TEST_EQUAL("18446744073709551615", "-1", 0);
+  TEST_EQUAL("18446744073709551615", "18446744073709551615", 1);
   TEST_EQUAL("\"abc\"", "\"abc\"", 1);
   TEST_EQUAL("\"abc\"", "\"abcd\"", 0);
   TEST_EQUAL("[]", "[]", 1);
@@ -463,6 +1068,86 @@ static void test_equal() {
   TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2,\"c\":3}", 0);
   TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":{}}}}", 1);
   TEST_EQUAL("{\"a\":{\"b\":{\"c\":{}}}}", "{\"a\":{\"b\":{\"c\":[]}}}", 0);
+  TEST_EQUAL("{\"a\":1}", "{\"b\":1}", 0);   //值相同但key不同
+  TEST_EQUAL("{\"a\":1,\"b\":1}", "{\"b\":1,\"c\":1}", 0);
+  TEST_EQUAL("{\"\":1}", "{\"\":1}", 1);
+  /* 重复key按第一个比较，和参数顺序无关 */
+  TEST_EQUAL("{\"a\":1,\"a\":1}", "{\"a\":1,\"b\":2}", 0);
+  TEST_EQUAL("{\"a\":1,\"b\":2}", "{\"a\":1,\"a\":1}", 0);
+  TEST_EQUAL("{\"a\":2,\"a\":1}", "{\"a\":2,\"a\":3}", 1);
+  TEST_EQUAL("{\"a\":2,\"a\":3}", "{\"a\":2,\"a\":1}", 1);
+  TEST_EQUAL("{\"a\":2,\"a\":1}", "{\"a\":1,\"a\":3}", 0);
+  TEST_EQUAL("{\"a\":1,\"a\":3}", "{\"a\":2,\"a\":1}", 0);
+  TEST_EQUAL("{\"b\":1,\"a\":2,\"a\":3}", "{\"a\":2,\"a\":3,\"b\":1}", 1);
+  TEST_EQUAL("{\"a\":2,\"a\":3,\"b\":1}", "{\"b\":1,\"a\":2,\"a\":3}", 1);
+  TEST_EQUAL("{\"a\":1,\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2,\"c\":3}", 0);
+  TEST_EQUAL("{\"a\":1,\"b\":2,\"c\":3}", "{\"a\":1,\"a\":1,\"b\":2}", 0);
+}
+
+static void make_large_object(char *json, size_t n, size_t start, const char *last) {  /* 从start开始循环排列的n个key，最后一个成员是last */
+  size_t i;
+  json += sprintf(json, "{");
+  for (i = 0; i < n; i++)
+    json += sprintf(json, "\"key%zu\":[%zu,\"v\"],", (start + i) % n, (start + i) % n);
+  sprintf(json, "%s}", last);
+}
+
+static void test_equal_large_object() {
+  static char json1[65536], json2[65536];
+  cjson_value v1, v2;
+
+  make_large_object(json1, 2000, 0, "\"x\":1");
+  make_large_object(json2, 2000, 777, "\"x\":1");
+  cjson_value_init(&v1);
+  cjson_value_init(&v2);
+  TEST_INT(CJSON_OK, cjson_parse(&v1, json1));
+  TEST_INT(CJSON_OK, cjson_parse(&v2, json2));
+  TEST_TRUE(cjson_is_equal(&v1, &v2));
+  TEST_TRUE(cjson_hash(&v1) == cjson_hash(&v2));
+
+  make_large_object(json2, 2000, 777, "\"x\":2");
+  cjson_value_free(&v2);
+  TEST_INT(CJSON_OK, cjson_parse(&v2, json2));
+  TEST_FALSE(cjson_is_equal(&v1, &v2));
+  TEST_TRUE(cjson_hash(&v1) != cjson_hash(&v2));
+
+  make_large_object(json2, 2000, 777, "\"y\":1");
+  cjson_value_free(&v2);
+  TEST_INT(CJSON_OK, cjson_parse(&v2, json2));
+  TEST_FALSE(cjson_is_equal(&v1, &v2));
+  TEST_TRUE(cjson_hash(&v1) != cjson_hash(&v2));
+
+  cjson_value_free(&v1);
+  cjson_value_free(&v2);
+}
+
+#define TEST_HASH(json1, json2, same) \
+  do {\
+    cjson_value v1, v2;\
+    cjson_value_init(&v1);\
+    cjson_value_init(&v2);\
+    TEST_INT(CJSON_OK, cjson_parse(&v1, json1));\
+    TEST_INT(CJSON_OK, cjson_parse(&v2, json2));\
+    TEST_INT(same, cjson_hash(&v1) == cjson_hash(&v2));\
+    cjson_value_free(&v1);\
+    cjson_value_free(&v2);\
+  } while(0)
+
+static void test_hash() {
+  TEST_HASH("null", "null", 1);
+  TEST_HASH("1", "1.0", 1);
+  TEST_HASH("0", "-0", 1);
+  TEST_HASH("18446744073709551615", "18446744073709551615", 1);
+  TEST_HASH("\"abc\"", "\"abc\"", 1);
+  TEST_HASH("{\"a\":1,\"b\":[1,2]}", "{\"b\":[1,2.0],\"a\":1}", 1);
+  TEST_HASH("null", "false", 0);
+  TEST_HASH("1", "2", 0);
+  TEST_HASH("1", "\"1\"", 0);
+  TEST_HASH("[1,2]", "[2,1]", 0);
+  TEST_HASH("[]", "{}", 0);
+  TEST_HASH("[[]]", "[]", 0);
+  TEST_HASH("{\"a\":1}", "{\"b\":1}", 0);
+  TEST_HASH("{\"a\":1,\"b\":2}", "{\"a\":2,\"b\":1}", 0);
 }
 
 static void test_copy() {
@@ -533,6 +1218,30 @@ static void test_access_number() {
   cjson_value_free(&v);
 }
 
+static void test_access_int64() {
+  cjson_value v, v2;
+  cjson_value_init(&v);
+  cjson_value_init(&v2);
+  cjson_set_string(&v, "a", 1);
+  cjson_set_int64(&v, INT64_MIN);
+  TEST_TRUE(cjson_is_integer(v));
+  TEST_INT64(INT64_MIN, cjson_get_int64(v));
+  cjson_set_uint64(&v, 42);
+  TEST_INT64(42, cjson_get_int64(v));
+  TEST_UINT64(42, cjson_get_uint64(v));
+  cjson_set_uint64(&v, UINT64_MAX);
+  TEST_UINT64(UINT64_MAX, cjson_get_uint64(v));
+  TEST_DOUBLE(18446744073709551616.0, cjson_get_number(v));
+  cjson_copy(&v2, &v);
+  TEST_UINT64(UINT64_MAX, cjson_get_uint64(v2));
+  TEST_TRUE(cjson_is_equal(&v, &v2));
+  cjson_set_number(&v, -2.5);
+  TEST_FALSE(cjson_is_integer(v));
+  TEST_INT64(-2, cjson_get_int64(v));
+  cjson_value_free(&v);
+  cjson_value_free(&v2);
+}
+
 static void test_access_string() {
   cjson_value v;
   cjson_value_init(&v);
@@ -689,27 +1398,1196 @@ static void test_access_object() {
   cjson_value_free(&o);
 }
 
+static void test_object_index() {
+  cjson_value o, c, *pv;
+  cjson_arena *arena;
+  char key[16], json[4096], *p;
+  size_t i, n = 1000;
+
+  /* 超过阈值之后查找和设置都通过索引 */
+  cjson_value_init(&o);
+  cjson_init_object(&o, 0);
+  for (i = 0; i < n; i++) {
+    sprintf(key, "key%zu", i);
+    cjson_set_number(cjson_set_object_value(&o, key, strlen(key)), (double)i);
+  }
+  TEST_SIZE_T(n, cjson_get_object_size(o));
+  for (i = 0; i < n; i++) {
+    sprintf(key, "key%zu", i);
+    TEST_SIZE_T(i, cjson_find_object_index(o, key, strlen(key)));
+  }
+  TEST_TRUE(cjson_find_object_index(o, "key1000", 7) == CJSON_KEY_NOT_EXIST);
+  TEST_TRUE(cjson_find_object_index(o, "key", 3) == CJSON_KEY_NOT_EXIST);
+
+  /* 已经存在的key返回原来的值，不增加成员 */
+  pv = cjson_set_object_value(&o, "key10", 5);
+  TEST_TRUE(pv == cjson_get_object_value(o, 10));
+  TEST_DOUBLE(10.0, cjson_get_number(*pv));
+  TEST_SIZE_T(n, cjson_get_object_size(o));
+
+  /* 删除之后后面成员的下标前移 */
+  cjson_remove_object_value(&o, 0);
+  cjson_remove_object_value(&o, 500);
+  TEST_SIZE_T(n - 2, cjson_get_object_size(o));
+  TEST_TRUE(cjson_find_object_index(o, "key0", 4) == CJSON_KEY_NOT_EXIST);
+  TEST_TRUE(cjson_find_object_index(o, "key501", 6) == CJSON_KEY_NOT_EXIST);
+  TEST_SIZE_T(0, cjson_find_object_index(o, "key1", 4));
+  TEST_SIZE_T(500, cjson_find_object_index(o, "key502", 6));
+  TEST_SIZE_T(n - 3, cjson_find_object_index(o, "key999", 6));
+
+  cjson_value_init(&c);
+  cjson_copy(&c, &o);
+  TEST_SIZE_T(500, cjson_find_object_index(c, "key502", 6));
+  TEST_TRUE(cjson_is_equal(&o, &c));
+  cjson_value_free(&c);
+
+  cjson_clear_object(&o);
+  TEST_TRUE(cjson_find_object_index(o, "key1", 4) == CJSON_KEY_NOT_EXIST);
+  cjson_set_boolean(cjson_set_object_value(&o, "key1", 4), 1);
+  TEST_SIZE_T(0, cjson_find_object_index(o, "key1", 4));
+  cjson_value_free(&o);
+
+  /* 解析出的大对象，重复的key和线性查找一样找到第一个 */
+  p = json;
+  p += sprintf(p, "{");
+  for (i = 0; i < 100; i++)
+    p += sprintf(p, "\"k%zu\":%zu,", i, i);
+  sprintf(p, "\"k7\":-1}");
+  cjson_value_init(&o);
+  TEST_INT(CJSON_OK, cjson_parse(&o, json));
+  TEST_SIZE_T(101, cjson_get_object_size(o));
+  TEST_SIZE_T(7, cjson_find_object_index(o, "k7", 2));
+  pv = cjson_find_object_value(o, "k99", 3);
+  TEST_TRUE(pv != NULL);
+  TEST_DOUBLE(99.0, cjson_get_number(*pv));
+  cjson_value_free(&o);
+
+  arena = cjson_arena_create(0);
+  TEST_INT(CJSON_OK, cjson_arena_parse(arena, &o, json, strlen(json)));
+  TEST_SIZE_T(42, cjson_find_object_index(o, "k42", 3));
+  cjson_value_free(&o);
+  cjson_arena_destroy(arena);
+
+  p = json + strlen(json) + 1;
+  memcpy(p, json, strlen(json));
+  TEST_INT(CJSON_OK, cjson_parse_insitu(&o, p, strlen(json)));
+  cjson_set_null(cjson_set_object_value(&o, "new", 3));  /* 原地解析的key复制到堆上，索引仍然有效 */
+  TEST_SIZE_T(42, cjson_find_object_index(o, "k42", 3));
+  TEST_SIZE_T(101, cjson_find_object_index(o, "new", 3));
+  cjson_value_free(&o);
+}
+
+#define TEST_POINTER(json_expect, path)\
+  do {\
+    cjson_pointer *p = cjson_pointer_compile(path, sizeof(path) - 1);\
+    cjson_value *r, e;\
+    TEST_TRUE(p != NULL);\
+    cjson_value_init(&e);\
+    TEST_INT(CJSON_OK, cjson_parse(&e, json_expect));\
+    r = cjson_pointer_get(p, &v);\
+    TEST_TRUE(r != NULL && cjson_is_equal(r, &e));\
+    cjson_value_free(&e);\
+    cjson_pointer_free(p);\
+  } while(0)
+
+#define TEST_POINTER_MISS(path)\
+  do {\
+    cjson_pointer *p = cjson_pointer_compile(path, sizeof(path) - 1);\
+    TEST_TRUE(p != NULL);\
+    TEST_TRUE(cjson_pointer_get(p, &v) == NULL);\
+    cjson_pointer_free(p);\
+  } while(0)
+
+static void test_pointer() {
+  cjson_pointer *p;
+  cjson_value v, *e;
+  char path[16];
+  size_t i;
+
+  /* RFC 6901 第5节的例子 */
+  cjson_value_init(&v);
+  TEST_INT(CJSON_OK, cjson_parse(&v, "{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,\"g|h\":4,\"i\\\\j\":5,\"k\\\"l\":6,\" \":7,\"m~n\":8}"));
+  TEST_POINTER("{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,\"g|h\":4,\"i\\\\j\":5,\"k\\\"l\":6,\" \":7,\"m~n\":8}", "");
+  TEST_POINTER("[\"bar\",\"baz\"]", "/foo");
+  TEST_POINTER("\"bar\"", "/foo/0");
+  TEST_POINTER("0", "/");
+  TEST_POINTER("1", "/a~1b");
+  TEST_POINTER("2", "/c%d");
+  TEST_POINTER("3", "/e^f");
+  TEST_POINTER("4", "/g|h");
+  TEST_POINTER("5", "/i\\j");
+  TEST_POINTER("6", "/k\"l");
+  TEST_POINTER("7", "/ ");
+  TEST_POINTER("8", "/m~0n");
+
+  TEST_POINTER_MISS("/foo/2");
+  TEST_POINTER_MISS("/foo/-");
+  TEST_POINTER_MISS("/foo/01");
+  TEST_POINTER_MISS("/foo/1x");
+  TEST_POINTER_MISS("/foo/99999999999999999999999");
+  TEST_POINTER_MISS("/foo/0/x");
+  TEST_POINTER_MISS("/bar");
+  TEST_POINTER_MISS("/a/b");
+  TEST_POINTER_MISS("//");
+
+  /* 格式错误 */
+  TEST_TRUE(cjson_pointer_compile("foo", 3) == NULL);
+  TEST_TRUE(cjson_pointer_compile("/~", 2) == NULL);
+  TEST_TRUE(cjson_pointer_compile("/~2", 3) == NULL);
+  TEST_TRUE(cjson_pointer_compile("/a~/b", 5) == NULL);
+
+  /* 添加、替换和删除 */
+  p = cjson_pointer_compile("/foo/-", 6);
+  cjson_set_string(cjson_pointer_set(p, &v), "qux", 3);
+  TEST_POINTER("[\"bar\",\"baz\",\"qux\"]", "/foo");
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("/foo/3", 6);
+  cjson_set_number(cjson_pointer_set(p, &v), 1.0);
+  cjson_set_number(cjson_pointer_set(p, &v), 2.0);   /* 已经存在时返回原来的元素 */
+  TEST_POINTER("[\"bar\",\"baz\",\"qux\",2]", "/foo");
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("/foo/5", 6);
+  TEST_TRUE(cjson_pointer_set(p, &v) == NULL);
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("/x/y", 4);
+  TEST_TRUE(cjson_pointer_set(p, &v) == NULL);  /* 中间的节点不存在 */
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("/x", 2);
+  cjson_init_object(cjson_pointer_set(p, &v), 0);
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("/x/", 3);  /* 空key */
+  cjson_set_boolean(cjson_pointer_set(p, &v), 1);
+  cjson_pointer_free(p);
+  TEST_POINTER("{\"\":true}", "/x");
+
+  p = cjson_pointer_compile("/foo/1", 6);
+  TEST_INT(1, cjson_pointer_remove(p, &v));
+  TEST_POINTER("[\"bar\",\"qux\",2]", "/foo");
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("/m~0n", 5);
+  TEST_INT(1, cjson_pointer_remove(p, &v));
+  TEST_INT(0, cjson_pointer_remove(p, &v));
+  TEST_POINTER_MISS("/m~0n");
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("", 0);
+  TEST_INT(0, cjson_pointer_remove(p, &v));
+  TEST_TRUE(cjson_pointer_set(p, &v) == &v);
+  cjson_pointer_free(p);
+  cjson_value_free(&v);
+
+  /* 有哈希索引的大对象 */
+  cjson_value_init(&v);
+  cjson_init_object(&v, 0);
+  for (i = 0; i < 100; i++) {
+    sprintf(path, "k%d", (int)i);
+    e = cjson_set_object_value(&v, path, strlen(path));
+    cjson_init_array(e, 0);
+    cjson_set_number(cjson_pushback_array_element(e), (double)i);
+  }
+  for (i = 0; i < 100; i += 7) {
+    sprintf(path, "/k%d/0", (int)i);
+    p = cjson_pointer_compile(path, strlen(path));
+    e = cjson_pointer_get(p, &v);
+    TEST_TRUE(e != NULL && cjson_get_number(*e) == (double)i);
+    cjson_pointer_free(p);
+  }
+  p = cjson_pointer_compile("/k50", 4);
+  TEST_INT(1, cjson_pointer_remove(p, &v));
+  TEST_TRUE(cjson_pointer_get(p, &v) == NULL);
+  cjson_pointer_free(p);
+  p = cjson_pointer_compile("/k99/0", 6);
+  e = cjson_pointer_get(p, &v);
+  TEST_TRUE(e != NULL && cjson_get_number(*e) == 99.0);
+  cjson_pointer_free(p);
+  cjson_value_free(&v);
+}
+
+static char *make_nested(size_t depth, const char *open, const char *inner, const char *close) {  /* depth层嵌套的json，由调用者free */
+  size_t lo = strlen(open), li = strlen(inner), lc = strlen(close), i;
+  char *json = (char *)malloc(depth * (lo + lc) + li + 1), *p = json;
+  for (i = 0; i < depth; i++, p += lo)
+    memcpy(p, open, lo);
+  memcpy(p, inner, li);
+  p += li;
+  for (i = 0; i < depth; i++, p += lc)
+    memcpy(p, close, lc);
+  *p = '\0';
+  return json;
+}
+
+static void test_lazy() {
+  const char *json = "{\"a\":[1,{\"x\":\"]}[{\\\"\"},[]],\"b\":{\"c\":[true,null],\"d\":-1.5},\"e\":\"s\",\"f\":[1 2],\"g\":{}}";
+  cjson_value v, full, copy, *e, *f;
+  cjson_pointer *p;
+  char *s1, *s2;
+  size_t l1, l2;
+
+  cjson_value_init(&v);
+  cjson_value_init(&full);
+  TEST_INT(CJSON_OK, cjson_parse_lazy(&v, json, strlen(json)));
+  TEST_INT(CJSON_OBJECT, cjson_get_type(v));
+  TEST_TRUE(cjson_is_lazy(v));
+
+  /* 只解析访问到的一层 */
+  e = cjson_find_object_value(v, "b", 1);
+  TEST_FALSE(cjson_is_lazy(v));
+  TEST_TRUE(e != NULL && cjson_is_lazy(*e));
+  TEST_TRUE(cjson_is_lazy(*cjson_find_object_value(v, "a", 1)));
+  f = cjson_find_object_value(*e, "d", 1);
+  TEST_DOUBLE(-1.5, cjson_get_number(*f));
+  TEST_TRUE(cjson_is_lazy(*cjson_find_object_value(*e, "c", 1)));
+  TEST_SIZE_T(2, cjson_get_object_size(*e));
+  TEST_STRING("d", cjson_get_object_key(*e, 1), cjson_get_object_key_length(*e, 1));
+  e = cjson_find_object_value(v, "a", 1);
+  TEST_SIZE_T(3, cjson_get_array_size(*e));
+  f = cjson_get_object_value(*cjson_get_array_element(*e, 1), 0);
+  TEST_STRING("]}[{\"", cjson_get_string(*f), cjson_get_string_length(*f));
+  TEST_SIZE_T(0, cjson_get_array_size(*cjson_get_array_element(*e, 2)));
+
+  /* 出错的一层按空容器处理 */
+  e = cjson_find_object_value(v, "f", 1);
+  TEST_INT(CJSON_ERR_ARRAY_NEED_COMMA_OR_SQUARE_BRACKET, cjson_lazy_load(e));
+  TEST_FALSE(cjson_is_lazy(*e));
+  TEST_SIZE_T(0, cjson_get_array_size(*e));
+  TEST_INT(CJSON_OK, cjson_lazy_load(e));
+  cjson_remove_object_value(&v, cjson_find_object_index(v, "f", 1));
+
+  /* 生成、比较、哈希和复制的结果和完整解析相同 */
+  TEST_INT(CJSON_OK, cjson_parse(&full, "{\"a\":[1,{\"x\":\"]}[{\\\"\"},[]],\"b\":{\"c\":[true,null],\"d\":-1.5},\"e\":\"s\",\"g\":{}}"));
+  TEST_TRUE(cjson_is_equal(&v, &full));
+  TEST_TRUE(cjson_is_equal(&full, &v));
+  TEST_SIZE_T(cjson_hash(&full), cjson_hash(&v));
+  s1 = cjson_stringify(v, &l1);
+  s2 = cjson_stringify(full, &l2);
+  TEST_SIZE_T(l2, l1);
+  TEST_TRUE(memcmp(s1, s2, l1) == 0);
+  cjson_free(s1);
+  cjson_free(s2);
+  cjson_value_init(&copy);
+  cjson_copy(&copy, &v);
+  TEST_TRUE(cjson_is_equal(&copy, &full));
+  cjson_value_free(&copy);
+
+  /* 修改延迟解析的值，之前取得的元素指针仍然有效 */
+  e = cjson_find_object_value(v, "b", 1);
+  f = cjson_find_object_value(*e, "c", 1);
+  e = cjson_get_array_element(*f, 0);
+  cjson_set_number(cjson_pushback_array_element(f), 3.0);
+  TEST_FALSE(cjson_is_lazy(*f));
+  TEST_SIZE_T(3, cjson_get_array_size(*f));
+  TEST_INT(CJSON_TRUE, cjson_get_type(*cjson_get_array_element(*f, 0)));
+  cjson_set_boolean(cjson_set_object_value(cjson_find_object_value(v, "g", 1), "h", 1), 0);
+  p = cjson_pointer_compile("/b/c/2", 6);
+  e = cjson_pointer_get(p, &v);
+  TEST_TRUE(e != NULL && cjson_get_number(*e) == 3.0);
+  cjson_pointer_free(p);
+  s1 = cjson_stringify(v, &l1);
+  TEST_STRING("{\"a\":[1,{\"x\":\"]}[{\\\"\"},[]],\"b\":{\"c\":[true,null,3],\"d\":-1.5},\"e\":\"s\",\"g\":{\"h\":false}}", s1, l1);
+  cjson_free(s1);
+  cjson_value_free(&v);
+  cjson_value_free(&full);
+
+  /* 清空和收缩还没有解析的子节点 */
+  TEST_INT(CJSON_OK, cjson_parse_lazy(&v, "{\"a\":[1,2,3],\"o\":{\"x\":1,\"y\":[2]},\"s\":[4,5],\"t\":{\"z\":6}}", 55));
+  e = cjson_find_object_value(v, "a", 1);
+  TEST_TRUE(cjson_is_lazy(*e));
+  cjson_clear_array_element(e);
+  TEST_FALSE(cjson_is_lazy(*e));
+  TEST_SIZE_T(0, cjson_get_array_size(*e));
+  e = cjson_find_object_value(v, "o", 1);
+  TEST_TRUE(cjson_is_lazy(*e));
+  cjson_clear_object(e);
+  TEST_SIZE_T(0, cjson_get_object_size(*e));
+  e = cjson_find_object_value(v, "s", 1);
+  cjson_shrink_array(e);
+  TEST_SIZE_T(2, cjson_get_array_capacity(*e));
+  TEST_DOUBLE(5.0, cjson_get_number(*cjson_get_array_element(*e, 1)));
+  e = cjson_find_object_value(v, "t", 1);
+  cjson_shrink_object(e);
+  TEST_SIZE_T(1, cjson_get_object_capacity(*e));
+  TEST_DOUBLE(6.0, cjson_get_number(*cjson_find_object_value(*e, "z", 1)));
+  s1 = cjson_stringify(v, &l1);
+  TEST_STRING("{\"a\":[],\"o\":{},\"s\":[4,5],\"t\":{\"z\":6}}", s1, l1);
+  cjson_free(s1);
+  cjson_value_free(&v);
+
+  /* 没有访问过的部分直接释放 */
+  TEST_INT(CJSON_OK, cjson_parse_lazy(&v, json, strlen(json)));
+  cjson_get_array_size(*cjson_find_object_value(v, "a", 1));
+  cjson_value_free(&v);
+
+  /* 开始时只检查括号和字符串 */
+  TEST_INT(CJSON_OK, cjson_parse_lazy(&v, " 1.5 ", 5));
+  TEST_DOUBLE(1.5, cjson_get_number(v));
+  TEST_INT(CJSON_OK, cjson_parse_lazy(&v, "[ ] ", 4));
+  TEST_SIZE_T(0, cjson_get_array_size(v));
+  cjson_value_free(&v);
+  TEST_INT(CJSON_ERR_ROOT_NOT_SINGULAR, cjson_parse_lazy(&v, "[1] x", 5));
+  TEST_INT(CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET, cjson_parse_lazy(&v, "[1,{]", 5));   /* 括号不匹配 */
+  TEST_INT(CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET, cjson_parse_lazy(&v, "{\"a\":[1]", 8));
+  TEST_INT(CJSON_ERR_STRING_MISS_QUOTATION_MARK, cjson_parse_lazy(&v, "[\"]", 3));
+  TEST_INT(CJSON_ERR_STRING_MISS_QUOTATION_MARK, cjson_parse_lazy(&v, "[\"\\", 3));
+  TEST_INT(CJSON_ERR_STRING_INVALID_CAHR, cjson_parse_lazy(&v, "[\"\x01\"]", 5));
+  {
+    char *deep = make_nested(1025, "[", "", "]");
+    TEST_INT(CJSON_ERR_DEPTH, cjson_parse_lazy(&v, deep, strlen(deep)));
+    free(deep);
+    deep = make_nested(1024, "[", "", "]");
+    TEST_INT(CJSON_OK, cjson_parse_lazy(&v, deep, strlen(deep)));
+    e = &v;
+    while (cjson_get_array_size(*e) > 0)   /* 每一层都在访问时解析 */
+      e = cjson_get_array_element(*e, 0);
+    cjson_value_free(&v);
+    free(deep);
+  }
+}
+
+static void test_tape() {
+  const char *json = "{\"n\":null,\"t\":true,\"f\":false,\"d\":-1.5,\"i\":-42,\"u\":18446744073709551615,"
+                     "\"s\":\"a\\u0000b\",\"\":\"\",\"a\":[1,[],{},[\"x\",{\"k\":[2]}]],\"o\":{\"k\":1,\"k\":2}}";
+  cjson_tape *tape, *tape2;
+  cjson_tape_value root, a, e;
+  cjson_value v, v2;
+  char *s1, *s2;
+  size_t i, l1, l2;
+
+  TEST_INT(CJSON_OK, cjson_tape_parse(&tape, json, strlen(json)));
+  root = cjson_tape_root(tape);
+  TEST_INT(CJSON_OBJECT, cjson_tape_get_type(root));
+  TEST_SIZE_T(10, cjson_tape_get_object_size(root));
+  TEST_STRING("n", cjson_tape_get_object_key(root, 0), cjson_tape_get_object_key_length(root, 0));
+  TEST_INT(CJSON_NULL, cjson_tape_get_type(cjson_tape_get_object_value(root, 0)));
+  TEST_TRUE(cjson_tape_get_boolean(cjson_tape_get_object_value(root, 1)));
+  TEST_FALSE(cjson_tape_get_boolean(cjson_tape_get_object_value(root, 2)));
+  e = cjson_tape_get_object_value(root, 3);
+  TEST_DOUBLE(-1.5, cjson_tape_get_number(e));
+  TEST_FALSE(cjson_tape_is_integer(e));
+  e = cjson_tape_get_object_value(root, 4);
+  TEST_TRUE(cjson_tape_is_integer(e));
+  TEST_INT64(-42, cjson_tape_get_int64(e));
+  TEST_DOUBLE(-42.0, cjson_tape_get_number(e));
+  TEST_UINT64(18446744073709551615ULL, cjson_tape_get_uint64(cjson_tape_get_object_value(root, 5)));
+  e = cjson_tape_get_object_value(root, 6);
+  TEST_STRING("a\0b", cjson_tape_get_string(e), cjson_tape_get_string_length(e));
+  TEST_SIZE_T(7, cjson_tape_find_object_index(root, "", 0));
+  TEST_SIZE_T(0, cjson_tape_get_object_key_length(root, 7));
+  TEST_SIZE_T(0, cjson_tape_get_string_length(cjson_tape_get_object_value(root, 7)));
+  TEST_SIZE_T(CJSON_KEY_NOT_EXIST, cjson_tape_find_object_index(root, "x", 1));
+
+  a = cjson_tape_get_object_value(root, cjson_tape_find_object_index(root, "a", 1));
+  TEST_SIZE_T(4, cjson_tape_get_array_size(a));
+  TEST_DOUBLE(1.0, cjson_tape_get_number(cjson_tape_get_array_element(a, 0)));
+  TEST_SIZE_T(0, cjson_tape_get_array_size(cjson_tape_get_array_element(a, 1)));
+  TEST_SIZE_T(0, cjson_tape_get_object_size(cjson_tape_get_array_element(a, 2)));
+  e = cjson_tape_get_array_element(a, 3);
+  TEST_STRING("x", cjson_tape_get_string(cjson_tape_get_array_element(e, 0)), 1);
+  e = cjson_tape_get_object_value(cjson_tape_get_array_element(e, 1), 0);
+  TEST_INT64(2, cjson_tape_get_int64(cjson_tape_get_array_element(e, 0)));
+
+  e = cjson_tape_get_object_value(root, 9);   /* 重复key保留，查找返回第一个 */
+  TEST_SIZE_T(2, cjson_tape_get_object_size(e));
+  TEST_SIZE_T(0, cjson_tape_find_object_index(e, "k", 1));
+
+  /* 和树互相转换 */
+  cjson_value_init(&v);
+  cjson_value_init(&v2);
+  TEST_INT(CJSON_OK, cjson_parse(&v, json));
+  cjson_tape_to_value(root, &v2);
+  s1 = cjson_stringify(v, &l1);
+  s2 = cjson_stringify(v2, &l2);
+  TEST_SIZE_T(l1, l2);
+  TEST_TRUE(memcmp(s1, s2, l1) == 0);
+  cjson_free(s2);
+  tape2 = cjson_tape_from_value(&v);
+  cjson_tape_to_value(cjson_tape_root(tape2), &v2);
+  s2 = cjson_stringify(v2, &l2);
+  TEST_SIZE_T(l1, l2);
+  TEST_TRUE(memcmp(s1, s2, l1) == 0);
+  cjson_free(s2);
+  cjson_tape_to_value(a, &v2);   /* 子树 */
+  TEST_SIZE_T(4, cjson_get_array_size(v2));
+  cjson_free(s1);
+  cjson_tape_free(tape2);
+  cjson_tape_free(tape);
+
+  /* 成员较多的对象转换后有索引 */
+  cjson_value_free(&v);
+  cjson_init_object(&v, 0);
+  for (i = 0; i < 40; i++) {
+    char key[8];
+    sprintf(key, "k%zu", i);
+    cjson_set_int64(cjson_set_object_value(&v, key, strlen(key)), (int64_t)i);
+  }
+  tape = cjson_tape_from_value(&v);
+  root = cjson_tape_root(tape);
+  TEST_SIZE_T(40, cjson_tape_get_object_size(root));
+  TEST_SIZE_T(33, cjson_tape_find_object_index(root, "k33", 3));
+  cjson_tape_to_value(root, &v2);
+  TEST_TRUE(cjson_is_equal(&v, &v2));
+  TEST_INT64(17, cjson_get_int64(*cjson_find_object_value(v2, "k17", 3)));
+  cjson_tape_free(tape);
+  cjson_value_free(&v);
+  cjson_value_free(&v2);
+
+  /* 标量根、错误和深层嵌套 */
+  TEST_INT(CJSON_OK, cjson_tape_parse(&tape, " \"s\" ", 5));
+  TEST_STRING("s", cjson_tape_get_string(cjson_tape_root(tape)), 1);
+  cjson_tape_free(tape);
+  TEST_INT(CJSON_ERR_OBJECT_NEED_COLON, cjson_tape_parse(&tape, "[{\"a\" 1}]", 9));
+  TEST_TRUE(tape == NULL);
+  TEST_INT(CJSON_ERR_ROOT_NOT_SINGULAR, cjson_tape_parse(&tape, "[] 1", 4));
+  TEST_TRUE(tape == NULL);
+  s1 = make_nested(1024, "[{\"k\":", "1", "}]");
+  TEST_INT(CJSON_ERR_DEPTH, cjson_tape_parse(&tape, s1, strlen(s1)));
+  free(s1);
+  s1 = make_nested(512, "[{\"k\":", "1", "}]");
+  TEST_INT(CJSON_OK, cjson_tape_parse(&tape, s1, strlen(s1)));
+  cjson_tape_to_value(cjson_tape_root(tape), &v);
+  s2 = cjson_stringify(v, &l2);
+  TEST_SIZE_T(strlen(s1), l2);
+  TEST_TRUE(memcmp(s1, s2, l2) == 0);
+  cjson_free(s2);
+  cjson_value_free(&v);
+  cjson_tape_free(tape);
+  free(s1);
+}
+
+static void test_arena() {
+  cjson_arena *arena = cjson_arena_create(64);   /* 小块，测试跨块和大块分配 */
+  cjson_value v, v2, *pv;
+  const char json[] = "{\"n\":null,\"s\":\"a long string that does not fit into one arena block ......\",\"a\":[1,2,[3,\"x\"]]}";
+  size_t i;
+
+  for (i = 0; i < 2; i++) {
+    cjson_value_init(&v);
+    TEST_INT(CJSON_OK, cjson_arena_parse(arena, &v, json, sizeof(json) - 1));
+    TEST_INT(CJSON_OBJECT, cjson_get_type(v));
+    TEST_TRUE(v.flags & CJSON_FLAG_ARENA);
+    TEST_SIZE_T(3, cjson_get_object_size(v));
+    pv = cjson_find_object_value(v, "a", 1);
+    TEST_TRUE(pv != NULL);
+    TEST_SIZE_T(3, cjson_get_array_size(*pv));
+    TEST_STRING("x", cjson_get_string(*cjson_get_array_element(*cjson_get_array_element(*pv, 2), 1)), 1);
+
+    cjson_value_init(&v2);
+    cjson_parse(&v2, json);
+    TEST_TRUE(cjson_is_equal(&v, &v2));
+    cjson_value_free(&v2);
+
+    /* 从arena复制到堆，再从堆复制回arena */
+    cjson_value_init(&v2);
+    cjson_copy(&v2, &v);
+    TEST_FALSE(v2.flags & CJSON_FLAG_ARENA);
+    TEST_TRUE(cjson_is_equal(&v, &v2));
+    cjson_arena_copy(arena, &v, &v2);
+    TEST_TRUE(v.flags & CJSON_FLAG_ARENA);
+    TEST_TRUE(cjson_is_equal(&v, &v2));
+    cjson_value_free(&v2);
+
+    /* arena中的元素可以被替换为堆上的值 */
+    cjson_set_string(cjson_find_object_value(v, "n", 1), "heap", 4);
+    cjson_value_free(cjson_find_object_value(v, "n", 1));
+    cjson_arena_set_string(arena, cjson_find_object_value(v, "n", 1), "arena", 5);
+    TEST_STRING("arena", cjson_get_string(*cjson_find_object_value(v, "n", 1)), 5);
+
+    cjson_value_free(&v);   /* 不释放内存 */
+    TEST_INT(CJSON_NULL, cjson_get_type(v));
+    cjson_arena_reset(arena);
+  }
+
+  cjson_value_init(&v);
+  TEST_INT(CJSON_ERR_OBJECT_NEED_COMMA_OR_SQUARE_BRACKET, cjson_arena_parse(arena, &v, "{\"a\":[\"b\"]", 11));
+  TEST_INT(CJSON_NULL, cjson_get_type(v));
+  TEST_FALSE(v.flags & CJSON_FLAG_ARENA);
+  cjson_arena_destroy(arena);
+}
+
+#define TEST_ALLOC_REPORT(name, before, st) \
+  printf("  %-10s malloc: %zu, realloc: %zu, free: %zu\n", name, \
+         (st).malloc_count - (before).malloc_count, (st).realloc_count - (before).realloc_count, (st).free_count - (before).free_count)
+
+static void test_allocator_count() {
+  const char json[] = "{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2,\"3\":3}}";
+  test_alloc_stats local = {0}, before;
+  cjson_allocator a = { test_malloc, test_realloc, test_free, &local };
+  cjson_value v, v2;
+  size_t global_live = global_alloc_stats.live, len;
+  char *s;
+
+  printf("\n===================== allocations =====================\n");
+
+  /* 每个操作的分配次数，以及分配和释放是否配对 */
+  cjson_value_init(&v);
+  before = global_alloc_stats;
+  TEST_INT(CJSON_OK, cjson_parse(&v, json));
+  TEST_ALLOC_REPORT("parse", before, global_alloc_stats);
+  TEST_SIZE_T(global_live + 14, global_alloc_stats.live);   /* 根对象成员块、7个key、1个字符串、数组元素块、子对象成员块和3个key */
+
+  cjson_value_init(&v2);
+  before = global_alloc_stats;
+  cjson_copy(&v2, &v);
+  TEST_ALLOC_REPORT("copy", before, global_alloc_stats);
+  TEST_SIZE_T(global_live + 28, global_alloc_stats.live);
+
+  before = global_alloc_stats;
+  s = cjson_stringify(v, &len);
+  TEST_ALLOC_REPORT("stringify", before, global_alloc_stats);
+  TEST_STRING(json, s, len);
+  cjson_free(s);
+
+  before = global_alloc_stats;
+  cjson_value_free(&v);
+  cjson_value_free(&v2);
+  TEST_ALLOC_REPORT("free", before, global_alloc_stats);
+  TEST_SIZE_T(global_live, global_alloc_stats.live);
+
+  /* 解析出错的时候不能泄漏 */
+  TEST_INT(CJSON_ERR_LITERAL, cjson_parse(&v, "{\"a\":[\"b\",{\"c\":nul}]}"));
+  TEST_INT(CJSON_ERR_ROOT_NOT_SINGULAR, cjson_parse(&v, "[\"a\"] x"));
+  TEST_INT(CJSON_ERR_OBJECT_NEED_COLON, cjson_parse(&v, "{\"a\":\"b\",\"c\"}"));
+  TEST_SIZE_T(global_live, global_alloc_stats.live);
+
+  /* 单独指定的分配器，不经过全局分配器 */
+  before = global_alloc_stats;
+  TEST_INT(CJSON_OK, cjson_parse_with_allocator(&a, &v, json, sizeof(json) - 1));
+  cjson_copy_with_allocator(&a, &v2, &v);
+  s = cjson_stringify_with_allocator(&a, v2, &len);
+  TEST_STRING(json, s, len);
+  TEST_SIZE_T(29, local.live);
+  a.free_fn(a.ud, s);
+  cjson_value_free_with_allocator(&a, &v);
+  cjson_value_free_with_allocator(&a, &v2);
+  TEST_SIZE_T(0, local.live);
+  TEST_SIZE_T(0, local.live_bytes);
+  TEST_SIZE_T(before.malloc_count, global_alloc_stats.malloc_count);
+
+  printf("=======================================================\n");
+}
+
+typedef struct {
+  char log[256];  /* 事件记录 */
+  size_t len;
+  int abort_at;   /* 第几个事件返回0，0表示不中止 */
+  int count;
+} test_sax_state;
+
+static int test_sax_event(test_sax_state *st, const char *ev, const char *str, size_t len) {
+  st->len += sprintf(st->log + st->len, "%s", ev);
+  if (str) {
+    memcpy(st->log + st->len, str, len);
+    st->len += len;
+    st->log[st->len++] = ')';
+  }
+  st->log[st->len++] = ' ';
+  st->log[st->len] = '\0';
+  return ++st->count != st->abort_at;
+}
+
+static int test_sax_null(void *ud) { return test_sax_event((test_sax_state *)ud, "n", NULL, 0); }
+static int test_sax_boolean(void *ud, int b) { return test_sax_event((test_sax_state *)ud, b ? "t" : "f", NULL, 0); }
+static int test_sax_number(void *ud, const cjson_value *num) {
+  char buf[32];
+  if (cjson_is_integer(*num))
+    sprintf(buf, "i%lld", (long long)cjson_get_int64(*num));
+  else
+    sprintf(buf, "d%g", cjson_get_number(*num));
+  return test_sax_event((test_sax_state *)ud, buf, NULL, 0);
+}
+static int test_sax_string(void *ud, const char *str, size_t len) { return test_sax_event((test_sax_state *)ud, "s(", str, len); }
+static int test_sax_key(void *ud, const char *key, size_t len) { return test_sax_event((test_sax_state *)ud, "k(", key, len); }
+static int test_sax_start_object(void *ud) { return test_sax_event((test_sax_state *)ud, "{", NULL, 0); }
+static int test_sax_end_object(void *ud, size_t size) {
+  char buf[32];
+  sprintf(buf, "}%zu", size);
+  return test_sax_event((test_sax_state *)ud, buf, NULL, 0);
+}
+static int test_sax_start_array(void *ud) { return test_sax_event((test_sax_state *)ud, "[", NULL, 0); }
+static int test_sax_end_array(void *ud, size_t size) {
+  char buf[32];
+  sprintf(buf, "]%zu", size);
+  return test_sax_event((test_sax_state *)ud, buf, NULL, 0);
+}
+
+#define TEST_SAX(expect_log, json) \
+  do {\
+    test_sax_state st = {{0}, 0, 0, 0};\
+    cjson_handler h = { test_sax_null, test_sax_boolean, test_sax_number, test_sax_string, test_sax_key,\
+                        test_sax_start_object, test_sax_end_object, test_sax_start_array, test_sax_end_array, &st };\
+    TEST_INT(CJSON_OK, cjson_sax_parse(&h, json, strlen(json)));\
+    TEST_STRING(expect_log, st.log, st.len);\
+  } while(0)
+
+#define TEST_SAX_ERROR(json) \
+  do {\
+    cjson_value v;\
+    cjson_handler h = {0};\
+    cjson_value_init(&v);\
+    TEST_INT(cjson_parse(&v, json), cjson_sax_parse(&h, json, strlen(json)));\
+    cjson_value_free(&v);\
+  } while(0)
+
+static void test_sax() {
+  test_sax_state st = {{0}, 0, 2, 0};
+  cjson_handler h = { test_sax_null, test_sax_boolean, test_sax_number, test_sax_string, test_sax_key,
+                      test_sax_start_object, test_sax_end_object, test_sax_start_array, test_sax_end_array, &st };
+  cjson_handler empty = {0};
+  cjson_parser *parser;
+  test_alloc_stats before;
+  const char json[] = "{\"a\":[1,2.5,\"x\"],\"b\":{\"c\":null}}";
+
+  TEST_SAX("n ", "null");
+  TEST_SAX("i-12 ", " -12 ");
+  TEST_SAX("s(a\nb) ", "\"a\\nb\"");
+  TEST_SAX("[ ]0 ", "[]");
+  TEST_SAX("{ }0 ", "{}");
+  TEST_SAX("[ t f d0.5 ]3 ", "[true,false,0.5]");
+  TEST_SAX("{ k(a) [ i1 d2.5 s(x) ]3 k(b) { k(c) n }1 }2 ", json);
+
+  /* 错误码和cjson_parse()一致 */
+  TEST_SAX_ERROR("");
+  TEST_SAX_ERROR("nul");
+  TEST_SAX_ERROR("[1,]");
+  TEST_SAX_ERROR("[1 2]");
+  TEST_SAX_ERROR("{\"a\" 1}");
+  TEST_SAX_ERROR("{\"a\":1,}");
+  TEST_SAX_ERROR("{1:2}");
+  TEST_SAX_ERROR("\"\\uD800\"");
+  TEST_SAX_ERROR("1e309");
+  TEST_SAX_ERROR("[1] x");
+
+  /* 回调返回0时中止 */
+  TEST_INT(CJSON_ERR_SAX_ABORT, cjson_sax_parse(&h, json, strlen(json)));
+  TEST_STRING("{ k(a) ", st.log, st.len);
+
+  /* 复用parser时不申请内存 */
+  parser = cjson_parser_create(0);
+  TEST_INT(CJSON_OK, cjson_parser_sax(parser, &empty, json, strlen(json)));
+  before = global_alloc_stats;
+  TEST_INT(CJSON_OK, cjson_parser_sax(parser, &empty, json, strlen(json)));
+  TEST_SIZE_T(before.malloc_count, global_alloc_stats.malloc_count);
+  TEST_SIZE_T(before.realloc_count, global_alloc_stats.realloc_count);
+  cjson_parser_destroy(parser);
+}
+
+typedef struct {
+  char buf[65536];
+  size_t len, calls, max_chunk;
+  int fail;   /* 为1时写出失败 */
+} test_sink_state;
+
+static int test_sink(void *ud, const char *data, size_t len) {
+  test_sink_state *st = (test_sink_state *)ud;
+  if (st->fail || st->len + len >= sizeof(st->buf))
+    return 0;
+  memcpy(st->buf + st->len, data, len);
+  st->len += len;
+  st->buf[st->len] = '\0';
+  st->calls++;
+  if (len > st->max_chunk)
+    st->max_chunk = len;
+  return 1;
+}
+
+static void test_writer() {
+  static test_sink_state st;
+  static char json[16384];
+  const char expect[] = "{\"a\":[1,-2,2.5,\"x\\n\",null,true,false],\"b\":{},\"c\":[[]],\"u\":18446744073709551615,\"v\":{\"k\":[1,2]}}";
+  cjson_writer *w;
+  cjson_value v;
+  char *s;
+  size_t len, i;
+
+  /* 整棵树写到sink，结果和cjson_stringify()相同，每次写出不超过缓冲区大小 */
+  len = (size_t)sprintf(json, "{\"long\":\"");
+  for (i = 0; i < 5000; i++)
+    json[len++] = i % 100 == 0 ? '\n' : 'a' + i % 26;
+  sprintf(json + len, "\",\"arr\":[1,2.5,-3,\"\\u0001\",{\"k\":null}]}");
+  for (i = 0; json[i]; i++)
+    if (json[i] == '\n') json[i] = 'N';
+  cjson_value_init(&v);
+  TEST_INT(CJSON_OK, cjson_parse(&v, json));
+  s = cjson_stringify(v, &len);
+  memset(&st, 0, sizeof(st));
+  TEST_INT(CJSON_OK, cjson_stringify_to_sink(&v, test_sink, &st));
+  TEST_SIZE_T(len, st.len);
+  TEST_TRUE(memcmp(s, st.buf, len) == 0);
+
+  memset(&st, 0, sizeof(st));
+  w = cjson_writer_create(test_sink, &st, 64);
+  TEST_INT(CJSON_OK, cjson_writer_value(w, &v));
+  TEST_INT(CJSON_OK, cjson_writer_flush(w));
+  cjson_writer_destroy(w);
+  TEST_SIZE_T(len, st.len);
+  TEST_TRUE(memcmp(s, st.buf, len) == 0);
+  TEST_TRUE(st.calls > 1);
+  TEST_TRUE(st.max_chunk <= 64);
+  cjson_free(s);
+
+  /* 写出失败 */
+  memset(&st, 0, sizeof(st));
+  st.fail = 1;
+  TEST_INT(CJSON_ERR_SINK, cjson_stringify_to_sink(&v, test_sink, &st));
+  cjson_value_free(&v);
+
+  /* 事件写出，不构造cjson_value */
+  memset(&st, 0, sizeof(st));
+  w = cjson_writer_create(test_sink, &st, 0);
+  cjson_writer_start_object(w);
+  cjson_writer_key(w, "a", 1);
+  cjson_writer_start_array(w);
+  cjson_writer_int64(w, 1);
+  cjson_writer_int64(w, -2);
+  cjson_writer_number(w, 2.5);
+  cjson_writer_string(w, "x\n", 2);
+  cjson_writer_null(w);
+  cjson_writer_boolean(w, 1);
+  cjson_writer_boolean(w, 0);
+  cjson_writer_end_array(w);
+  cjson_writer_key(w, "b", 1);
+  cjson_writer_start_object(w);
+  cjson_writer_end_object(w);
+  cjson_writer_key(w, "c", 1);
+  cjson_writer_start_array(w);
+  cjson_writer_start_array(w);
+  cjson_writer_end_array(w);
+  cjson_writer_end_array(w);
+  cjson_writer_key(w, "u", 1);
+  cjson_writer_uint64(w, UINT64_MAX);
+  cjson_writer_key(w, "v", 1);
+  cjson_value_init(&v);
+  TEST_INT(CJSON_OK, cjson_parse(&v, "{\"k\":[1,2]}"));
+  cjson_writer_value(w, &v);
+  cjson_value_free(&v);
+  TEST_INT(CJSON_OK, cjson_writer_end_object(w));
+  TEST_SIZE_T(0, st.len);   /* 还在缓冲区中 */
+  TEST_INT(CJSON_OK, cjson_writer_flush(w));
+  TEST_STRING(expect, st.buf, st.len);
+
+  /* 根层的多个值以换行分隔 */
+  st.len = 0;
+  cjson_writer_int64(w, 1);
+  cjson_writer_start_array(w);
+  cjson_writer_end_array(w);
+  cjson_writer_flush(w);
+  TEST_STRING("\n1\n[]", st.buf, st.len);
+  cjson_writer_destroy(w);
+}
+
+static void test_stream_split(cjson_stream *st, const char *json, size_t split, size_t step) {  /* 先传入前split字节，剩下的每次step字节 */
+  cjson_value expect, v;
+  CJSON_STATUS ret;
+  size_t len = strlen(json), i;
+
+  cjson_value_init(&expect);
+  ret = cjson_parse_n(&expect, json, len);
+  cjson_stream_feed(st, json, split);
+  for (i = split; i < len; i += step)
+    cjson_stream_feed(st, json + i, len - i < step ? len - i : step);
+  TEST_INT(ret, cjson_stream_finish(st, &v));
+  if (ret == CJSON_OK)
+    TEST_TRUE(cjson_is_equal(&expect, &v));
+  else
+    TEST_INT(CJSON_NULL, cjson_get_type(v));
+  cjson_value_free(&expect);
+  cjson_value_free(&v);
+}
+
+#define TEST_STREAM(json) \
+  do {\
+    cjson_stream *st = cjson_stream_create();\
+    size_t split;\
+    for (split = 0; split <= strlen(json); split++)\
+      test_stream_split(st, json, split, strlen(json) + 1);\
+    test_stream_split(st, json, 0, 1);\
+    cjson_stream_destroy(st);\
+  } while(0)
+
+static void test_stream() {
+  cjson_stream *st;
+  cjson_value v;
+
+  /* 在每个位置切分，结果和cjson_parse()相同 */
+  TEST_STREAM("null");
+  TEST_STREAM(" false ");
+  TEST_STREAM("-1.25e+10");
+  TEST_STREAM("18446744073709551615");
+  TEST_STREAM("\"Hello\\nWorld \\u00e9 \\uD834\\uDD1E\"");
+  TEST_STREAM("[null,false,true,123,\"abc\",[1,2,3],{}]");
+  TEST_STREAM("{ \"n\" : null , \"a\" : [ 1, 2, -3.5 ] , \"o\" : { \"\" : \"\" } }");
+
+  /* 错误码也相同 */
+  TEST_STREAM("");
+  TEST_STREAM("nul");
+  TEST_STREAM("0123");
+  TEST_STREAM("1e309");
+  TEST_STREAM("1.");
+  TEST_STREAM("[1,]");
+  TEST_STREAM("[1 2]");
+  TEST_STREAM("[1");
+  TEST_STREAM("{\"a\":1,}");
+  TEST_STREAM("{\"a\" 1}");
+  TEST_STREAM("{\"a\":1");
+  TEST_STREAM("\"abc");
+  TEST_STREAM("\"\\v\"");
+  TEST_STREAM("\"\x01\"");
+  TEST_STREAM("\"\\u12\"");
+  TEST_STREAM("\"\\uD800\"");
+  TEST_STREAM("\"\\uD800\\u0041\"");
+  TEST_STREAM("null x");
+
+  /* 出错之后一直返回同一个错误，finish之后可以解析下一个文档 */
+  st = cjson_stream_create();
+  TEST_INT(CJSON_OK, cjson_stream_feed(st, "[1,", 3));
+  TEST_INT(CJSON_ERR_LITERAL, cjson_stream_feed(st, "]", 1));
+  TEST_INT(CJSON_ERR_LITERAL, cjson_stream_feed(st, "2]", 2));
+  TEST_INT(CJSON_ERR_LITERAL, cjson_stream_finish(st, &v));
+  TEST_INT(CJSON_OK, cjson_stream_feed(st, "[\"a", 3));
+  TEST_INT(CJSON_OK, cjson_stream_feed(st, "b\"]", 3));
+  TEST_INT(CJSON_OK, cjson_stream_finish(st, &v));
+  TEST_SIZE_T(1, cjson_get_array_size(v));
+  TEST_STRING("ab", cjson_get_string(*cjson_get_array_element(v, 0)), cjson_get_string_length(*cjson_get_array_element(v, 0)));
+  cjson_value_free(&v);
+
+  /* reset丢弃解析了一半的文档 */
+  TEST_INT(CJSON_OK, cjson_stream_feed(st, "{\"a\":[{\"b\":\"xyz", 15));
+  cjson_stream_reset(st);
+  TEST_INT(CJSON_OK, cjson_stream_feed(st, "1", 1));
+  TEST_INT(CJSON_OK, cjson_stream_finish(st, &v));
+  TEST_DOUBLE(1.0, cjson_get_number(v));
+  cjson_stream_destroy(st);
+}
+
+static void test_depth() {
+  static const cjson_handler empty_handler = { 0 };
+  cjson_parser *parser = cjson_parser_create(0);
+  cjson_stream *st = cjson_stream_create();
+  cjson_value v, v2, *e;
+  char *json, *out;
+  size_t i, len;
+
+  /* 默认最多1024层 */
+  json = make_nested(1024, "[", "1", "]");
+  cjson_value_init(&v);
+  TEST_INT(CJSON_OK, cjson_parse(&v, json));
+  TEST_INT(CJSON_OK, cjson_sax_parse(&empty_handler, json, strlen(json)));
+  TEST_INT(CJSON_OK, cjson_stream_feed(st, json, strlen(json)));
+  TEST_INT(CJSON_OK, cjson_stream_finish(st, &v2));
+  TEST_TRUE(cjson_is_equal(&v, &v2));
+  cjson_value_free(&v);
+  cjson_value_free(&v2);
+  free(json);
+
+  json = make_nested(1025, "[", "1", "]");
+  TEST_INT(CJSON_ERR_DEPTH, cjson_parse(&v, json));
+  TEST_INT(CJSON_NULL, cjson_get_type(v));
+  TEST_INT(CJSON_ERR_DEPTH, cjson_sax_parse(&empty_handler, json, strlen(json)));
+  TEST_INT(CJSON_ERR_DEPTH, cjson_stream_feed(st, json, strlen(json)));
+  cjson_stream_reset(st);
+  free(json);
+
+  json = make_nested(1025, "{\"a\":", "{}", "}");
+  TEST_INT(CJSON_ERR_DEPTH, cjson_parse(&v, json));
+  free(json);
+  json = make_nested(1022, "[{\"k\":\"v\"},", "{\"a\":[]}", "]");
+  TEST_INT(CJSON_OK, cjson_parse(&v, json));
+  cjson_value_free(&v);
+  free(json);
+  json = make_nested(2000, "[1,{\"k\":\"v\",\"a\":", "", "}]");  /* 出错时释放已经解析的部分 */
+  TEST_INT(CJSON_ERR_DEPTH, cjson_parse(&v, json));
+  free(json);
+
+  /* parser可以设置层数 */
+  cjson_parser_set_max_depth(parser, 3);
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, "[{\"a\":[]}]", 10));
+  cjson_value_free(&v);
+  TEST_INT(CJSON_ERR_DEPTH, cjson_parser_parse(parser, &v, "[{\"a\":[[]]}]", 12));
+  TEST_INT(CJSON_ERR_DEPTH, cjson_parser_sax(parser, &empty_handler, "[[[[]]]]", 8));
+  TEST_INT(CJSON_OK, cjson_parser_sax(parser, &empty_handler, "[[[]]]", 6));
+
+  /* 不递归，很深的树也能解析、生成、复制、比较和释放 */
+  cjson_parser_set_max_depth(parser, 200000);
+  json = make_nested(100000, "[{\"a\":", "\"x\"", "}]");
+  len = strlen(json);
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, json, len));
+  out = cjson_stringify(v, &i);
+  TEST_SIZE_T(len, i);
+  TEST_TRUE(memcmp(json, out, len) == 0);
+  cjson_free(out);
+  cjson_value_init(&v2);
+  cjson_copy(&v2, &v);
+  TEST_TRUE(cjson_is_equal(&v, &v2));
+  TEST_SIZE_T(cjson_hash(&v), cjson_hash(&v2));
+  e = &v2;
+  while (cjson_get_type(*e) != CJSON_STRING)
+    e = cjson_get_type(*e) == CJSON_ARRAY ? cjson_get_array_element(*e, 0) : cjson_get_object_value(*e, 0);
+  cjson_set_string(e, "y", 1);
+  TEST_FALSE(cjson_is_equal(&v, &v2));
+  TEST_TRUE(cjson_hash(&v) != cjson_hash(&v2));
+  cjson_value_free(&v2);
+  TEST_INT(CJSON_OK, cjson_parser_sax(parser, &empty_handler, json, len));
+  cjson_value_free(&v);
+  free(json);
+
+  cjson_parser_set_max_depth(parser, 0);  /* 恢复默认值 */
+  json = make_nested(1025, "[", "", "]");
+  TEST_INT(CJSON_ERR_DEPTH, cjson_parser_parse(parser, &v, json, strlen(json)));
+  free(json);
+
+  /* 用接口构造的树没有层数限制 */
+  cjson_value_init(&v);
+  e = &v;
+  for (i = 0; i < 100000; i++) {
+    cjson_init_array(e, 1);
+    e = cjson_pushback_array_element(e);
+  }
+  cjson_set_number(e, 1.5);
+  {
+    cjson_stringify_options opt = { 0, 0, 1, 0 };
+    out = cjson_stringify_ex(v, &opt, &len);
+    TEST_SIZE_T(100000 * 2 + 3, len);
+    cjson_free(out);
+  }
+  cjson_value_free(&v);
+
+  cjson_stream_destroy(st);
+  cjson_parser_destroy(parser);
+}
+
+static void test_parser() {
+  cjson_parser *parser = cjson_parser_create(0);
+  cjson_arena *arena = cjson_arena_create(0);
+  test_alloc_stats before;
+  cjson_value v;
+  char big[2048 + 3];
+  const char *s;
+  size_t i, len;
+
+  /* 栈重复使用，解析只为节点分配内存，序列化不分配内存 */
+  cjson_value_init(&v);
+  for (i = 0; i < 3; i++) {
+    before = global_alloc_stats;
+    TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, "[1,2,3]", 7));
+    TEST_SIZE_T(1, global_alloc_stats.malloc_count - before.malloc_count);
+    TEST_SIZE_T(0, global_alloc_stats.realloc_count - before.realloc_count);
+    TEST_SIZE_T(0, global_alloc_stats.free_count - before.free_count);
+
+    before = global_alloc_stats;
+    s = cjson_parser_stringify(parser, &v, &len);
+    TEST_STRING("[1,2,3]", s, len);
+    TEST_SIZE_T(0, global_alloc_stats.malloc_count - before.malloc_count);
+    TEST_SIZE_T(0, global_alloc_stats.realloc_count - before.realloc_count);
+    cjson_value_free(&v);
+  }
+  TEST_INT(CJSON_ERR_LITERAL, cjson_parser_parse(parser, &v, "[1,x]", 5));
+  TEST_INT(CJSON_NULL, cjson_get_type(v));
+
+  /* 大文档让栈扩容，超过高水位之后收缩回初始大小 */
+  big[0] = '\"';
+  memset(big + 1, 'a', sizeof(big) - 3);
+  big[sizeof(big) - 2] = '\"';
+  big[sizeof(big) - 1] = '\0';
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, big, sizeof(big) - 1));
+  TEST_TRUE(cjson_parser_get_stack_size(parser) > 2048);
+  cjson_value_free(&v);
+  cjson_parser_reset(parser);
+  TEST_SIZE_T(256, cjson_parser_get_stack_size(parser));
+
+  cjson_parser_set_trim(parser, 1024);
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, big, sizeof(big) - 1));
+  TEST_SIZE_T(2048, cjson_get_string_length(v));
+  TEST_SIZE_T(256, cjson_parser_get_stack_size(parser));
+  s = cjson_parser_stringify(parser, &v, &len);
+  TEST_SIZE_T(sizeof(big) - 1, len);
+  TEST_TRUE(memcmp(big, s, len) == 0);
+  TEST_TRUE(cjson_parser_get_stack_size(parser) > 2048);   /* 结果还在栈中，下一次调用时才收缩 */
+  cjson_value_free(&v);
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, "null", 4));
+  TEST_SIZE_T(256, cjson_parser_get_stack_size(parser));
+
+  /* 配合arena使用 */
+  cjson_parser_set_arena(parser, arena);
+  TEST_INT(CJSON_OK, cjson_parser_parse(parser, &v, "{\"a\":[\"b\"]}", 11));
+  TEST_TRUE(v.flags & CJSON_FLAG_ARENA);
+  TEST_STRING("b", cjson_get_string(*cjson_get_array_element(*cjson_find_object_value(v, "a", 1), 0)), 1);
+  cjson_parser_set_arena(parser, NULL);
+
+  cjson_arena_destroy(arena);
+  cjson_parser_destroy(parser);
+}
+
 static void test_access() {
     test_access_null();
     test_access_boolean();
     test_access_number();
+    test_access_int64();
     test_access_string();
     test_access_array();
     test_access_object();
+    test_object_index();
 }
 
 
+#ifdef CJSON_NDJSON
+typedef struct {
+  size_t count, next, abort_after;
+  int in_order, ok;
+  const char *data;
+  unsigned char *seen;
+} ndjson_check;
+
+static int ndjson_callback(void *ud, cjson_ndjson_record *record) {
+  ndjson_check *check = (ndjson_check *)ud;
+  size_t i;
+  /* 第i条记录是{"i":i,"s":"..."}，在输入中以"{\"i\":"开头 */
+  if (record->status != CJSON_OK || cjson_get_type(record->value) != CJSON_OBJECT
+      || memcmp(check->data + record->offset, "{\"i\":", 5) != 0 || check->data[record->offset + record->length] != '\n') {
+    check->ok = 0;
+    return 1;
+  }
+  i = (size_t)cjson_get_number(*cjson_get_object_value(record->value, 0));
+  if (check->seen[i]++ != 0)
+    check->ok = 0;
+  if (check->in_order) {  /* 多线程无序回调时只写seen[i]，不同的记录互不干扰 */
+    if (i != check->next)
+      check->ok = 0;
+    check->next = i + 1;
+    check->count++;
+  }
+  return i + 1 != check->abort_after;
+}
+
+static int ndjson_collect(void *ud, cjson_ndjson_record *record) {   /* 单线程，按顺序记下状态和位置 */
+  size_t *out = (size_t *)ud;
+  out[1 + 3 * out[0]] = record->status;
+  out[2 + 3 * out[0]] = record->offset;
+  out[3 + 3 * out[0]] = record->length;
+  out[0]++;
+  return 1;
+}
+
+static void test_ndjson_run(const char *data, size_t len, size_t n, size_t threads, size_t chunk_size, int ordered) {
+  cjson_ndjson_options opt = { threads, chunk_size, ordered };
+  ndjson_check check = { 0, 0, 0, ordered || threads == 1, 1, data, NULL };
+  size_t i, seen = 0;
+
+  check.seen = (unsigned char *)calloc(n, 1);
+  TEST_INT(CJSON_OK, cjson_ndjson_parse(data, len, &opt, ndjson_callback, &check));
+  TEST_TRUE(check.ok);
+  for (i = 0; i < n; i++)
+    seen += check.seen[i];
+  TEST_SIZE_T(n, seen);
+
+  if (check.in_order)
+    TEST_SIZE_T(n, check.count);
+
+  /* 第n/3条记录的回调返回0，中止解析；有序时正好回调n/3条 */
+  memset(check.seen, 0, n);
+  check.count = check.next = 0;
+  check.abort_after = n / 3;
+  TEST_INT(CJSON_ERR_SAX_ABORT, cjson_ndjson_parse(data, len, &opt, ndjson_callback, &check));
+  TEST_TRUE(check.seen[n / 3 - 1]);
+  if (check.in_order)
+    TEST_SIZE_T(n / 3, check.count);
+  free(check.seen);
+}
+
+static void test_ndjson() {
+  const size_t n = 5000;
+  size_t len = 0, i, out[1 + 3 * 8];
+  char *data = (char *)malloc(n * 64);
+  FILE *f;
+
+  for (i = 0; i < n; i++)
+    len += sprintf(data + len, "{\"i\":%zu,\"s\":\"%.*s\",\"a\":[%zu,true,null]}\n", i, (int)(i % 17), "abcdefghijklmnopq", i * 7);
+
+  test_ndjson_run(data, len, n, 1, 0, 0);
+  test_ndjson_run(data, len, n, 1, 100, 1);
+  test_ndjson_run(data, len, n, 4, 100, 1);   /* 块很小，slot会被反复复用 */
+  test_ndjson_run(data, len, n, 4, 4096, 1);
+  test_ndjson_run(data, len, n, 4, 100, 0);
+  test_ndjson_run(data, len, n, 3, 1, 0);     /* 每一块只有一行 */
+  test_ndjson_run(data, len, n, 8, len * 2, 1);  /* 只有一块 */
+  test_ndjson_run(data, len, n, 0, 0, 1);
+
+  /* 空行、"\r\n"、最后一行没有换行符；出错的记录照样回调，不影响后面的记录 */
+  {
+    const char *json = "[1]\r\n\n  \t\n{\"a\" 1}\n\r\n\"x\"\n nul \n2";
+    cjson_ndjson_options opt = { 1, 0, 1 };
+    out[0] = 0;
+    TEST_INT(CJSON_OK, cjson_ndjson_parse(json, strlen(json), &opt, ndjson_collect, out));
+    TEST_SIZE_T(5, out[0]);
+    TEST_SIZE_T(CJSON_OK, out[1]);                       TEST_SIZE_T(0, out[2]);  TEST_SIZE_T(3, out[3]);
+    TEST_SIZE_T(CJSON_ERR_OBJECT_NEED_COLON, out[4]);    TEST_SIZE_T(10, out[5]); TEST_SIZE_T(7, out[6]);
+    TEST_SIZE_T(CJSON_OK, out[7]);                       TEST_SIZE_T(20, out[8]); TEST_SIZE_T(3, out[9]);
+    TEST_SIZE_T(CJSON_ERR_LITERAL, out[10]);             TEST_SIZE_T(24, out[11]); TEST_SIZE_T(5, out[12]);
+    TEST_SIZE_T(CJSON_OK, out[13]);                      TEST_SIZE_T(30, out[14]); TEST_SIZE_T(1, out[15]);
+
+    out[0] = 0;
+    TEST_INT(CJSON_OK, cjson_ndjson_parse("", 0, NULL, ndjson_collect, out));
+    TEST_INT(CJSON_OK, cjson_ndjson_parse("\n\n \n", 4, NULL, ndjson_collect, out));
+    TEST_SIZE_T(0, out[0]);
+  }
+
+  /* 从文件读取 */
+  f = fopen("cjson_ndjson_test.tmp", "wb");
+  TEST_TRUE(f != NULL);
+  if (f != NULL) {
+    cjson_ndjson_options opt = { 4, 1000, 1 };
+    ndjson_check check = { 0, 0, 0, 1, 1, data, NULL };
+    fwrite(data, 1, len, f);
+    fclose(f);
+    check.seen = (unsigned char *)calloc(n, 1);
+    TEST_INT(CJSON_OK, cjson_ndjson_parse_file("cjson_ndjson_test.tmp", &opt, ndjson_callback, &check));
+    TEST_TRUE(check.ok);
+    TEST_SIZE_T(n, check.count);
+    free(check.seen);
+
+    f = fopen("cjson_ndjson_test.tmp", "wb");
+    fclose(f);
+    out[0] = 0;
+    TEST_INT(CJSON_OK, cjson_ndjson_parse_file("cjson_ndjson_test.tmp", NULL, ndjson_collect, out));
+    TEST_SIZE_T(0, out[0]);
+    remove("cjson_ndjson_test.tmp");
+  }
+  TEST_INT(CJSON_ERR_IO, cjson_ndjson_parse_file("cjson_ndjson_test.tmp", NULL, ndjson_collect, out));
+  TEST_INT(CJSON_ERR_IO, cjson_ndjson_parse_file(".", NULL, ndjson_collect, out));
+  free(data);
+}
+#endif
+
 void main()
 {
+  cjson_set_allocator(&test_allocator);
+
   test_prase();
   test_stringify();
 
   test_equal();
+  test_equal_large_object();
+  test_hash();
   test_copy();
   test_move();
   test_swap();
 
   test_access();
+  test_pointer();
+  test_lazy();
+  test_tape();
+  test_arena();
+  test_parser();
+  test_sax();
+  test_writer();
+  test_stream();
+  test_depth();
+  test_allocator_count();
+
+  cjson_set_allocator(NULL);
+  TEST_SIZE_T(0, global_alloc_stats.live);      /* 所有测试结束后不能有泄漏 */
+  TEST_SIZE_T(0, global_alloc_stats.live_bytes);
+
+#ifdef CJSON_NDJSON
+  test_ndjson();    /* 解析线程同时使用全局分配器，计数分配器不是线程安全的，所以在恢复默认分配器之后测试 */
+#endif
 
   printf("\n===================== result =====================\n");
   printf("  test all %d, pass: %d\n", test_count, test_count_pass);